@@ -0,0 +1,96 @@
+/**
+ * @file alloc_failure.h
+ * @brief Forensics for failed heap allocations
+ *
+ * When malloc() returns NULL the wrapper hands the request to the monitor,
+ * which snapshots the heap and prints one event:
+ *
+ *   [ALLOCFAIL] kind=<OOM|FRAG> size=<n> pc=0x<caller> largest=<n> free=<n> gap=<n> seq=<n> tick=<n> [t=<cycles>]
+ *
+ * - size: bytes requested
+ * - pc: flash byte address of the malloc() caller (memsym --filter)
+ * - largest: largest request the heap could have served (free-list chunk
+ *   or the room above the heap end, see heap_walk.h)
+ * - free: all free heap, free list plus room above the heap end
+ * - gap: bytes between the heap end and SP
+ * - seq: allocations before this one (successful ones plus earlier failures)
+ * - tick: mem_monitor_update() calls so far, a timestamp in every build
+ * - t: Timer1 cycle count (only with MEM_MONITOR_ISR_PROFILE, which keeps
+ *   the 32-bit timebase running); 0, or only the low 16 bits, if the
+ *   failure comes before the profiler has started the timebase
+ *
+ * kind=OOM means the free heap as a whole is smaller than the request;
+ * kind=FRAG means there is enough in total but no single piece is big
+ * enough, so the fix is allocation order or lifetime, not more RAM.
+ *
+ * Failures are also counted per power-of-two size class;
+ * mem_monitor_print_alloc_failures() prints the histogram and the last
+ * event again. The count shows as fail=<n> on the [BUDGET] heap line.
+ */
+
+#ifndef ALLOC_FAILURE_H
+#define ALLOC_FAILURE_H
+
+#include <stdint.h>
+#include "memory_monitor.h"
+
+#if MEM_MONITOR_ALLOC_FORENSICS
+
+// Size classes: <=8, <=16, ... <=512, larger
+#define MEM_ALLOC_FAIL_CLASSES 8
+
+enum MemAllocFailKind {
+    MEM_ALLOC_FAIL_OOM,    // Not enough free heap in total
+    MEM_ALLOC_FAIL_FRAG    // Enough in total, no piece large enough
+};
+
+/**
+ * @brief Snapshot taken at a failed allocation
+ */
+struct MemAllocFailure {
+    uint8_t kind;        // MemAllocFailKind
+    uint16_t size;       // Bytes requested
+    uint16_t pc;         // Caller (flash byte address)
+    uint16_t largest;    // Largest request that would have succeeded
+    uint16_t total_free; // Free list plus room above the heap end
+    uint16_t gap;        // Heap end to SP
+    uint16_t seq;        // Allocations and failures before this one
+    uint16_t tick;       // mem_monitor_update() calls (always recorded)
+    uint32_t cycles;     // Timer1 cycles (0 without the 32-bit timebase)
+};
+
+/**
+ * @brief Failure counters
+ */
+struct MemAllocFailStats {
+    uint16_t count;                             // All failures
+    uint16_t oom;                               // kind=OOM
+    uint16_t frag;                              // kind=FRAG
+    uint16_t by_class[MEM_ALLOC_FAIL_CLASSES];  // Per size class
+    MemAllocFailure last;                       // Most recent (valid if count)
+};
+
+/**
+ * @brief Record and report a failed request (called by the malloc wrapper)
+ * @param size Bytes requested
+ * @param caller Flash byte address of the malloc() caller
+ */
+void mem_alloc_failure_record(uint16_t size, uint16_t caller);
+
+/**
+ * @brief Failure counters and the last snapshot
+ */
+const MemAllocFailStats* mem_monitor_get_alloc_failures(void);
+
+/**
+ * @brief Print the size-class histogram and the last failure
+ *
+ * Output format:
+ * [ALLOCFAIL] count=<n> oom=<n> frag=<n> classes=<=8:<n>,...,>512:<n>
+ * [ALLOCFAIL] kind=... (last failure, as above; only if count > 0)
+ */
+void mem_monitor_print_alloc_failures(void);
+
+#endif // MEM_MONITOR_ALLOC_FORENSICS
+
+#endif // ALLOC_FAILURE_H
@@ -0,0 +1,55 @@
+/**
+ * @file frag_blame.h
+ * @brief Find the live blocks that pin free heap holes
+ *
+ * A fragmentation figure does not say which block splits the heap. This
+ * report walks the heap chunks (heap_walk.h) and picks out every live
+ * block that sits directly between two free holes, or between a hole and
+ * the top of the heap. Freeing or moving such a block would merge its
+ * neighbours into one piece:
+ *
+ *   [BLAME] chunks=<n> holes=<n> largest=<n> pinned=<n>
+ *   [BLAME] ptr=0x<block> size=<n> release=<n> [pc=0x<caller>] [age=<n>]
+ *
+ * "release" is the largest request the merged space could serve, headers
+ * and, for a block next to the top, the room above the heap included.
+ * The MEM_FRAG_BLAME_TOP blocks with the largest release are listed,
+ * largest first; compare it with "largest" (what malloc() can serve now).
+ *
+ * With MEM_TRACK_TABLE the report adds the block's call site (needs
+ * MEM_MONITOR_CALLSITE_DEPTH and a sampled block) and its age, counted
+ * in allocations made since it (needs MEM_MONITOR_FRAG_BLAME).
+ *
+ * The walk is O(chunks) and reads the heap without locking: call it from
+ * main code, not while an ISR may allocate.
+ */
+
+#ifndef FRAG_BLAME_H
+#define FRAG_BLAME_H
+
+#include <stdint.h>
+#include "memory_monitor.h"
+
+/**
+ * @brief One pinning block
+ */
+struct MemFragBlame {
+    uint8_t* ptr;        // Block payload
+    uint16_t size;       // Payload bytes
+    uint16_t release;    // Largest request after freeing it
+};
+
+/**
+ * @brief Pinning blocks with the largest release, largest first
+ * @param out Array of at least max entries
+ * @param max Entries to return
+ * @return Number of pinning blocks found (may exceed max)
+ */
+uint8_t mem_heap_find_pinning(MemFragBlame* out, uint8_t max);
+
+/**
+ * @brief Print the [BLAME] report
+ */
+void mem_monitor_print_frag_blame(void);
+
+#endif // FRAG_BLAME_H
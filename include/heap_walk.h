@@ -0,0 +1,62 @@
+/**
+ * @file heap_walk.h
+ * @brief Read-only views of the avr-libc heap internals
+ *
+ * avr-libc keeps freed chunks on an address-ordered free list (__flp),
+ * each chunk starting with its usable size and the next pointer. A new
+ * chunk is taken from the list (best fit) or carved from the top, between
+ * __brkval and the allocator limit: __malloc_heap_end when set (see
+ * mem_monitor_stack_reserve()), otherwise SP - __malloc_margin.
+ *
+ * The walks only read allocator state. Call them from main code; an
+ * allocation in an ISR during a walk would change the list under it.
+ */
+
+#ifndef HEAP_WALK_H
+#define HEAP_WALK_H
+
+#include <stdint.h>
+
+/**
+ * @brief Free heap as malloc() sees it (payload bytes)
+ */
+struct MemHeapFree {
+    uint16_t largest;    // Largest request malloc() can satisfy right now
+    uint16_t total;      // Free-list payloads plus the room above __brkval
+    uint16_t top;        // Largest request the top of the heap can satisfy
+    uint8_t chunks;      // Free-list entries (saturating)
+};
+
+/**
+ * @brief Walk the free list and measure the room above the heap end
+ */
+void mem_heap_free_space(MemHeapFree* out);
+
+/**
+ * @brief One chunk between __heap_start and __brkval
+ */
+struct MemHeapChunk {
+    uint8_t* ptr;        // Payload (the pointer malloc() returned)
+    uint16_t size;       // Payload bytes; the chunk is size + 2 with its header
+    uint8_t free;        // On the free list
+};
+
+typedef void (*MemHeapChunkFn)(const MemHeapChunk* chunk, void* ctx);
+
+/**
+ * @brief Call fn for every chunk, lowest address first
+ * @param fn Callback, or NULL to only count chunks
+ * @return Number of chunks visited (saturating at 255)
+ *
+ * Chunks are contiguous: each one starts right after the previous one's
+ * payload. The walk stops early at a size that runs past __brkval, which
+ * means the heap is corrupted.
+ */
+uint8_t mem_heap_walk(MemHeapChunkFn fn, void* ctx);
+
+/**
+ * @brief Bytes above __brkval up to the allocator limit (headers included)
+ */
+uint16_t mem_heap_top_room(void);
+
+#endif // HEAP_WALK_H
@@ -0,0 +1,158 @@
+/**
+ * @file isr_profile.h
+ * @brief Opt-in ISR load profiler (invocation rate, cycle cost, nesting)
+ *
+ * Declare interrupt handlers with MEM_ISR instead of ISR:
+ *
+ *   MEM_ISR(TIMER2_COMPA_vect, 0) {
+ *       s_ticks++;
+ *   }
+ *   MEM_ISR(USART_RX_vect, 1, ISR_NOBLOCK) { ... }
+ *
+ * The second argument is a slot ID (0 .. MEM_ISR_PROFILE_SLOTS-1) unique to
+ * the handler; further arguments are passed on to ISR(). With
+ * MEM_MONITOR_ISR_PROFILE enabled each invocation is timed with the Timer1
+ * timebase. Per slot and reporting window the profiler keeps:
+ *
+ * - Invocation count (reported as a rate)
+ * - Min/avg/max exclusive cycles (time spent in nested ISRs is subtracted)
+ * - Invocations that interrupted another profiled ISR (ISR_NOBLOCK nesting)
+ * - Deepest stack use at entry (RAMEND - SP)
+ *
+ * Cycles are counted from the wrapper's entry to its exit. The vector jump,
+ * register save/restore and reti (roughly 20 - 60 cycles, depending on the
+ * registers the body uses) are not included. A single invocation must not
+ * run longer than 65535 cycles.
+ *
+ * With MEM_MONITOR_ISR_PROFILE at 0, MEM_ISR is plain ISR().
+ */
+
+#ifndef MEM_ISR_PROFILE_H
+#define MEM_ISR_PROFILE_H
+
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include "memory_monitor.h"
+
+#if MEM_MONITOR_ISR_PROFILE
+#include "mem_critical.h"
+#include "timebase.h"
+
+/**
+ * @brief Per-ISR statistics for the current reporting window
+ */
+struct IsrProfileStats {
+    uint16_t count;          // Invocations (saturates at 65535)
+    uint16_t nested;         // Invocations that interrupted a profiled ISR
+    uint16_t min_cycles;     // Shortest invocation (exclusive cycles)
+    uint16_t max_cycles;     // Longest invocation (exclusive cycles)
+    uint32_t total_cycles;   // Sum of exclusive cycles
+    uint16_t max_stack;      // Deepest stack use at entry (bytes)
+};
+
+/**
+ * @brief State carried from entry to exit of one invocation
+ */
+struct IsrProfileFrame {
+    uint16_t start;          // Timebase at entry
+    uint16_t outer_child;    // Enclosing invocation's nested-ISR cycles
+};
+
+extern IsrProfileStats mem_isr_stats[MEM_ISR_PROFILE_SLOTS];
+extern uint8_t mem_isr_depth;             // Profiled ISRs currently running
+extern uint16_t mem_isr_child_cycles;     // Nested-ISR cycles of the innermost one
+
+/**
+ * @brief Set the report name of a slot (called by MEM_ISR before main)
+ * @param slot Slot ID
+ * @param name Name in program memory
+ */
+void mem_isr_profile_register(uint8_t slot, const char* name);
+
+/**
+ * @brief Reset all slots and start a reporting window
+ *
+ * Called by mem_monitor_init(). Starts the timebase with overflow
+ * counting; rates need global interrupts enabled.
+ */
+void mem_isr_profile_init(void);
+
+/**
+ * @brief Print and reset the statistics of the current reporting window
+ *
+ * Output format (cycles at F_CPU, load in percent of the window):
+ * [ISR] window=<ms> ms
+ * [ISR] <name> n=<count> rate=<n/s> min=<c> avg=<c> max=<c> load=<x.x>% nest=<n> stack=<bytes>
+ */
+void mem_monitor_print_isr_profile(void);
+
+static inline __attribute__((always_inline))
+void mem_isr_profile_enter(uint8_t slot, IsrProfileFrame* frame) {
+    MEM_CRITICAL_ENTER(MEM_CS_ISR_PROFILE);
+    IsrProfileStats* s = &mem_isr_stats[slot];
+
+    frame->start = timebase_now();
+    frame->outer_child = mem_isr_child_cycles;
+    mem_isr_child_cycles = 0;
+
+    if (mem_isr_depth != 0 && s->nested != 0xFFFF) {
+        s->nested++;
+    }
+    mem_isr_depth++;
+
+    uint16_t depth = RAMEND - SP;
+    if (depth > s->max_stack) {
+        s->max_stack = depth;
+    }
+    MEM_CRITICAL_EXIT(MEM_CS_ISR_PROFILE);
+}
+
+static inline __attribute__((always_inline))
+void mem_isr_profile_exit(uint8_t slot, IsrProfileFrame* frame) {
+    MEM_CRITICAL_ENTER(MEM_CS_ISR_PROFILE);
+    IsrProfileStats* s = &mem_isr_stats[slot];
+
+    uint16_t elapsed = timebase_since(frame->start);
+    uint16_t own = elapsed - mem_isr_child_cycles;
+
+    // The enclosing invocation (if any) sees all of ours as nested time
+    mem_isr_child_cycles = frame->outer_child + elapsed;
+    mem_isr_depth--;
+
+    if (s->count != 0xFFFF) {
+        s->count++;
+    }
+    if (own < s->min_cycles) {
+        s->min_cycles = own;
+    }
+    if (own > s->max_cycles) {
+        s->max_cycles = own;
+    }
+    s->total_cycles += own;
+    MEM_CRITICAL_EXIT(MEM_CS_ISR_PROFILE);
+}
+
+#define MEM_ISR(vector, slot, ...)                                          \
+    static_assert((slot) < MEM_ISR_PROFILE_SLOTS,                           \
+                  "MEM_ISR slot out of range (MEM_ISR_PROFILE_SLOTS)");     \
+    static void vector##_profile_name(void) __attribute__((constructor));   \
+    static void vector##_profile_name(void) {                               \
+        mem_isr_profile_register((slot), PSTR(#vector));                    \
+    }                                                                       \
+    static inline void vector##_body(void) __attribute__((always_inline));  \
+    ISR(vector, ##__VA_ARGS__) {                                            \
+        IsrProfileFrame mem_isr_frame_;                                     \
+        mem_isr_profile_enter((slot), &mem_isr_frame_);                     \
+        vector##_body();                                                    \
+        mem_isr_profile_exit((slot), &mem_isr_frame_);                      \
+    }                                                                       \
+    static inline void vector##_body(void)
+
+#else
+
+#define MEM_ISR(vector, slot, ...) ISR(vector, ##__VA_ARGS__)
+
+#endif // MEM_MONITOR_ISR_PROFILE
+
+#endif // MEM_ISR_PROFILE_H
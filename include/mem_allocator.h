@@ -0,0 +1,192 @@
+/**
+ * @file mem_allocator.h
+ * @brief STL-style allocator adapter with per-container accounting
+ *
+ * MonitoredAllocator<T, Backend> satisfies the C++11 allocator interface
+ * (value_type, allocate, deallocate, rebind by converting constructor,
+ * equality), so any allocator-aware container can use it. It forwards to
+ * a backend and charges every allocation to a MemAllocTag:
+ *
+ *   MemHeapBackend        malloc/free (still seen by the heap tracking)
+ *   MemArena              bump allocator over a fixed buffer (mem_arena.h)
+ *   MemBlockPool<S, N>    N blocks of S bytes on an ObjectPool
+ *   MemDualHeapBackend    two-ended heap, fixed lifetime (mem_dual_heap.h)
+ *
+ *   static const char rx_tag_name[] PROGMEM = "vec:rx";
+ *   static MemAllocTag rx_tag(rx_tag_name);
+ *   MonitoredAllocator<Msg, MemArena> alloc(&scratch, &rx_tag);
+ *
+ * Per tag the monitor records live and peak bytes, allocations,
+ * reallocations (an allocation made while the tag already holds memory,
+ * i.e. container growth) and failures. Growth-policy waste needs the
+ * container's size; mem_alloc_sample(tag, container) records
+ * size() * sizeof(value_type) so the report can show capacity minus size.
+ *
+ * mem_monitor_print_alloc_tags() prints one line per tag:
+ *
+ *   [ALLOC] <tag> live=<b> peak=<b> allocs=<n> reallocs=<n> fail=<n> [size=<b> waste=<b>]
+ *
+ * Without exceptions a failed allocate() returns NULL; containers that
+ * do not check for it must be sized so that it cannot happen. Counters are
+ * not updated atomically: do not share a tag between main code and ISRs.
+ */
+
+#ifndef MEM_ALLOCATOR_H
+#define MEM_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "mem_container.h"
+#include "object_pool.h"
+
+// ============================================================================
+// TAGS
+// ============================================================================
+
+/**
+ * @brief Accounting for one container (or a group sharing the tag)
+ */
+class MemAllocTag {
+public:
+    explicit MemAllocTag(const char* name);
+    ~MemAllocTag();
+
+    MemAllocTag(const MemAllocTag&) = delete;
+    MemAllocTag& operator=(const MemAllocTag&) = delete;
+
+    void note_alloc(void* ptr, uint16_t bytes);
+    void note_free(uint16_t bytes);
+
+    const char* name;     // PROGMEM
+    uint16_t live;        // Bytes currently allocated (container capacity)
+    uint16_t peak;        // Most bytes allocated at once
+    uint16_t allocs;      // Successful allocations
+    uint16_t reallocs;    // Allocations while the tag already held memory
+    uint16_t failures;    // Allocations the backend refused
+    uint16_t in_use;      // Bytes holding elements at the last sample
+    uint8_t sampled;      // in_use is valid
+    MemAllocTag* next;    // Tag list link
+};
+
+/**
+ * @brief Record a container's current size for the waste figure
+ */
+template <typename C>
+inline void mem_alloc_sample(MemAllocTag* tag, const C& container) {
+    tag->in_use = (uint16_t)(container.size() * sizeof(typename C::value_type));
+    tag->sampled = 1;
+}
+
+/**
+ * @brief Print one [ALLOC] line per registered tag
+ */
+void mem_monitor_print_alloc_tags(void);
+
+// ============================================================================
+// BACKENDS
+// ============================================================================
+
+/**
+ * @brief avr-libc heap (goes through the monitor's malloc/free wrappers)
+ */
+struct MemHeapBackend {
+    void* allocate(uint16_t bytes) { return malloc(bytes); }
+    void deallocate(void* ptr, uint16_t) { free(ptr); }
+};
+
+extern MemHeapBackend mem_heap_backend;
+
+/**
+ * @brief Fixed-size blocks on an ObjectPool; requests above S bytes fail
+ */
+template <uint16_t S, uint16_t N>
+class MemBlockPool {
+public:
+    explicit MemBlockPool(const char* name) : pool_(name) {}
+
+    void* allocate(uint16_t bytes) {
+        if (bytes > S) {
+            return NULL;
+        }
+        return pool_.acquire();
+    }
+
+    void deallocate(void* ptr, uint16_t) {
+        pool_.release(static_cast<Block*>(ptr));
+    }
+
+private:
+    struct Block {
+        uint8_t bytes[S];
+    };
+
+    ObjectPool<Block, N> pool_;
+};
+
+// ============================================================================
+// ALLOCATOR
+// ============================================================================
+
+template <typename T, typename Backend>
+class MonitoredAllocator {
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind {
+        typedef MonitoredAllocator<U, Backend> other;
+    };
+
+    MonitoredAllocator(Backend* backend, MemAllocTag* tag) : backend_(backend), tag_(tag) {}
+
+    template <typename U>
+    MonitoredAllocator(const MonitoredAllocator<U, Backend>& other)
+        : backend_(other.backend()), tag_(other.tag()) {}
+
+    /**
+     * @brief Storage for n elements, or NULL (counted as a failure)
+     */
+    T* allocate(size_t n) {
+        unsigned long bytes = (unsigned long)n * sizeof(T);
+        void* ptr = bytes <= 0xFFFF ? backend_->allocate((uint16_t)bytes) : NULL;
+        tag_->note_alloc(ptr, (uint16_t)bytes);
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        if (ptr == NULL) {
+            return;
+        }
+        uint16_t bytes = (uint16_t)(n * sizeof(T));
+        backend_->deallocate(ptr, bytes);
+        tag_->note_free(bytes);
+    }
+
+    size_t max_size() const { return 0xFFFF / sizeof(T); }
+
+    Backend* backend() const { return backend_; }
+    MemAllocTag* tag() const { return tag_; }
+
+private:
+    Backend* backend_;
+    MemAllocTag* tag_;
+};
+
+template <typename T, typename U, typename B>
+inline bool operator==(const MonitoredAllocator<T, B>& a, const MonitoredAllocator<U, B>& b) {
+    return a.backend() == b.backend();
+}
+
+template <typename T, typename U, typename B>
+inline bool operator!=(const MonitoredAllocator<T, B>& a, const MonitoredAllocator<U, B>& b) {
+    return a.backend() != b.backend();
+}
+
+#endif // MEM_ALLOCATOR_H
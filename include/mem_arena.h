@@ -0,0 +1,90 @@
+/**
+ * @file mem_arena.h
+ * @brief Bump allocator over a caller-supplied buffer
+ *
+ * MemArena hands out consecutive bytes of one buffer. Allocation is a
+ * pointer bump; memory comes back all at once with reset(), or back to a
+ * saved point with rewind(). deallocate() only reclaims the most recent
+ * block (LIFO). A container that grows allocates its new block above the
+ * old one before freeing it, so the old capacity stays lost until reset()
+ * or rewind(): back containers that reserve once and never grow with an
+ * arena. Bytes freed out of order are counted as waste. Nothing is ever
+ * fragmented.
+ *
+ * The arena registers itself as a memory provider under its name:
+ *
+ *   static const char scratch_name[] PROGMEM = "arena:scratch";
+ *   static uint8_t scratch_buf[128];
+ *   static MemArena scratch(scratch_name, scratch_buf, sizeof(scratch_buf));
+ *
+ *   [BUDGET] arena:scratch bytes=128 used=<top> peak=<high> waste=<n> fail=<n>
+ *
+ * A buffer in .bss is reported at top level; a buffer taken from the heap
+ * or the stack is reported nested.
+ */
+
+#ifndef MEM_ARENA_H
+#define MEM_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mem_provider.h"
+
+class MemArena {
+public:
+    MemArena(const char* name, void* buffer, uint16_t size);
+    ~MemArena();
+
+    MemArena(const MemArena&) = delete;
+    MemArena& operator=(const MemArena&) = delete;
+
+    /**
+     * @brief Take bytes from the top of the arena
+     * @return NULL if they do not fit (counted as a failure)
+     */
+    void* allocate(uint16_t bytes);
+
+    /**
+     * @brief Return a block; only the most recent one is reclaimed
+     *
+     * Any other block stays allocated and its bytes are added to waste().
+     */
+    void deallocate(void* ptr, uint16_t bytes);
+
+    /**
+     * @brief Current top, for a later rewind()
+     */
+    uint16_t mark() const { return top_; }
+
+    /**
+     * @brief Drop everything allocated after mark
+     *
+     * Waste is capped at the new top; it may then over-count bytes lost
+     * above a block that is still live below the mark.
+     */
+    void rewind(uint16_t mark);
+
+    void reset() {
+        top_ = 0;
+        waste_ = 0;
+    }
+
+    uint16_t capacity() const { return size_; }
+    uint16_t used() const { return top_; }
+    uint16_t peak() const { return peak_; }
+    uint16_t failures() const { return failures_; }
+    uint16_t waste() const { return waste_; }
+
+private:
+    static void usage(const MemProvider* provider, MemProviderUsage* u);
+
+    uint8_t* buffer_;
+    uint16_t size_;
+    uint16_t top_;
+    uint16_t peak_;
+    uint16_t failures_;
+    uint16_t waste_;       // Bytes freed out of LIFO order, not reclaimed
+    MemProvider provider_;
+};
+
+#endif // MEM_ARENA_H
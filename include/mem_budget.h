@@ -0,0 +1,38 @@
+/**
+ * @file mem_budget.h
+ * @brief Build-time SRAM budget: static reservations vs. required stack
+ *
+ * The stack needs MEM_BUDGET_STACK_BYTES (MEM_BUDGET_MIN_STACK for the
+ * application plus MEM_MONITOR_ISR_STACK_RESERVE for interrupts). The
+ * budget is checked at two levels:
+ *
+ * - Compile time: MEM_BUDGET_ASSERT(what, bytes) fails the build when a
+ *   single constexpr-sized reservation cannot fit next to that stack.
+ *   ObjectPool, StaticVector, RingBuffer and the monitor's own tables
+ *   check themselves.
+ * - Link time: the monitor exports the stack requirement as absolute ELF
+ *   symbols (__mem_budget_*). After linking, tools/membudget adds up
+ *   .mailbox, .data, .bss and .noinit, prints a per-object breakdown and
+ *   fails the build when static data plus the stack exceed the SRAM.
+ */
+
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+#include <avr/io.h>
+#include "memory_monitor.h"
+
+// Internal SRAM of the target (0x0100 - RAMEND on the ATmega328P)
+#define MEM_SRAM_BYTES (RAMEND - 0x0100 + 1)
+
+// Stack the build must leave free
+#define MEM_BUDGET_STACK_BYTES (MEM_BUDGET_MIN_STACK + MEM_MONITOR_ISR_STACK_RESERVE)
+
+/**
+ * @brief Fail compilation if bytes cannot fit next to the required stack
+ */
+#define MEM_BUDGET_ASSERT(what, bytes)                                      \
+    static_assert((unsigned long)(bytes) + MEM_BUDGET_STACK_BYTES <= MEM_SRAM_BYTES, \
+                  what " does not fit in SRAM next to MEM_BUDGET_STACK_BYTES")
+
+#endif // MEM_BUDGET_H
@@ -0,0 +1,153 @@
+/**
+ * @file mem_container.h
+ * @brief Support code for the fixed-capacity containers
+ *
+ * avr-libc ships no C++ standard library, so StaticVector and RingBuffer
+ * bring their own placement new, move/forward and size-type selection.
+ * MemWatched<C> registers a container with the provider registry (see
+ * mem_provider.h) so its capacity, current fill and high-water mark appear
+ * in the [BUDGET] report:
+ *
+ *   static const char rx_name[] PROGMEM = "rx_queue";
+ *   static MemWatched<RingBuffer<Msg, 8> > rx_queue(rx_name);
+ *
+ * High-water counters are compiled in with MEM_CONTAINER_HIGH_WATER (on by
+ * default); without them peak is reported as 0 (not tracked).
+ */
+
+#ifndef MEM_CONTAINER_H
+#define MEM_CONTAINER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory_monitor.h"
+#include "mem_provider.h"
+#include "mem_budget.h"
+
+// ============================================================================
+// PLACEMENT NEW, MOVE, FORWARD
+// ============================================================================
+
+// Tag keeps this placement new from clashing with a <new> that may exist
+struct MemPlacement {};
+
+inline void* operator new(size_t, void* where, MemPlacement) noexcept {
+    return where;
+}
+
+template <typename T> struct MemRemoveRef { typedef T type; };
+template <typename T> struct MemRemoveRef<T&> { typedef T type; };
+template <typename T> struct MemRemoveRef<T&&> { typedef T type; };
+
+template <typename T>
+inline typename MemRemoveRef<T>::type&& mem_move(T&& value) noexcept {
+    return static_cast<typename MemRemoveRef<T>::type&&>(value);
+}
+
+template <typename T>
+inline T&& mem_forward(typename MemRemoveRef<T>::type& value) noexcept {
+    return static_cast<T&&>(value);
+}
+
+template <typename T>
+inline T&& mem_forward(typename MemRemoveRef<T>::type&& value) noexcept {
+    return static_cast<T&&>(value);
+}
+
+// ============================================================================
+// SIZE TYPE & HIGH-WATER COUNTER
+// ============================================================================
+
+/**
+ * @brief Smallest index type for capacity N
+ */
+template <bool Small> struct MemSizeSelect { typedef uint8_t type; };
+template <> struct MemSizeSelect<false> { typedef uint16_t type; };
+
+template <uint16_t N>
+struct MemSizeFor {
+    typedef typename MemSizeSelect<(N <= 255)>::type type;
+};
+
+/**
+ * @brief Peak element count (empty base when tracking is disabled)
+ */
+template <typename SizeT>
+class MemHighWater {
+public:
+#if MEM_CONTAINER_HIGH_WATER
+    MemHighWater() : peak_(0) {}
+
+    /**
+     * @brief Most elements held at once (0 when tracking is disabled)
+     */
+    SizeT high_water() const { return peak_; }
+    void reset_high_water() { peak_ = 0; }
+
+protected:
+    void note_size(SizeT size) {
+        if (size > peak_) {
+            peak_ = size;
+        }
+    }
+
+private:
+    SizeT peak_;
+#else
+    SizeT high_water() const { return 0; }
+    void reset_high_water() {}
+
+protected:
+    void note_size(SizeT) {}
+#endif
+};
+
+// ============================================================================
+// PROVIDER REGISTRATION
+// ============================================================================
+
+/**
+ * @brief Container registered as a memory provider for its lifetime
+ *
+ * Storage in .bss/.data counts as a top-level provider; a container on the
+ * stack or in the heap is reported nested so it is not counted twice.
+ * Not copyable: the descriptor points back at this object.
+ */
+template <typename C>
+class MemWatched : public C {
+public:
+    explicit MemWatched(const char* name) {
+        provider_.name = name;
+        provider_.fn = usage;
+        provider_.ctx = this;
+        provider_.counters.bytes = 0;
+        provider_.counters.used = 0;
+        provider_.counters.peak = 0;
+        provider_.counters.failures = 0;
+        provider_.counters.errors = 0;
+        provider_.counters.waste = 0;
+        provider_.flags = mem_provider_flags_for(this);
+        provider_.next = NULL;
+        mem_provider_register(&provider_);
+    }
+
+    ~MemWatched() {
+        mem_provider_unregister(&provider_);
+    }
+
+    MemWatched(const MemWatched&) = delete;
+    MemWatched& operator=(const MemWatched&) = delete;
+
+private:
+    static void usage(const MemProvider* provider, MemProviderUsage* u) {
+        const C* c = static_cast<const MemWatched*>(provider->ctx);
+        const uint16_t elem = sizeof(typename C::value_type);
+        u->bytes = sizeof(C);
+        u->used = c->size() * elem;
+        u->peak = c->high_water() * elem;
+    }
+
+    MemProvider provider_;
+};
+
+#endif // MEM_CONTAINER_H
@@ -0,0 +1,68 @@
+/**
+ * @file mem_critical.h
+ * @brief Interrupt-disabling critical sections with latency accounting
+ * 
+ * Every place where the monitor runs with interrupts disabled uses
+ * MEM_CRITICAL_ENTER/EXIT with a site ID. With MEM_MONITOR_IRQ_LATENCY
+ * enabled each section is timed with the Timer1 timebase (read right after
+ * cli and right before SREG is restored), and the per-site count and
+ * worst case are kept. That worst case is the latency the section adds to
+ * any interrupt that becomes pending while it runs.
+ * 
+ * ENTER declares locals; the matching EXIT must be in the same block.
+ */
+
+#ifndef MEM_CRITICAL_H
+#define MEM_CRITICAL_H
+
+#include <avr/io.h>
+#include <stdint.h>
+#include "memory_monitor.h"
+
+#if MEM_MONITOR_IRQ_LATENCY
+#include "timebase.h"
+
+/**
+ * @brief Per-site interrupts-disabled statistics
+ */
+struct CriticalSectionStats {
+    uint16_t count;        // Sections entered (saturates at 65535)
+    uint16_t max_cycles;   // Longest interrupts-off window
+};
+
+extern CriticalSectionStats mem_critical_stats[MEM_CS_COUNT];
+
+#define MEM_CRITICAL_ENTER(site)                                        \
+    uint8_t mem_cs_sreg_ = SREG;                                        \
+    __asm__ __volatile__ ("cli" ::: "memory");                          \
+    uint16_t mem_cs_start_ = timebase_now()
+
+#define MEM_CRITICAL_EXIT(site)                                         \
+    do {                                                                \
+        uint16_t mem_cs_elapsed_ = timebase_since(mem_cs_start_);       \
+        CriticalSectionStats* mem_cs_ = &mem_critical_stats[(site)];    \
+        if (mem_cs_->count != 0xFFFF) {                                 \
+            mem_cs_->count++;                                           \
+        }                                                               \
+        if (mem_cs_elapsed_ > mem_cs_->max_cycles) {                    \
+            mem_cs_->max_cycles = mem_cs_elapsed_;                      \
+        }                                                               \
+        __asm__ __volatile__ ("" ::: "memory");                         \
+        SREG = mem_cs_sreg_;                                            \
+    } while (0)
+
+#else
+
+#define MEM_CRITICAL_ENTER(site)                                        \
+    uint8_t mem_cs_sreg_ = SREG;                                        \
+    __asm__ __volatile__ ("cli" ::: "memory")
+
+#define MEM_CRITICAL_EXIT(site)                                         \
+    do {                                                                \
+        __asm__ __volatile__ ("" ::: "memory");                         \
+        SREG = mem_cs_sreg_;                                            \
+    } while (0)
+
+#endif // MEM_MONITOR_IRQ_LATENCY
+
+#endif // MEM_CRITICAL_H
@@ -0,0 +1,160 @@
+/**
+ * @file mem_dual_heap.h
+ * @brief Two-ended heap: short- and long-lived blocks from opposite ends
+ *
+ * In a first-fit heap a long-lived block allocated among transient ones
+ * stays behind when they are freed and splits the free space. MemDualHeap
+ * manages a caller-supplied region and places blocks by lifetime:
+ *
+ *   MEM_LIFETIME_SHORT   first fit from the bottom, lowest address first
+ *   MEM_LIFETIME_LONG    first fit from the top, highest address first
+ *   MEM_LIFETIME_AUTO    decided per call site from its own history
+ *
+ * Long-lived blocks pile up at the top and transient ones churn at the
+ * bottom, so the free space between them stays in one piece.
+ *
+ *   static const char net_heap_name[] PROGMEM = "dual:net";
+ *   static uint8_t net_heap_buf[384];
+ *   static MemDualHeap net_heap(net_heap_name, net_heap_buf, sizeof(net_heap_buf));
+ *
+ *   Conn* c = (Conn*)net_heap.allocate(sizeof(Conn), MEM_LIFETIME_LONG);
+ *   uint8_t* pkt = (uint8_t*)net_heap.allocate(len, MEM_LIFETIME_SHORT);
+ *
+ * AUTO keys on the return address of allocate(), so it only tells call
+ * sites apart when they call allocate() directly. A site counts as
+ * long-lived once it has made at least two allocations and freed fewer
+ * than half of them; until then its blocks go to the bottom. Up to
+ * MEM_DUAL_HEAP_SITES sites are profiled per heap; others are short.
+ *
+ * Every block carries a 2-byte header (size, side and site); the region is
+ * at most 4094 bytes. Free blocks are merged with their neighbours on
+ * deallocate(). Allocation and free walk the blocks, O(blocks); a header
+ * with size 0 or running past the region ends the walk and counts as an
+ * error.
+ *
+ * The heap registers as a memory provider under its name, and
+ * mem_monitor_print_dual_heaps() prints each side:
+ *
+ *   [DUALHEAP] <name> bytes=<n> short=<used>/<peak> long=<used>/<peak> largest=<n> fail=<n> err=<n>
+ *
+ * MemDualHeapBackend adapts a heap to MonitoredAllocator (mem_allocator.h)
+ * with a fixed lifetime. Not interrupt safe.
+ */
+
+#ifndef MEM_DUAL_HEAP_H
+#define MEM_DUAL_HEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory_monitor.h"
+#include "mem_provider.h"
+
+// Call sites profiled per heap for MEM_LIFETIME_AUTO (0 - 7)
+#ifndef MEM_DUAL_HEAP_SITES
+#define MEM_DUAL_HEAP_SITES 4
+#endif
+
+enum MemLifetime {
+    MEM_LIFETIME_SHORT,   // Freed soon: bottom end
+    MEM_LIFETIME_LONG,    // Kept: top end
+    MEM_LIFETIME_AUTO     // Profiled by call site
+};
+
+class MemDualHeap {
+public:
+    MemDualHeap(const char* name, void* buffer, uint16_t size);
+    ~MemDualHeap();
+
+    MemDualHeap(const MemDualHeap&) = delete;
+    MemDualHeap& operator=(const MemDualHeap&) = delete;
+
+    /**
+     * @brief Allocate from the end that matches the lifetime
+     * @return NULL if no free block is large enough (counted as a failure)
+     */
+    void* allocate(uint16_t bytes, MemLifetime lifetime = MEM_LIFETIME_AUTO);
+
+    /**
+     * @brief Free a block and merge it with free neighbours
+     *
+     * A pointer that is not a live block of this heap is counted as an
+     * error and ignored, as is a corrupt block header met on the walk. The size argument is only for the backend
+     * interface.
+     */
+    void deallocate(void* ptr, uint16_t bytes = 0);
+
+    /**
+     * @brief Largest request that would succeed now
+     */
+    uint16_t largest_free() const;
+
+    uint16_t capacity() const { return size_; }
+    uint16_t short_used() const { return used_[0]; }
+    uint16_t long_used() const { return used_[1]; }
+    uint16_t short_peak() const { return peak_[0]; }
+    uint16_t long_peak() const { return peak_[1]; }
+    uint16_t failures() const { return failures_; }
+    uint16_t errors() const { return errors_; }
+
+    const char* name() const { return provider_.name; }
+    const MemDualHeap* next() const { return next_; }
+
+private:
+    struct Site {
+        uint16_t pc;       // Caller (flash byte address), 0 = unused
+        uint8_t allocs;    // Blocks allocated (halved with frees at 255)
+        uint8_t frees;     // Blocks freed
+    };
+
+    uint8_t site_for(uint16_t pc);
+    uint8_t lifetime_of(uint8_t site) const;
+    uint8_t* next_block(uint8_t* p) const;
+    uint8_t* take(uint16_t need, uint8_t side);
+    void merge_free();
+
+    static void usage(const MemProvider* provider, MemProviderUsage* u);
+
+    uint8_t* buffer_;
+    uint16_t size_;
+    uint16_t used_[2];     // Bytes held per side (headers included)
+    uint16_t peak_[2];
+    uint16_t peak_total_;  // Both sides at once (the [BUDGET] peak)
+    uint16_t failures_;
+    mutable uint16_t errors_;   // Also counted by const walks
+#if MEM_DUAL_HEAP_SITES > 0
+    Site sites_[MEM_DUAL_HEAP_SITES];
+#endif
+    MemProvider provider_;
+    MemDualHeap* next_;    // Report list link
+};
+
+/**
+ * @brief MonitoredAllocator backend placing every block with one lifetime
+ *
+ * Through the allocator, allocate()'s return address is the container's
+ * growth code, so AUTO would lump all containers of a type into one site.
+ * The backend takes SHORT or LONG instead (AUTO is treated as SHORT).
+ *
+ *   MemDualHeapBackend conn_backend(&net_heap, MEM_LIFETIME_LONG);
+ *   MonitoredAllocator<Conn, MemDualHeapBackend> alloc(&conn_backend, &conn_tag);
+ */
+class MemDualHeapBackend {
+public:
+    MemDualHeapBackend(MemDualHeap* heap, MemLifetime lifetime)
+        : heap_(heap),
+          lifetime_(lifetime == MEM_LIFETIME_LONG ? MEM_LIFETIME_LONG : MEM_LIFETIME_SHORT) {}
+
+    void* allocate(uint16_t bytes) { return heap_->allocate(bytes, lifetime_); }
+    void deallocate(void* ptr, uint16_t bytes) { heap_->deallocate(ptr, bytes); }
+
+private:
+    MemDualHeap* heap_;
+    MemLifetime lifetime_;
+};
+
+/**
+ * @brief Print one [DUALHEAP] line per heap
+ */
+void mem_monitor_print_dual_heaps(void);
+
+#endif // MEM_DUAL_HEAP_H
@@ -0,0 +1,97 @@
+/**
+ * @file mem_provider.h
+ * @brief Registry of memory providers for a single SRAM budget report
+ *
+ * Every allocator or reserved buffer (the avr-libc heap, pools, arenas,
+ * watched static buffers) joins the registry with a small MemProvider
+ * descriptor. The descriptor either carries fixed counters or a callback
+ * that fills them on demand. mem_monitor_print_budget() walks the list
+ * once and prints a breakdown that adds up to the whole SRAM:
+ *
+ *   [BUDGET] sram=2048 providers=<n>
+ *   [BUDGET] <name> bytes=<n> used=<n> [peak=<n>] [waste=<n>] [fail=<n>] [err=<n>]
+ *   [BUDGET] +<name> bytes=<n> used=<n> ...          (nested, not summed)
+ *   [BUDGET] stack bytes=<n>
+ *   [BUDGET] free bytes=<n>
+ *   [BUDGET] unaccounted bytes=<n>
+ *
+ * "bytes" is the SRAM the provider occupies, "used" what it has handed
+ * out and "peak" the most it ever handed out (omitted when 0: not
+ * tracked). "waste" is released memory the provider cannot hand out
+ * again (an arena block freed out of order). "fail" counts refused
+ * requests and "err" invalid or double releases. All three are omitted
+ * when 0. A provider carved out of another one
+ * (an arena allocated from the heap) sets MEM_PROVIDER_NESTED so its bytes
+ * are not counted twice.
+ * "unaccounted" is whatever no provider claims, usually globals in
+ * .data/.bss. The report costs O(number of providers); callbacks must be
+ * O(1) and must not allocate.
+ *
+ * The monitor registers "mailbox", "monitor" (its own tables) and "heap"
+ * in mem_monitor_init().
+ */
+
+#ifndef MEM_PROVIDER_H
+#define MEM_PROVIDER_H
+
+#include <stdint.h>
+
+// Provider flags
+#define MEM_PROVIDER_NESTED 0x01  // Bytes lie inside another provider
+
+/**
+ * @brief Provider footprint
+ */
+struct MemProviderUsage {
+    uint16_t bytes;     // SRAM occupied (capacity)
+    uint16_t used;      // Bytes handed out
+    uint16_t peak;      // High-water mark of used (0 = not tracked)
+    uint16_t failures;  // Requests refused for lack of space
+    uint16_t errors;    // Invalid or double releases
+    uint16_t waste;     // Released but not reusable (included in used)
+};
+
+struct MemProvider;
+
+/**
+ * @brief Fill the current footprint (NULL: the descriptor's counters are used)
+ */
+typedef void (*MemProviderFn)(const MemProvider* provider, MemProviderUsage* usage);
+
+/**
+ * @brief Registry entry; lives as long as the provider is registered
+ */
+struct MemProvider {
+    const char* name;          // PROGMEM string
+    MemProviderFn fn;          // Callback, or NULL to report 'counters'
+    void* ctx;                 // Callback context
+    MemProviderUsage counters; // Maintained by the provider when fn is NULL
+    uint8_t flags;             // MEM_PROVIDER_*
+    MemProvider* next;         // Registry link (owned by the registry)
+};
+
+/**
+ * @brief Add a provider (no-op if it is already registered)
+ */
+void mem_provider_register(MemProvider* provider);
+
+/**
+ * @brief Remove a provider (no-op if it is not registered)
+ */
+void mem_provider_unregister(MemProvider* provider);
+
+/**
+ * @brief Flags for a provider whose storage is at addr
+ * @return MEM_PROVIDER_NESTED if addr lies in the heap or on the stack
+ *         (memory already reported by the "heap" or "stack" line), else 0
+ */
+uint8_t mem_provider_flags_for(const void* addr);
+
+/**
+ * @brief Print the SRAM budget breakdown
+ *
+ * Output format: see the file comment.
+ */
+void mem_monitor_print_budget(void);
+
+#endif // MEM_PROVIDER_H
@@ -0,0 +1,139 @@
+/**
+ * @file mem_task.h
+ * @brief Stackless cooperative tasks with per-task memory accounting
+ *
+ * Protothread-style tasks: every task is a function that runs from the top
+ * on each dispatch and jumps back to where it last yielded, using a
+ * switch on a line-number continuation. All tasks share the one system
+ * stack, and a task's locals do not survive a yield; whatever must
+ * persist lives in an explicitly sized state struct.
+ *
+ *   struct BlinkState { uint16_t count; };
+ *   static BlinkState blink_state;
+ *
+ *   static MemTaskStatus blink(MemTask* t) {
+ *       BlinkState* s = (BlinkState*)t->state;
+ *       MEM_TASK_BEGIN(t);
+ *       for (s->count = 0; s->count < 10; s->count++) {
+ *           toggle_led();
+ *           MEM_TASK_YIELD(t);
+ *       }
+ *       MEM_TASK_END(t);
+ *   }
+ *
+ *   static const char blink_name[] PROGMEM = "task:blink";
+ *   static MemTask blink_task = MEM_TASK_INIT(blink_name, blink, blink_state);
+ *
+ *   mem_task_add(&blink_task);
+ *   while (mem_task_run()) { }
+ *
+ * Memory per task:
+ * - State: sizeof(state) is registered as a memory provider under the task
+ *   name, so it appears in the [BUDGET] report.
+ * - Stack: before each dispatch the scheduler paints up to
+ *   MEM_TASK_STACK_PROBE bytes below its own SP (only the part below the
+ *   task's known peak, never the MEM_GUARD_BAND_BYTES above the heap) and
+ *   scans them afterwards. The deepest byte touched is the task's share of
+ *   the shared stack, capped at the probe size. Interrupts taken while the
+ *   task runs are charged to it.
+ *
+ * Tasks are dispatched from main code only; they are not interrupt safe.
+ */
+
+#ifndef MEM_TASK_H
+#define MEM_TASK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory_monitor.h"
+#include "mem_provider.h"
+
+// ============================================================================
+// TASK DESCRIPTOR
+// ============================================================================
+
+enum MemTaskStatus {
+    MEM_TASK_WAITING,   // Yielded or blocked; dispatch again
+    MEM_TASK_DONE       // Ran to MEM_TASK_END; no longer dispatched
+};
+
+struct MemTask;
+
+typedef MemTaskStatus (*MemTaskFn)(MemTask* task);
+
+struct MemTask {
+    const char* name;      // PROGMEM
+    MemTaskFn fn;
+    void* state;           // Task state (persists across yields)
+    uint16_t state_size;   // sizeof(*state)
+    uint16_t lc;           // Local continuation (0 = start)
+    uint8_t done;          // Returned MEM_TASK_DONE
+    uint16_t runs;         // Dispatches (saturating)
+    uint16_t stack_peak;   // Deepest stack below the scheduler's SP (bytes)
+    MemProvider provider;  // State footprint in the budget report
+    MemTask* next;         // Scheduler list link
+};
+
+/**
+ * @brief Static initializer for a MemTask
+ */
+#define MEM_TASK_INIT(name, fn, state) \
+    { (name), (fn), &(state), sizeof(state), 0, 0, 0, 0, {}, NULL }
+
+// ============================================================================
+// PROTOTHREAD MACROS
+// ============================================================================
+
+#define MEM_TASK_BEGIN(t) switch ((t)->lc) { case 0:
+
+#define MEM_TASK_YIELD(t)                                                   \
+    do {                                                                    \
+        (t)->lc = __LINE__;                                                 \
+        return MEM_TASK_WAITING;                                            \
+        case __LINE__:;                                                     \
+    } while (0)
+
+#define MEM_TASK_WAIT_UNTIL(t, cond)                                        \
+    do {                                                                    \
+        (t)->lc = __LINE__;                                                 \
+        case __LINE__:                                                      \
+        if (!(cond)) {                                                      \
+            return MEM_TASK_WAITING;                                        \
+        }                                                                   \
+    } while (0)
+
+#define MEM_TASK_END(t)                                                     \
+    }                                                                       \
+    (t)->lc = 0;                                                            \
+    return MEM_TASK_DONE
+
+// ============================================================================
+// SCHEDULER
+// ============================================================================
+
+/**
+ * @brief Add a task and register its state footprint (no-op if present)
+ */
+void mem_task_add(MemTask* task);
+
+/**
+ * @brief Restart a finished (or running) task from MEM_TASK_BEGIN
+ */
+void mem_task_restart(MemTask* task);
+
+/**
+ * @brief Dispatch every unfinished task once, in the order added
+ * @return Number of tasks still waiting
+ */
+uint8_t mem_task_run(void);
+
+/**
+ * @brief Print per-task memory
+ *
+ * Output format:
+ * [TASK] tasks=<n> base=<stack bytes at dispatch> stack=<deepest task>
+ * [TASK] <name> state=<bytes> stack=<bytes> runs=<n> [done]
+ */
+void mem_monitor_print_tasks(void);
+
+#endif // MEM_TASK_H
@@ -44,9 +44,173 @@
 // Stack sentinel fill pattern (used to detect stack high-water mark)
 #define STACK_SENTINEL 0xAA
 
+// Stack painting modes
+#define MEM_PAINT_FULL  0  // Whole heap-stack gap (exact high-water mark)
+#define MEM_PAINT_GUARD 1  // Guard band above the heap end (early warning only)
+
+// MEM_PAINT_GUARD paints and scans only MEM_GUARD_BAND_BYTES, re-placed
+// whenever the heap end moves; the stack peak becomes a sampled lower bound
+#ifndef MEM_MONITOR_PAINT_MODE
+#define MEM_MONITOR_PAINT_MODE MEM_PAINT_FULL
+#endif
+
+// Guard band size for MEM_PAINT_GUARD (bytes, 1 - 255)
+#ifndef MEM_GUARD_BAND_BYTES
+#define MEM_GUARD_BAND_BYTES 16
+#endif
+
 // Safety margin between heap and stack (bytes)
 #define COLLISION_SAFETY_MARGIN 128
 
+// Stack kept free for interrupt handlers below any deep operation (bytes).
+// Size it from the deepest "[ISR] ... stack=" value plus the handler frames.
+#ifndef MEM_MONITOR_ISR_STACK_RESERVE
+#define MEM_MONITOR_ISR_STACK_RESERVE 64
+#endif
+
+// Deepest application stack the build must leave room for (bytes, without
+// the ISR reserve). Checked at compile and link time, see mem_budget.h.
+#ifndef MEM_BUDGET_MIN_STACK
+#define MEM_BUDGET_MIN_STACK 256
+#endif
+
+// Heap tracking modes
+#define MEM_TRACK_TABLE  0  // Per-block table (pointer, size, call site)
+#define MEM_TRACK_HEADER 1  // Counters only; sizes read from avr-libc chunk headers
+
+// MEM_TRACK_HEADER needs no table SRAM, frees in O(1) and counts heap use
+// in chunk bytes (payload rounded up by the allocator + 2-byte header)
+#ifndef MEM_MONITOR_TRACK_MODE
+#define MEM_MONITOR_TRACK_MODE MEM_TRACK_TABLE
+#endif
+
+// free() queues blocks and releases them in address-sorted batches from
+// mem_monitor_update()/mem_monitor_free_drain() (0 = off, else queue slots, 2 - 16)
+#ifndef MEM_MONITOR_DEFERRED_FREE
+#define MEM_MONITOR_DEFERRED_FREE 0
+#endif
+
+// malloc() drains the free queue first when the heap-stack gap is below this (bytes)
+#ifndef MEM_DEFERRED_FREE_PRESSURE
+#define MEM_DEFERRED_FREE_PRESSURE (2 * COLLISION_SAFETY_MARGIN)
+#endif
+
+// Snapshot, classify (OOM/FRAG) and report every failed malloc() (0 = off)
+#ifndef MEM_MONITOR_ALLOC_FORENSICS
+#define MEM_MONITOR_ALLOC_FORENSICS 0
+#endif
+
+// Record allocation order per table entry for the [BLAME] report's age
+// column (0 = off, saves 2 bytes per table entry)
+#ifndef MEM_MONITOR_FRAG_BLAME
+#define MEM_MONITOR_FRAG_BLAME 0
+#endif
+
+// Pinning blocks listed by mem_monitor_print_frag_blame()
+#ifndef MEM_FRAG_BLAME_TOP
+#define MEM_FRAG_BLAME_TOP 4
+#endif
+
+// Return addresses captured per sampled allocation (0 = disabled, 1 - 4)
+#ifndef MEM_MONITOR_CALLSITE_DEPTH
+#define MEM_MONITOR_CALLSITE_DEPTH 0
+#endif
+
+// Capture the call chain of every Nth allocation
+#ifndef MEM_MONITOR_CALLSITE_SAMPLE_RATE
+#define MEM_MONITOR_CALLSITE_SAMPLE_RATE 1
+#endif
+
+// Bytes of stack searched for return addresses above the allocator frame
+#ifndef MEM_MONITOR_CALLSITE_SCAN_BYTES
+#define MEM_MONITOR_CALLSITE_SCAN_BYTES 96
+#endif
+
+// Time the monitor's interrupts-disabled sections with Timer1 (0 = off)
+#ifndef MEM_MONITOR_IRQ_LATENCY
+#define MEM_MONITOR_IRQ_LATENCY 0
+#endif
+
+// Profile ISRs declared with MEM_ISR() (0 = off, see isr_profile.h)
+#ifndef MEM_MONITOR_ISR_PROFILE
+#define MEM_MONITOR_ISR_PROFILE 0
+#endif
+
+// Number of profiled ISRs (slot IDs 0 .. N-1 passed to MEM_ISR)
+#ifndef MEM_ISR_PROFILE_SLOTS
+#define MEM_ISR_PROFILE_SLOTS 4
+#endif
+
+// Statistical PC sampling on Timer1 compare A (0 = off, see pc_profile.h)
+#ifndef MEM_MONITOR_PC_PROFILE
+#define MEM_MONITOR_PC_PROFILE 0
+#endif
+
+// Samples per second (F_CPU / rate must be below 65536)
+#ifndef MEM_PC_PROFILE_HZ
+#define MEM_PC_PROFILE_HZ 1000
+#endif
+
+// PC hash entries (power of two, 6 bytes each)
+#ifndef MEM_PC_PROFILE_SLOTS
+#define MEM_PC_PROFILE_SLOTS 32
+#endif
+
+// Flash bytes per PC bucket: 2^N (1 = exact instruction)
+#ifndef MEM_PC_PROFILE_BUCKET_SHIFT
+#define MEM_PC_PROFILE_BUCKET_SHIFT 3
+#endif
+
+// Hash entries probed per sample before it is dropped
+#ifndef MEM_PC_PROFILE_PROBES
+#define MEM_PC_PROFILE_PROBES 4
+#endif
+
+// Emulated stack-limit register (0 = off, see stack_limit.h)
+#ifndef MEM_MONITOR_STACK_LIMIT
+#define MEM_MONITOR_STACK_LIMIT 0
+#endif
+
+// Stack limit: bytes kept between the heap end and the lowest allowed SP
+#ifndef MEM_STACK_LIMIT_MARGIN
+#define MEM_STACK_LIMIT_MARGIN 32
+#endif
+
+// Stack limit checks per second from Timer1 compare B
+#ifndef MEM_STACK_LIMIT_HZ
+#define MEM_STACK_LIMIT_HZ 5000
+#endif
+
+// Reset through the watchdog after a stack-limit breach (0 = keep running)
+#ifndef MEM_STACK_LIMIT_RESET
+#define MEM_STACK_LIMIT_RESET 0
+#endif
+
+// High-water counters in StaticVector/RingBuffer (0 = off, saves 1-2 bytes each)
+#ifndef MEM_CONTAINER_HIGH_WATER
+#define MEM_CONTAINER_HIGH_WATER 1
+#endif
+
+// Stack painted below the scheduler before each task dispatch (bytes, 0 = off).
+// Bounds the per-task stack figure in mem_task.h.
+#ifndef MEM_TASK_STACK_PROBE
+#define MEM_TASK_STACK_PROBE 192
+#endif
+
+/**
+ * @brief Interrupts-disabled sections of the monitor (see mem_critical.h)
+ */
+enum MemCriticalSite {
+    MEM_CS_STACK_POINTER,   // mem_monitor_get_stack_pointer()
+    MEM_CS_MAILBOX,         // Mailbox publish
+    MEM_CS_ISR_PROFILE,     // MEM_ISR() entry/exit bookkeeping
+    MEM_CS_PC_PROFILE,      // PC sample table drain
+    MEM_CS_STACK_RESERVE,   // __malloc_heap_end update
+    MEM_CS_STACK_LIMIT,     // Stack limit refresh after malloc/free
+    MEM_CS_PROVIDER,        // Provider/allocation tag list update
+    MEM_CS_COUNT
+};
+
 /**
  * @brief Heap allocation tracking entry
  */
@@ -54,6 +218,9 @@ struct AllocationEntry {
     void* ptr;          // Pointer to allocated block
     uint16_t size;      // Size of allocation
     uint8_t active;     // 1 if allocated, 0 if freed
+#if MEM_MONITOR_CALLSITE_DEPTH > 0
+    uint16_t callsite;  // Byte address of the malloc() caller (0 if not sampled)
+#endif
 };
 
 /**
@@ -63,7 +230,7 @@ struct MemoryStats {
     uint16_t total_sram;           // Total SRAM available
     uint16_t static_data;          // .data segment size
     uint16_t static_bss;           // .bss segment size
-    uint16_t heap_used;            // Current heap usage
+    uint16_t heap_used;            // Current heap usage (header mode: incl. chunk headers)
     uint16_t heap_total_allocated; // Total ever allocated
     uint16_t heap_total_freed;     // Total ever freed
     uint16_t alloc_count;          // Number of malloc calls
@@ -75,6 +242,53 @@ struct MemoryStats {
     uint8_t collision_warning;     // 1 if heap/stack collision risk detected
 };
 
+// Publish statistics in the fixed-address debugger mailbox (see Makefile)
+#ifndef MEM_MONITOR_MAILBOX
+#define MEM_MONITOR_MAILBOX 1
+#endif
+
+#if MEM_MONITOR_MAILBOX
+// Mailbox location: first bytes of SRAM, .data is linked behind it
+#define MEM_MAILBOX_ADDR    0x0100
+#define MEM_MAILBOX_SIZE    48
+#define MEM_MAILBOX_MAGIC   0x4D4D  // "MM"
+#define MEM_MAILBOX_VERSION 1
+
+/**
+ * @brief Debugger-readable statistics mailbox
+ * 
+ * Linked to MEM_MAILBOX_ADDR (section .mailbox) so external tools can read
+ * it without symbols. Layout (little-endian, packed):
+ * 
+ *   0  magic             MEM_MAILBOX_MAGIC
+ *   2  version           MEM_MAILBOX_VERSION
+ *   3  size              sizeof(MemoryMailbox)
+ *   4  generation        Odd while an update is in progress
+ *   6  stats             MemoryStats snapshot
+ *  33  alloc_table       SRAM address of the allocation table
+ *  35  alloc_table_len   MAX_HEAP_ALLOCATIONS
+ *  36  alloc_entry_size  sizeof(AllocationEntry)
+ * 
+ * In MEM_TRACK_HEADER mode there is no table: alloc_table, alloc_table_len
+ * and alloc_entry_size are 0.
+ * 
+ * Readers sample the generation before and after copying; the copy is
+ * consistent if both values are equal and even.
+ */
+struct MemoryMailbox {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t size;
+    volatile uint16_t generation;
+    MemoryStats stats;
+    AllocationEntry* alloc_table;
+    uint8_t alloc_table_len;
+    uint8_t alloc_entry_size;
+};
+
+extern MemoryMailbox mem_mailbox;
+#endif
+
 /**
  * @brief Initialize memory monitoring framework
  * 
@@ -102,6 +316,13 @@ void mem_monitor_init(void);
  */
 void mem_monitor_update(void);
 
+/**
+ * @brief Number of mem_monitor_update() calls since init (wraps at 65536)
+ * 
+ * A coarse timestamp that needs no timer.
+ */
+uint16_t mem_monitor_get_update_count(void);
+
 /**
  * @brief Get current memory statistics
  * @param stats Pointer to MemoryStats structure to fill
@@ -124,6 +345,29 @@ void mem_monitor_get_stats(MemoryStats* stats);
  */
 void mem_monitor_print_diagnostics(void);
 
+/**
+ * @brief Emit a workload phase marker via UART
+ * @param name Phase name stored in program memory (PSTR)
+ * 
+ * Output format:
+ * [PHASE] <name>
+ * 
+ * Host tools use the markers to align captures of different firmware
+ * builds running the same workload. Diagnostics printed after a marker
+ * belong to that phase.
+ */
+void mem_monitor_mark_phase(const char* name);
+
+#if MEM_MONITOR_IRQ_LATENCY
+/**
+ * @brief Print the worst interrupts-disabled window per monitor site
+ * 
+ * Output format (one line per site, cycles at F_CPU):
+ * [IRQOFF] <site> count=<n> max=<cycles>
+ */
+void mem_monitor_print_irq_latency(void);
+#endif
+
 /**
  * @brief Get current stack pointer value
  * @return Current SP register value
@@ -151,6 +395,51 @@ uint16_t mem_monitor_get_max_stack_usage(void);
  */
 uint16_t mem_monitor_get_free_stack_space(void);
 
+/**
+ * @brief Fold a stack depth measured elsewhere into the peak
+ * @param bytes Stack usage (bytes below RAMEND)
+ * 
+ * For code that repaints sentinel bytes (mem_task.cpp) and would
+ * otherwise erase a deeper excursion before the next scan sees it.
+ */
+void mem_monitor_note_stack_usage(uint16_t bytes);
+
+/**
+ * @brief Saved allocator limit of a stack reservation
+ */
+struct MemStackReservation {
+    char* prev_heap_end;   // __malloc_heap_end before the reservation
+};
+
+/**
+ * @brief Stack available to the caller before the heap gets in the way
+ * @return Bytes between SP and the heap end, minus
+ *         MEM_MONITOR_ISR_STACK_RESERVE (0 if less than that is left)
+ * 
+ * Call before a known-deep operation (parser, recursive walk, large local
+ * buffer) to pick a cheaper strategy instead of overflowing. Includes
+ * free memory the heap could still claim; see mem_monitor_stack_reserve().
+ */
+uint16_t mem_monitor_stack_headroom(void);
+
+/**
+ * @brief Keep the heap out of the next bytes of stack
+ * @param bytes Stack the operation may use below the current SP
+ * @param r Caller-provided record, passed to mem_monitor_stack_release()
+ * @return 1 if reserved, 0 if the headroom is smaller (nothing changed)
+ * 
+ * Lowers avr-libc's __malloc_heap_end to SP - bytes - ISR reserve, so
+ * malloc() fails instead of growing the heap into the reserved stack.
+ * Blocks already on the free list below the limit stay usable.
+ * Reservations nest; release them in reverse order.
+ */
+uint8_t mem_monitor_stack_reserve(uint16_t bytes, MemStackReservation* r);
+
+/**
+ * @brief End a reservation and restore the previous allocator limit
+ */
+void mem_monitor_stack_release(const MemStackReservation* r);
+
 /**
  * @brief Get current heap usage
  * @return Bytes of heap currently allocated
@@ -171,8 +460,50 @@ float mem_monitor_get_fragmentation_ratio(void);
  */
 uint8_t mem_monitor_check_collision(void);
 
+#if MEM_MONITOR_DEFERRED_FREE
+/**
+ * @brief Release every queued free() to the allocator
+ * 
+ * Blocks are released highest address first, so a run that ends at the
+ * heap top lowers __brkval chunk by chunk instead of growing the free
+ * list. Called by mem_monitor_update(), by malloc() on failure or under
+ * pressure, and by free() when the queue is full; call it from idle time
+ * to keep latency-critical code free of coalescing work.
+ */
+void mem_monitor_free_drain(void);
+#endif
+
 // Heap tracking functions (called by malloc/free wrappers)
 void mem_monitor_track_alloc(void* ptr, uint16_t size);
 void mem_monitor_track_free(void* ptr);
 
+/**
+ * @brief Look up a live block in the allocation table (MEM_TRACK_TABLE)
+ * @param ptr Pointer returned by malloc
+ * @param callsite Receives the sampled caller (0 if not sampled or not captured)
+ * @param seq Receives the allocation number (alloc_count when it was made;
+ *            0 without MEM_MONITOR_FRAG_BLAME)
+ * @return 1 if the block is tracked, 0 otherwise (always 0 in header mode)
+ */
+uint8_t mem_monitor_find_alloc(const void* ptr, uint16_t* callsite, uint16_t* seq);
+
+#if MEM_MONITOR_CALLSITE_DEPTH > 0
+/**
+ * @brief Capture and emit the call chain of a sampled allocation
+ * @param ptr Pointer returned by malloc (already tracked)
+ * @param size Requested size in bytes
+ * 
+ * Called from the malloc wrapper for every
+ * MEM_MONITOR_CALLSITE_SAMPLE_RATE-th allocation. Walks the stack above the
+ * wrapper frame for up to MEM_MONITOR_CALLSITE_DEPTH return addresses.
+ * Blocks missing from the allocation table (table full) are not sampled,
+ * since their free could not be reported.
+ * 
+ * Output format (addresses are flash byte addresses):
+ * [HEAP] A <ptr> <size> <caller> [<caller's caller> ...]
+ * [HEAP] F <ptr>            (when a sampled block is freed)
+ */
+void mem_monitor_record_callsite(void* ptr, uint16_t size);
+#endif
+
 #endif // MEMORY_MONITOR_H
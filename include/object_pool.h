@@ -0,0 +1,200 @@
+/**
+ * @file object_pool.h
+ * @brief Typed fixed-size object pool with per-type statistics
+ *
+ * ObjectPool<T, N> keeps N slots of T in its own storage and hands them out
+ * in O(1) through a free list threaded through the unused slots. Objects
+ * are constructed in place on acquire() and destroyed on release(), so no
+ * heap headers are spent and nothing fragments.
+ *
+ * release() validates the pointer against an in-use bitmap: a pointer that
+ * is not a slot of this pool, or a slot that is already free, is refused
+ * and counted as an error instead of corrupting the free list.
+ *
+ * Each pool registers itself as a memory provider under its type tag, so
+ * its counters show up in the [BUDGET] report without further wiring:
+ *
+ *   static const char msg_tag[] PROGMEM = "pool:Msg";
+ *   static ObjectPool<Msg, 6> msg_pool(msg_tag);
+ *
+ *   [BUDGET] pool:Msg bytes=<n> used=<live*size> peak=<peak*size> fail=<n> err=<n>
+ *
+ * Not interrupt safe by itself: guard acquire/release from different
+ * contexts with ATOMIC_BLOCK or equivalent.
+ */
+
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include "mem_container.h"
+
+template <typename T, uint16_t N>
+class ObjectPool {
+    static_assert(N > 0, "ObjectPool capacity must be at least 1");
+    MEM_BUDGET_ASSERT("ObjectPool", (unsigned long)sizeof(T) * N);
+
+public:
+    typedef T value_type;
+    typedef typename MemSizeFor<N>::type size_type;
+
+    explicit ObjectPool(const char* tag) : free_(slots_), live_(0), peak_(0), failures_(0), errors_(0) {
+        for (size_type i = 0; i + 1 < N; i++) {
+            slots_[i].next = &slots_[i + 1];
+        }
+        slots_[N - 1].next = NULL;
+        for (uint8_t i = 0; i < sizeof(in_use_); i++) {
+            in_use_[i] = 0;
+        }
+
+        provider_.name = tag;
+        provider_.fn = usage;
+        provider_.ctx = this;
+        provider_.counters.bytes = 0;
+        provider_.counters.used = 0;
+        provider_.counters.peak = 0;
+        provider_.counters.failures = 0;
+        provider_.counters.errors = 0;
+        provider_.counters.waste = 0;
+        provider_.flags = mem_provider_flags_for(this);
+        provider_.next = NULL;
+        mem_provider_register(&provider_);
+    }
+
+    /**
+     * @brief Destroy objects still live and leave the registry
+     */
+    ~ObjectPool() {
+        for (size_type i = 0; i < N; i++) {
+            if (is_used(i)) {
+                object(i)->~T();
+            }
+        }
+        mem_provider_unregister(&provider_);
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    /**
+     * @brief Take a slot and construct T in it
+     * @return NULL when the pool is exhausted (counted as a failure)
+     */
+    template <typename... Args>
+    T* acquire(Args&&... args) {
+        Slot* slot = free_;
+        if (slot == NULL) {
+            if (failures_ != 0xFFFF) {
+                failures_++;
+            }
+            return NULL;
+        }
+        free_ = slot->next;
+        set_used(slot - slots_, true);
+
+        live_++;
+        if (live_ > peak_) {
+            peak_ = live_;
+        }
+        return new (slot->storage, MemPlacement()) T(mem_forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Destroy obj and return its slot
+     * @return false if obj is not a live object of this pool (nothing is
+     *         touched and the error counter is incremented); NULL is a no-op
+     */
+    bool release(T* obj) {
+        if (obj == NULL) {
+            return true;
+        }
+        if (!owns(obj)) {
+            note_error();
+            return false;
+        }
+        size_type i = index_of(obj);
+        if (!is_used(i)) {
+            note_error();   // Double release
+            return false;
+        }
+
+        obj->~T();
+        set_used(i, false);
+        slots_[i].next = free_;
+        free_ = &slots_[i];
+        live_--;
+        return true;
+    }
+
+    /**
+     * @brief True if p points at the start of a slot of this pool
+     */
+    bool owns(const T* p) const {
+        const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+        const uint8_t* first = reinterpret_cast<const uint8_t*>(slots_);
+        if (b < first || b >= first + sizeof(slots_)) {
+            return false;
+        }
+        return (uint16_t)(b - first) % sizeof(Slot) == 0;
+    }
+
+    // ------------------------------------------------------------------------
+    // Statistics (objects, not bytes)
+    // ------------------------------------------------------------------------
+
+    static constexpr uint16_t capacity() { return N; }
+    size_type live() const { return live_; }
+    size_type peak() const { return peak_; }
+    uint16_t failures() const { return failures_; }
+    uint16_t errors() const { return errors_; }
+
+private:
+    union Slot {
+        Slot* next;                             // While free
+        alignas(T) uint8_t storage[sizeof(T)];  // While in use
+    };
+
+    T* object(size_type i) { return reinterpret_cast<T*>(slots_[i].storage); }
+
+    size_type index_of(const T* p) const {
+        const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+        return (b - reinterpret_cast<const uint8_t*>(slots_)) / sizeof(Slot);
+    }
+
+    bool is_used(size_type i) const {
+        return in_use_[i >> 3] & (1 << (i & 7));
+    }
+
+    void set_used(size_type i, bool used) {
+        if (used) {
+            in_use_[i >> 3] |= (uint8_t)(1 << (i & 7));
+        } else {
+            in_use_[i >> 3] &= (uint8_t)~(1 << (i & 7));
+        }
+    }
+
+    void note_error() {
+        if (errors_ != 0xFFFF) {
+            errors_++;
+        }
+    }
+
+    static void usage(const MemProvider* provider, MemProviderUsage* u) {
+        const ObjectPool* pool = static_cast<const ObjectPool*>(provider->ctx);
+        u->bytes = sizeof(ObjectPool);
+        u->used = pool->live_ * sizeof(T);
+        u->peak = pool->peak_ * sizeof(T);
+        u->failures = pool->failures_;
+        u->errors = pool->errors_;
+    }
+
+    Slot slots_[N];
+    Slot* free_;
+    uint8_t in_use_[(N + 7) / 8];
+    size_type live_;
+    size_type peak_;
+    uint16_t failures_;
+    uint16_t errors_;
+    MemProvider provider_;
+};
+
+#endif // OBJECT_POOL_H
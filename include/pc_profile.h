@@ -0,0 +1,63 @@
+/**
+ * @file pc_profile.h
+ * @brief Statistical PC-sampling profiler on the Timer1 timebase
+ *
+ * With MEM_MONITOR_PC_PROFILE enabled, Timer1 compare A fires
+ * MEM_PC_PROFILE_HZ times per second on top of the free-running timebase.
+ * Its naked ISR reads the interrupted return address straight off the stack
+ * and records it, together with the interrupted stack depth, in a small
+ * open-addressing hash:
+ *
+ *   key        PC bucket (flash byte address >> MEM_PC_PROFILE_BUCKET_SHIFT)
+ *   count      Samples that landed in the bucket
+ *   max_depth  Deepest stack seen at those samples (RAMEND - SP)
+ *
+ * Each sample costs a fixed ~130 cycles (register saves plus at most
+ * MEM_PC_PROFILE_PROBES hash probes), about 0.8% of the CPU at 1 kHz and
+ * 16 MHz. Samples that find no free entry within the probe limit are
+ * counted as dropped.
+ *
+ * Code that runs with interrupts disabled (including other ISRs) cannot be
+ * sampled; its time is charged to the first instruction after interrupts
+ * are re-enabled. Global interrupts must be enabled by the application.
+ */
+
+#ifndef MEM_PC_PROFILE_H
+#define MEM_PC_PROFILE_H
+
+#include <stdint.h>
+#include "memory_monitor.h"
+
+#if MEM_MONITOR_PC_PROFILE
+
+/**
+ * @brief Hash entry (key 0 = empty)
+ */
+struct PcProfileEntry {
+    uint16_t key;        // PC bucket + 1
+    uint16_t count;      // Samples (saturates at 65535)
+    uint16_t max_depth;  // Deepest stack at a sample (bytes)
+};
+
+/**
+ * @brief Clear the table and start sampling
+ *
+ * Called by mem_monitor_init(). Starts the timebase and schedules the
+ * first Timer1 compare A match.
+ */
+void mem_pc_profile_init(void);
+
+/**
+ * @brief Print and clear the samples collected since the last call
+ *
+ * Output format (pc is the bucket's first flash byte address):
+ * [PROF] samples=<n> dropped=<n> hz=<rate> bucket=<bytes>
+ * [PROF] pc=0x<addr> n=<count> depth=<bytes>
+ *
+ * memprof (tools/memprof) symbolizes and aggregates these lines.
+ */
+void mem_monitor_print_pc_profile(void);
+
+#endif // MEM_MONITOR_PC_PROFILE
+
+#endif // MEM_PC_PROFILE_H
@@ -0,0 +1,157 @@
+/**
+ * @file ring_buffer.h
+ * @brief Fixed-capacity FIFO queue with inline storage (no heap)
+ *
+ * RingBuffer<T, N> queues up to N elements in its own storage. push()
+ * returns false when the queue is full, pop() returns false when it is
+ * empty; nothing throws and nothing allocates. Elements are constructed in
+ * place on push and moved out on pop.
+ *
+ * Not interrupt safe by itself: guard producer/consumer access from
+ * different contexts with ATOMIC_BLOCK or equivalent.
+ *
+ * With MEM_CONTAINER_HIGH_WATER, high_water() reports the deepest queue
+ * seen; wrap the buffer in MemWatched<> to see it in [BUDGET].
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include "mem_container.h"
+
+template <typename T, uint16_t N>
+class RingBuffer : public MemHighWater<typename MemSizeFor<N>::type> {
+    static_assert(N > 0, "RingBuffer capacity must be at least 1");
+    MEM_BUDGET_ASSERT("RingBuffer", (unsigned long)sizeof(T) * N);
+
+public:
+    typedef T value_type;
+    typedef typename MemSizeFor<N>::type size_type;
+
+    RingBuffer() : head_(0), count_(0) {}
+
+    RingBuffer(const RingBuffer& other) : head_(0), count_(0) {
+        for (size_type i = 0; i < other.count_; i++) {
+            push(other.at(i));
+        }
+    }
+
+    RingBuffer(RingBuffer&& other) : head_(0), count_(0) {
+        for (size_type i = 0; i < other.count_; i++) {
+            push(mem_move(other.at(i)));
+        }
+        other.clear();
+    }
+
+    RingBuffer& operator=(const RingBuffer& other) {
+        if (this != &other) {
+            clear();
+            for (size_type i = 0; i < other.count_; i++) {
+                push(other.at(i));
+            }
+        }
+        return *this;
+    }
+
+    RingBuffer& operator=(RingBuffer&& other) {
+        if (this != &other) {
+            clear();
+            for (size_type i = 0; i < other.count_; i++) {
+                push(mem_move(other.at(i)));
+            }
+            other.clear();
+        }
+        return *this;
+    }
+
+    ~RingBuffer() {
+        clear();
+    }
+
+    // ------------------------------------------------------------------------
+    // Capacity
+    // ------------------------------------------------------------------------
+
+    size_type size() const { return count_; }
+    static constexpr uint16_t capacity() { return N; }
+    bool empty() const { return count_ == 0; }
+    bool full() const { return count_ == N; }
+
+    // ------------------------------------------------------------------------
+    // Queue operations
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief Construct an element at the tail
+     * @return false if the queue is full
+     */
+    template <typename... Args>
+    bool emplace(Args&&... args) {
+        if (count_ == N) {
+            return false;
+        }
+        new (slot(index(count_)), MemPlacement()) T(mem_forward<Args>(args)...);
+        count_++;
+        this->note_size(count_);
+        return true;
+    }
+
+    bool push(const T& value) { return emplace(value); }
+    bool push(T&& value) { return emplace(mem_move(value)); }
+
+    /**
+     * @brief Move the head element out
+     * @return false if the queue is empty (out is untouched)
+     */
+    bool pop(T& out) {
+        if (count_ == 0) {
+            return false;
+        }
+        out = mem_move(*slot(head_));
+        drop();
+        return true;
+    }
+
+    /**
+     * @brief Destroy the head element (no-op when empty)
+     */
+    void drop() {
+        if (count_ == 0) {
+            return;
+        }
+        slot(head_)->~T();
+        head_ = head_ + 1 == N ? 0 : head_ + 1;
+        count_--;
+    }
+
+    T& front() { return *slot(head_); }
+    const T& front() const { return *slot(head_); }
+
+    /**
+     * @brief Element i positions behind the head (no bounds check)
+     */
+    T& at(size_type i) { return *slot(index(i)); }
+    const T& at(size_type i) const { return *slot(index(i)); }
+
+    void clear() {
+        while (count_ != 0) {
+            drop();
+        }
+        head_ = 0;
+    }
+
+private:
+    size_type index(size_type i) const {
+        uint16_t pos = (uint16_t)head_ + i;
+        return pos >= N ? pos - N : pos;
+    }
+
+    T* slot(size_type i) { return reinterpret_cast<T*>(storage_) + i; }
+    const T* slot(size_type i) const { return reinterpret_cast<const T*>(storage_) + i; }
+
+    alignas(T) uint8_t storage_[sizeof(T) * N];
+    size_type head_;
+    size_type count_;
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,74 @@
+/**
+ * @file sampling_isr.h
+ * @brief Naked ISR trampoline that hands the interrupted PC and SP to C
+ *
+ * MEM_SAMPLING_ISR(vector, handler) defines a naked interrupt handler that
+ * saves SREG and the call-clobbered registers, reads the interrupted
+ * return address straight off the stack and calls
+ *
+ *   extern "C" void handler(uint16_t pc_word, uint16_t sp);
+ *
+ * with the interrupted PC (flash word address) and the interrupted
+ * context's SP. The handler runs with interrupts disabled and must have C
+ * linkage and be marked used (it is only referenced from assembly).
+ *
+ * Stack layout after the 15 saves: the return address sits at SP+16 (high
+ * byte) and SP+17 (low byte), and the interrupted SP is SP+17.
+ */
+
+#ifndef MEM_SAMPLING_ISR_H
+#define MEM_SAMPLING_ISR_H
+
+#include <avr/interrupt.h>
+#include <stdint.h>
+
+#define MEM_SAMPLING_ISR(vector, handler)                                   \
+    ISR(vector, ISR_NAKED) {                                                \
+        __asm__ __volatile__ (                                              \
+            "push r0                        \n\t"                           \
+            "in   r0, __SREG__              \n\t"                           \
+            "push r0                        \n\t"                           \
+            "push r1                        \n\t"                           \
+            "clr  r1                        \n\t"                           \
+            "push r18                       \n\t"                           \
+            "push r19                       \n\t"                           \
+            "push r20                       \n\t"                           \
+            "push r21                       \n\t"                           \
+            "push r22                       \n\t"                           \
+            "push r23                       \n\t"                           \
+            "push r24                       \n\t"                           \
+            "push r25                       \n\t"                           \
+            "push r26                       \n\t"                           \
+            "push r27                       \n\t"                           \
+            "push r30                       \n\t"                           \
+            "push r31                       \n\t"                           \
+            "in   r30, __SP_L__             \n\t"                           \
+            "in   r31, __SP_H__             \n\t"                           \
+            "ldd  r25, Z+16                 \n\t"                           \
+            "ldd  r24, Z+17                 \n\t"                           \
+            "movw r22, r30                  \n\t"                           \
+            "subi r22, lo8(-17)             \n\t"                           \
+            "sbci r23, hi8(-17)             \n\t"                           \
+            "call " #handler "              \n\t"                           \
+            "pop  r31                       \n\t"                           \
+            "pop  r30                       \n\t"                           \
+            "pop  r27                       \n\t"                           \
+            "pop  r26                       \n\t"                           \
+            "pop  r25                       \n\t"                           \
+            "pop  r24                       \n\t"                           \
+            "pop  r23                       \n\t"                           \
+            "pop  r22                       \n\t"                           \
+            "pop  r21                       \n\t"                           \
+            "pop  r20                       \n\t"                           \
+            "pop  r19                       \n\t"                           \
+            "pop  r18                       \n\t"                           \
+            "pop  r1                        \n\t"                           \
+            "pop  r0                        \n\t"                           \
+            "out  __SREG__, r0              \n\t"                           \
+            "pop  r0                        \n\t"                           \
+            "reti                           \n\t"                           \
+            ::: "memory"                                                    \
+        );                                                                  \
+    }
+
+#endif // MEM_SAMPLING_ISR_H
@@ -0,0 +1,98 @@
+/**
+ * @file stack_limit.h
+ * @brief Emulated stack-limit register with fault on breach
+ *
+ * AVR has no stack-limit hardware. With MEM_MONITOR_STACK_LIMIT enabled
+ * the monitor keeps a floor MEM_STACK_LIMIT_MARGIN bytes above the heap end
+ * (__brkval, or __heap_start before the first malloc) and compares SP
+ * against it:
+ *
+ * - In a Timer1 compare B ISR, MEM_STACK_LIMIT_HZ times per second
+ *   (source "timer", pc = interrupted instruction)
+ * - In the malloc wrapper after the heap grew (source "malloc", pc = caller)
+ * - Wherever MEM_STACK_CHECK() is placed, typically first thing in deep or
+ *   recursive functions (source "check", pc = caller)
+ *
+ * A breach writes a crash record to .noinit SRAM, prints
+ *
+ *   [FAULT] stack-limit src=<source> pc=0x<addr> sp=0x<sp> floor=0x<floor> heap=0x<end>
+ *
+ * With MEM_STACK_LIMIT_RESET the MCU is then reset through the watchdog;
+ * the record survives the reset and mem_monitor_init() prints it again
+ * with "reset=1". Without reset the fault is reported once until SP is
+ * back above the floor.
+ *
+ * The timer check needs global interrupts; the other two work without.
+ */
+
+#ifndef MEM_STACK_LIMIT_H
+#define MEM_STACK_LIMIT_H
+
+#include <stdint.h>
+#include "memory_monitor.h"
+
+#if MEM_MONITOR_STACK_LIMIT
+
+#define MEM_CRASH_MAGIC 0x5343  // "SC"
+
+/**
+ * @brief Where a breach was detected
+ */
+enum MemFaultSource {
+    MEM_FAULT_SRC_TIMER,
+    MEM_FAULT_SRC_MALLOC,
+    MEM_FAULT_SRC_CHECK
+};
+
+/**
+ * @brief Last stack-limit breach, kept in .noinit across resets
+ */
+struct MemCrashRecord {
+    uint16_t magic;      // MEM_CRASH_MAGIC when the record is valid
+    uint8_t source;      // MemFaultSource
+    uint8_t reset;       // 1 if the monitor reset the MCU afterwards
+    uint16_t pc;         // Flash byte address
+    uint16_t sp;         // SP at the breach
+    uint16_t floor;      // Stack limit at the breach
+    uint16_t heap_end;   // Heap end at the breach
+};
+
+extern MemCrashRecord mem_crash_record;
+
+/**
+ * @brief Start the periodic check and report a record left by a reset
+ *
+ * Called by mem_monitor_init().
+ */
+void mem_stack_limit_init(void);
+
+/**
+ * @brief Current stack limit (lowest SP that does not fault)
+ */
+uint16_t mem_monitor_stack_floor(void);
+
+/**
+ * @brief Compare SP against the limit (use through MEM_STACK_CHECK)
+ */
+void mem_monitor_stack_check(void);
+
+/**
+ * @brief Check after the heap grew (called by the malloc wrapper)
+ * @param caller Flash byte address of the malloc() caller
+ */
+void mem_stack_limit_after_malloc(uint16_t caller);
+
+/**
+ * @brief Follow a heap shrink (called by the free wrapper)
+ */
+void mem_stack_limit_after_free(void);
+
+#define MEM_STACK_CHECK() mem_monitor_stack_check()
+
+#else
+
+#define MEM_STACK_CHECK() do { } while (0)
+
+#endif // MEM_MONITOR_STACK_LIMIT
+
+#endif // MEM_STACK_LIMIT_H
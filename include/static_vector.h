@@ -0,0 +1,165 @@
+/**
+ * @file static_vector.h
+ * @brief Fixed-capacity vector with inline storage (no heap)
+ *
+ * StaticVector<T, N> holds up to N elements in its own storage, so it lives
+ * wherever the object lives: .bss for globals, the stack for locals. There
+ * are no exceptions; operations that would exceed the capacity return false
+ * and leave the vector unchanged. Elements are constructed in place and
+ * moved rather than copied where possible.
+ *
+ * With MEM_CONTAINER_HIGH_WATER, high_water() reports the most elements
+ * held at once; wrap the vector in MemWatched<> to see it in [BUDGET].
+ */
+
+#ifndef STATIC_VECTOR_H
+#define STATIC_VECTOR_H
+
+#include "mem_container.h"
+
+template <typename T, uint16_t N>
+class StaticVector : public MemHighWater<typename MemSizeFor<N>::type> {
+    static_assert(N > 0, "StaticVector capacity must be at least 1");
+    MEM_BUDGET_ASSERT("StaticVector", (unsigned long)sizeof(T) * N);
+
+public:
+    typedef T value_type;
+    typedef typename MemSizeFor<N>::type size_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    StaticVector() : size_(0) {}
+
+    StaticVector(const StaticVector& other) : size_(0) {
+        for (size_type i = 0; i < other.size_; i++) {
+            push_back(other[i]);
+        }
+    }
+
+    StaticVector(StaticVector&& other) : size_(0) {
+        for (size_type i = 0; i < other.size_; i++) {
+            push_back(mem_move(other[i]));
+        }
+        other.clear();
+    }
+
+    StaticVector& operator=(const StaticVector& other) {
+        if (this != &other) {
+            clear();
+            for (size_type i = 0; i < other.size_; i++) {
+                push_back(other[i]);
+            }
+        }
+        return *this;
+    }
+
+    StaticVector& operator=(StaticVector&& other) {
+        if (this != &other) {
+            clear();
+            for (size_type i = 0; i < other.size_; i++) {
+                push_back(mem_move(other[i]));
+            }
+            other.clear();
+        }
+        return *this;
+    }
+
+    ~StaticVector() {
+        clear();
+    }
+
+    // ------------------------------------------------------------------------
+    // Capacity
+    // ------------------------------------------------------------------------
+
+    size_type size() const { return size_; }
+    static constexpr uint16_t capacity() { return N; }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == N; }
+
+    // ------------------------------------------------------------------------
+    // Element access (no bounds checks, like the built-in array)
+    // ------------------------------------------------------------------------
+
+    T& operator[](size_type i) { return data()[i]; }
+    const T& operator[](size_type i) const { return data()[i]; }
+    T& front() { return data()[0]; }
+    T& back() { return data()[size_ - 1]; }
+    T* data() { return reinterpret_cast<T*>(storage_); }
+    const T* data() const { return reinterpret_cast<const T*>(storage_); }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + size_; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size_; }
+
+    // ------------------------------------------------------------------------
+    // Modifiers
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief Construct an element at the end
+     * @return false if the vector is full
+     */
+    template <typename... Args>
+    bool emplace_back(Args&&... args) {
+        if (size_ == N) {
+            return false;
+        }
+        new (data() + size_, MemPlacement()) T(mem_forward<Args>(args)...);
+        size_++;
+        this->note_size(size_);
+        return true;
+    }
+
+    bool push_back(const T& value) { return emplace_back(value); }
+    bool push_back(T&& value) { return emplace_back(mem_move(value)); }
+
+    /**
+     * @brief Destroy the last element (no-op when empty)
+     */
+    void pop_back() {
+        if (size_ != 0) {
+            size_--;
+            data()[size_].~T();
+        }
+    }
+
+    /**
+     * @brief Remove element i, moving the tail down (keeps order)
+     */
+    void erase(size_type i) {
+        if (i >= size_) {
+            return;
+        }
+        for (size_type j = i + 1; j < size_; j++) {
+            data()[j - 1] = mem_move(data()[j]);
+        }
+        pop_back();
+    }
+
+    /**
+     * @brief Remove element i by moving the last element into its place
+     */
+    void erase_unordered(size_type i) {
+        if (i >= size_) {
+            return;
+        }
+        if (i != size_ - 1) {
+            data()[i] = mem_move(data()[size_ - 1]);
+        }
+        pop_back();
+    }
+
+    void clear() {
+        while (size_ != 0) {
+            pop_back();
+        }
+    }
+
+private:
+    alignas(T) uint8_t storage_[sizeof(T) * N];
+    size_type size_;
+};
+
+#endif // STATIC_VECTOR_H
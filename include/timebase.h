@@ -0,0 +1,70 @@
+/**
+ * @file timebase.h
+ * @brief Free-running Timer1 cycle counter shared by the monitor's profilers
+ * 
+ * Timer1 runs in normal mode with no prescaler, so TCNT1 counts CPU cycles
+ * (62.5 ns at 16 MHz) and wraps every 65536 cycles (4.096 ms). Intervals
+ * shorter than one wrap are measured as an unsigned 16-bit difference.
+ * 
+ * Longer intervals (reporting windows) need timebase_enable_overflow(),
+ * which counts wraps in a short Timer1 overflow ISR and makes
+ * timebase_now32() available. Both exist only with MEM_MONITOR_ISR_PROFILE,
+ * their one user, so other builds leave TIMER1_OVF_vect to the application.
+ * 
+ * The compare units (OCR1A/OCR1B) stay free for periodic work scheduled on
+ * top of the timebase. Applications using the monitor's timing features
+ * must not reconfigure Timer1.
+ */
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <avr/io.h>
+#include <stdint.h>
+#include "memory_monitor.h"
+
+/**
+ * @brief Start Timer1 as a free-running cycle counter
+ * 
+ * Safe to call more than once; the counter is not reset when it is
+ * already running.
+ */
+void timebase_init(void);
+
+/**
+ * @brief Current cycle count (mod 65536)
+ * 
+ * The 16-bit read goes through the shared TEMP register; call with
+ * interrupts disabled or from ISRs only when no other context reads
+ * Timer1 concurrently.
+ */
+static inline uint16_t timebase_now(void) {
+    return TCNT1;
+}
+
+/**
+ * @brief Cycles elapsed since an earlier timebase_now() value
+ */
+static inline uint16_t timebase_since(uint16_t start) {
+    return (uint16_t)(TCNT1 - start);
+}
+
+#if MEM_MONITOR_ISR_PROFILE
+/**
+ * @brief Count Timer1 overflows for timebase_now32()
+ * 
+ * Enables the Timer1 overflow interrupt (one ISR every 65536 cycles).
+ * Overflows are only counted while global interrupts are enabled.
+ */
+void timebase_enable_overflow(void);
+
+/**
+ * @brief Extended cycle count (wraps after 2^32 cycles, ~268 s at 16 MHz)
+ * 
+ * Combines the overflow count with TCNT1 and accounts for an overflow
+ * that is pending but not yet serviced.
+ */
+uint32_t timebase_now32(void);
+#endif // MEM_MONITOR_ISR_PROFILE
+
+#endif // TIMEBASE_H
@@ -50,6 +50,12 @@ void uart_puts_P(const char* str);
  */
 void uart_print_u16(uint16_t value);
 
+/**
+ * @brief Print unsigned 32-bit integer as decimal
+ * @param value Value to print
+ */
+void uart_print_u32(uint32_t value);
+
 /**
  * @brief Print unsigned 16-bit integer as hexadecimal
  * @param value Value to print
@@ -0,0 +1,128 @@
+/**
+ * @file alloc_failure.cpp
+ * @brief Failed-allocation snapshots, size-class histogram and report
+ */
+
+#include "alloc_failure.h"
+
+#if MEM_MONITOR_ALLOC_FORENSICS
+
+#include "heap_walk.h"
+#include "uart_driver.h"
+#include <avr/pgmspace.h>
+#if MEM_MONITOR_ISR_PROFILE
+#include "timebase.h"
+#endif
+
+static MemAllocFailStats s_fail;
+
+/**
+ * @brief Size class of a request: 0 for <=8 bytes, doubling up to >512
+ */
+static uint8_t size_class(uint16_t size) {
+    uint8_t cls = 0;
+    uint16_t bound = 8;
+    while (size > bound && cls < MEM_ALLOC_FAIL_CLASSES - 1) {
+        bound <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+static void print_failure(const MemAllocFailure* f) {
+    uart_puts_P(PSTR("[ALLOCFAIL] kind="));
+    uart_puts_P(f->kind == MEM_ALLOC_FAIL_FRAG ? PSTR("FRAG") : PSTR("OOM"));
+    uart_puts_P(PSTR(" size="));
+    uart_print_u16(f->size);
+    uart_puts_P(PSTR(" pc="));
+    uart_print_hex16(f->pc);
+    uart_puts_P(PSTR(" largest="));
+    uart_print_u16(f->largest);
+    uart_puts_P(PSTR(" free="));
+    uart_print_u16(f->total_free);
+    uart_puts_P(PSTR(" gap="));
+    uart_print_u16(f->gap);
+    uart_puts_P(PSTR(" seq="));
+    uart_print_u16(f->seq);
+    uart_puts_P(PSTR(" tick="));
+    uart_print_u16(f->tick);
+#if MEM_MONITOR_ISR_PROFILE
+    uart_puts_P(PSTR(" t="));
+    uart_print_u32(f->cycles);
+#endif
+    uart_newline();
+}
+
+void mem_alloc_failure_record(uint16_t size, uint16_t caller) {
+    MemHeapFree heap;
+    mem_heap_free_space(&heap);
+
+    MemoryStats stats;
+    mem_monitor_get_stats(&stats);
+
+    MemAllocFailure* f = &s_fail.last;
+    f->kind = heap.total >= size ? MEM_ALLOC_FAIL_FRAG : MEM_ALLOC_FAIL_OOM;
+    f->size = size;
+    f->pc = caller;
+    f->largest = heap.largest;
+    f->total_free = heap.total;
+    f->gap = stats.free_ram;
+    f->seq = stats.alloc_count + s_fail.count;
+    f->tick = mem_monitor_get_update_count();
+#if MEM_MONITOR_ISR_PROFILE
+    f->cycles = timebase_now32();
+#else
+    f->cycles = 0;
+#endif
+
+    if (s_fail.count != 0xFFFF) {
+        s_fail.count++;
+    }
+    uint16_t* kind_count = f->kind == MEM_ALLOC_FAIL_FRAG ? &s_fail.frag : &s_fail.oom;
+    if (*kind_count != 0xFFFF) {
+        (*kind_count)++;
+    }
+    uint16_t* class_count = &s_fail.by_class[size_class(size)];
+    if (*class_count != 0xFFFF) {
+        (*class_count)++;
+    }
+
+    print_failure(f);
+}
+
+const MemAllocFailStats* mem_monitor_get_alloc_failures(void) {
+    return &s_fail;
+}
+
+void mem_monitor_print_alloc_failures(void) {
+    uart_puts_P(PSTR("[ALLOCFAIL] count="));
+    uart_print_u16(s_fail.count);
+    uart_puts_P(PSTR(" oom="));
+    uart_print_u16(s_fail.oom);
+    uart_puts_P(PSTR(" frag="));
+    uart_print_u16(s_fail.frag);
+    uart_puts_P(PSTR(" classes="));
+    uint16_t bound = 8;
+    for (uint8_t i = 0; i < MEM_ALLOC_FAIL_CLASSES; i++) {
+        if (i != 0) {
+            uart_putc(',');
+        }
+        if (i < MEM_ALLOC_FAIL_CLASSES - 1) {
+            uart_puts_P(PSTR("<="));
+            uart_print_u16(bound);
+        } else {
+            uart_putc('>');
+            uart_print_u16(bound >> 1);
+        }
+        uart_putc(':');
+        uart_print_u16(s_fail.by_class[i]);
+        bound <<= 1;
+    }
+    uart_newline();
+
+    if (s_fail.count != 0) {
+        print_failure(&s_fail.last);
+    }
+}
+
+#endif // MEM_MONITOR_ALLOC_FORENSICS
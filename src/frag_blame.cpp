@@ -0,0 +1,133 @@
+/**
+ * @file frag_blame.cpp
+ * @brief Pinning-block search over the heap walk
+ */
+
+#include "frag_blame.h"
+#include "heap_walk.h"
+#include "uart_driver.h"
+#include <avr/pgmspace.h>
+#include <stddef.h>
+
+// Chunk header bytes (avr-libc size field)
+#define CHUNK_HEADER sizeof(size_t)
+
+/**
+ * @brief Walk state: a three-chunk window and the ranking so far
+ */
+struct BlameWalk {
+    MemHeapChunk prev;   // Chunk below the candidate
+    MemHeapChunk cand;   // Candidate block
+    uint8_t seen;        // Chunks in the window (saturates at 2)
+    uint8_t found;       // Pinning blocks (saturating)
+    MemFragBlame* out;
+    uint8_t max;
+};
+
+/**
+ * @brief Insert into the ranking, largest release first
+ */
+static void rank(BlameWalk* w, const MemHeapChunk* block, uint16_t span) {
+    uint8_t ranked = w->found < w->max ? w->found : w->max;
+    if (w->found != 0xFF) {
+        w->found++;
+    }
+
+    uint16_t release = span - CHUNK_HEADER;
+    uint8_t i = ranked;
+    if (i == w->max) {
+        if (i == 0 || release <= w->out[i - 1].release) {
+            return;
+        }
+        i--;   // Drop the smallest
+    }
+    while (i > 0 && w->out[i - 1].release < release) {
+        w->out[i] = w->out[i - 1];
+        i--;
+    }
+    w->out[i].ptr = block->ptr;
+    w->out[i].size = block->size;
+    w->out[i].release = release;
+}
+
+static void visit(const MemHeapChunk* chunk, void* ctx) {
+    BlameWalk* w = static_cast<BlameWalk*>(ctx);
+
+    // A live block between two holes merges all three when freed
+    if (w->seen == 2 && w->prev.free && !w->cand.free && chunk->free) {
+        rank(w, &w->cand, (w->prev.size + CHUNK_HEADER) +
+                          (w->cand.size + CHUNK_HEADER) +
+                          (chunk->size + CHUNK_HEADER));
+    }
+
+    w->prev = w->cand;
+    w->cand = *chunk;
+    if (w->seen < 2) {
+        w->seen++;
+    }
+}
+
+uint8_t mem_heap_find_pinning(MemFragBlame* out, uint8_t max) {
+    BlameWalk w;
+    w.seen = 0;
+    w.found = 0;
+    w.out = out;
+    w.max = max;
+    mem_heap_walk(visit, &w);
+
+    // The last chunk is never free (free() gives it back to the top), so a
+    // hole right below it is held away from the top by that block alone
+    if (w.seen == 2 && w.prev.free && !w.cand.free) {
+        rank(&w, &w.cand, (w.prev.size + CHUNK_HEADER) +
+                          (w.cand.size + CHUNK_HEADER) + mem_heap_top_room());
+    }
+    return w.found;
+}
+
+void mem_monitor_print_frag_blame(void) {
+    MemFragBlame blame[MEM_FRAG_BLAME_TOP];
+    uint8_t found = mem_heap_find_pinning(blame, MEM_FRAG_BLAME_TOP);
+    uint8_t chunks = mem_heap_walk(NULL, NULL);
+
+    MemHeapFree heap;
+    mem_heap_free_space(&heap);
+
+    uart_puts_P(PSTR("[BLAME] chunks="));
+    uart_print_u16(chunks);
+    uart_puts_P(PSTR(" holes="));
+    uart_print_u16(heap.chunks);
+    uart_puts_P(PSTR(" largest="));
+    uart_print_u16(heap.largest);
+    uart_puts_P(PSTR(" pinned="));
+    uart_print_u16(found);
+    uart_newline();
+
+#if MEM_MONITOR_FRAG_BLAME
+    MemoryStats stats;
+    mem_monitor_get_stats(&stats);
+#endif
+
+    uint8_t listed = found < MEM_FRAG_BLAME_TOP ? found : MEM_FRAG_BLAME_TOP;
+    for (uint8_t i = 0; i < listed; i++) {
+        uart_puts_P(PSTR("[BLAME] ptr="));
+        uart_print_hex16((uint16_t)blame[i].ptr);
+        uart_puts_P(PSTR(" size="));
+        uart_print_u16(blame[i].size);
+        uart_puts_P(PSTR(" release="));
+        uart_print_u16(blame[i].release);
+
+        uint16_t callsite;
+        uint16_t seq;
+        if (mem_monitor_find_alloc(blame[i].ptr, &callsite, &seq)) {
+            if (callsite != 0) {
+                uart_puts_P(PSTR(" pc="));
+                uart_print_hex16(callsite);
+            }
+#if MEM_MONITOR_FRAG_BLAME
+            uart_puts_P(PSTR(" age="));
+            uart_print_u16(stats.alloc_count - seq);
+#endif
+        }
+        uart_newline();
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * @file heap_walk.cpp
+ * @brief avr-libc free-list walk
+ */
+
+#include "heap_walk.h"
+#include "memory_monitor.h"
+#include <stddef.h>
+
+// avr-libc allocator internals (stdlib_private.h)
+struct __freelist {
+    size_t sz;
+    struct __freelist* nx;
+};
+
+extern "C" {
+    extern struct __freelist* __flp;
+    extern char* __malloc_heap_end;
+    extern size_t __malloc_margin;
+}
+
+extern uint8_t __heap_start;
+extern uint8_t *__brkval;
+
+void mem_heap_free_space(MemHeapFree* out) {
+    out->largest = 0;
+    out->total = 0;
+    out->chunks = 0;
+
+    for (const struct __freelist* fp = __flp; fp != NULL; fp = fp->nx) {
+        if (fp->sz > out->largest) {
+            out->largest = fp->sz;
+        }
+        out->total += fp->sz;
+        if (out->chunks != 0xFF) {
+            out->chunks++;
+        }
+    }
+
+    // A new chunk needs room for its size header
+    uint16_t room = mem_heap_top_room();
+    out->top = room > sizeof(size_t) ? room - sizeof(size_t) : 0;
+    if (out->top > out->largest) {
+        out->largest = out->top;
+    }
+    out->total += out->top;
+}
+
+uint16_t mem_heap_top_room(void) {
+    // Same limit malloc() uses when it extends the heap
+    uint8_t* heap_end = __brkval ? __brkval : &__heap_start;
+    uint8_t* limit = (uint8_t*)__malloc_heap_end;
+    if (limit == NULL) {
+        limit = (uint8_t*)(mem_monitor_get_stack_pointer() - __malloc_margin);
+    }
+    return limit > heap_end ? (uint16_t)(limit - heap_end) : 0;
+}
+
+uint8_t mem_heap_walk(MemHeapChunkFn fn, void* ctx) {
+    uint8_t* heap_end = __brkval ? __brkval : &__heap_start;
+    const struct __freelist* fp = __flp;
+    uint8_t count = 0;
+
+    uint8_t* p = &__heap_start;
+    while (p + sizeof(size_t) <= heap_end) {
+        MemHeapChunk chunk;
+        chunk.size = *(size_t*)p;
+        chunk.ptr = p + sizeof(size_t);
+        if (chunk.ptr + chunk.size > heap_end) {
+            break;
+        }
+
+        // The free list is address-ordered, so one cursor follows the walk
+        while (fp != NULL && (uint8_t*)fp < p) {
+            fp = fp->nx;
+        }
+        chunk.free = (uint8_t*)fp == p;
+
+        if (fn != NULL) {
+            fn(&chunk, ctx);
+        }
+        if (count != 0xFF) {
+            count++;
+        }
+        p = chunk.ptr + chunk.size;
+    }
+    return count;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file isr_profile.cpp
+ * @brief ISR profiler state and window reports
+ */
+
+#include "isr_profile.h"
+
+#if MEM_MONITOR_ISR_PROFILE
+
+#include "uart_driver.h"
+#include <string.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+IsrProfileStats mem_isr_stats[MEM_ISR_PROFILE_SLOTS];
+uint8_t mem_isr_depth;
+uint16_t mem_isr_child_cycles;
+
+// Slot names (PROGMEM strings), set by constructors before main()
+static const char* s_names[MEM_ISR_PROFILE_SLOTS];
+
+// Timebase at the start of the current reporting window
+static uint32_t s_window_start;
+
+static void reset_slot(IsrProfileStats* s) {
+    memset(s, 0, sizeof(*s));
+    s->min_cycles = 0xFFFF;
+}
+
+// ============================================================================
+// SETUP
+// ============================================================================
+
+void mem_isr_profile_register(uint8_t slot, const char* name) {
+    if (slot < MEM_ISR_PROFILE_SLOTS) {
+        s_names[slot] = name;
+    }
+}
+
+void mem_isr_profile_init(void) {
+    timebase_init();
+    timebase_enable_overflow();
+
+    MEM_CRITICAL_ENTER(MEM_CS_ISR_PROFILE);
+    for (uint8_t i = 0; i < MEM_ISR_PROFILE_SLOTS; i++) {
+        reset_slot(&mem_isr_stats[i]);
+    }
+    s_window_start = timebase_now32();
+    MEM_CRITICAL_EXIT(MEM_CS_ISR_PROFILE);
+}
+
+// ============================================================================
+// REPORTING
+// ============================================================================
+
+void mem_monitor_print_isr_profile(void) {
+    uint32_t now = timebase_now32();
+    uint32_t window = now - s_window_start;
+    s_window_start = now;
+
+    uint32_t window_ms = window / (F_CPU / 1000UL);
+    uart_puts_P(PSTR("[ISR] window="));
+    uart_print_u16(window_ms > 0xFFFF ? 0xFFFF : (uint16_t)window_ms);
+    uart_puts_P(PSTR(" ms\r\n"));
+
+    for (uint8_t i = 0; i < MEM_ISR_PROFILE_SLOTS; i++) {
+        if (s_names[i] == NULL) {
+            continue;
+        }
+
+        // Take the window's values and start the next one per slot, so
+        // interrupts are only held off for one slot copy at a time
+        IsrProfileStats snap;
+        MEM_CRITICAL_ENTER(MEM_CS_ISR_PROFILE);
+        snap = mem_isr_stats[i];
+        reset_slot(&mem_isr_stats[i]);
+        MEM_CRITICAL_EXIT(MEM_CS_ISR_PROFILE);
+
+        uart_puts_P(PSTR("[ISR] "));
+        uart_puts_P(s_names[i]);
+        uart_puts_P(PSTR(" n="));
+        uart_print_u16(snap.count);
+
+        uart_puts_P(PSTR(" rate="));
+        uint32_t rate = window_ms ? (uint32_t)snap.count * 1000UL / window_ms : 0;
+        uart_print_u16(rate > 0xFFFF ? 0xFFFF : (uint16_t)rate);
+        uart_puts_P(PSTR("/s"));
+
+        uart_puts_P(PSTR(" min="));
+        uart_print_u16(snap.count ? snap.min_cycles : 0);
+        uart_puts_P(PSTR(" avg="));
+        uart_print_u16(snap.count ? (uint16_t)(snap.total_cycles / snap.count) : 0);
+        uart_puts_P(PSTR(" max="));
+        uart_print_u16(snap.max_cycles);
+
+        uart_puts_P(PSTR(" load="));
+        uart_print_float(window ? 100.0f * (float)snap.total_cycles / (float)window : 0.0f);
+        uart_puts_P(PSTR("% nest="));
+        uart_print_u16(snap.nested);
+        uart_puts_P(PSTR(" stack="));
+        uart_print_u16(snap.max_stack);
+        uart_newline();
+    }
+}
+
+#endif // MEM_MONITOR_ISR_PROFILE
@@ -13,14 +13,27 @@
  * 2. Recursive stack stress test
  * 3. Heap fragmentation test (alternating alloc/free)
  * 4. Large buffer stress test
+ * 5. Two-ended heap (long-lived blocks among transient ones)
+ * 6. Cooperative tasks sharing one stack (continuous mode)
  */
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 #include <util/delay.h>
 #include <stdlib.h>
 #include "uart_driver.h"
 #include "memory_monitor.h"
+#include "isr_profile.h"
+#include "pc_profile.h"
+#include "stack_limit.h"
+#include "mem_provider.h"
+#include "mem_allocator.h"
+#include "mem_arena.h"
+#include "mem_task.h"
+#include "alloc_failure.h"
+#include "frag_blame.h"
+#include "mem_dual_heap.h"
 
 // ============================================================================
 // CONFIGURATION
@@ -33,6 +46,87 @@
 #define UART_BAUD 115200
 #define DIAGNOSTIC_INTERVAL_MS 2000
 
+// Stack needed by large_buffer_test(): 256-byte buffer plus frames
+#define LARGE_BUFFER_STACK 320
+
+#if MEM_MONITOR_ISR_PROFILE
+// ============================================================================
+// DEMO INTERRUPT LOAD
+// ============================================================================
+
+// Millisecond tick, gives the ISR profiler a known load to report
+static volatile uint16_t s_tick_count;
+
+MEM_ISR(TIMER2_COMPA_vect, 0) {
+    s_tick_count++;
+}
+
+/**
+ * @brief Start Timer2 as a 1 kHz tick (CTC, clk/64, 250 counts)
+ */
+static void demo_tick_init(void) {
+    TCCR2A = (1 << WGM21);
+    TCCR2B = (1 << CS22);
+    OCR2A = (F_CPU / 64 / 1000) - 1;
+    TIMSK2 = (1 << OCIE2A);
+}
+#endif
+
+// ============================================================================
+// DEMO TASKS
+// ============================================================================
+
+// Counts scheduler passes; checksum waits on it
+struct TickState {
+    uint16_t ticks;
+};
+
+// Checksums a stack buffer every 50 ticks (its stack cost shows per task)
+struct ChecksumState {
+    uint16_t next_tick;
+    uint8_t sum;
+};
+
+static TickState s_tick_state;
+static ChecksumState s_checksum_state;
+
+static MemTaskStatus tick_task(MemTask* t) {
+    TickState* s = (TickState*)t->state;
+    MEM_TASK_BEGIN(t);
+    for (;;) {
+        s->ticks++;
+        MEM_TASK_YIELD(t);
+    }
+    MEM_TASK_END(t);
+}
+
+static MemTaskStatus checksum_task(MemTask* t) {
+    ChecksumState* s = (ChecksumState*)t->state;
+    MEM_TASK_BEGIN(t);
+    for (;;) {
+        s->next_tick = s_tick_state.ticks + 50;
+        MEM_TASK_WAIT_UNTIL(t, (int16_t)(s_tick_state.ticks - s->next_tick) >= 0);
+        {
+            // Locals are scratch only: they do not survive a yield
+            volatile uint8_t block[48];
+            uint8_t sum = 0;
+            for (uint8_t i = 0; i < sizeof(block); i++) {
+                block[i] = i ^ s->sum;
+                sum += block[i];
+            }
+            s->sum = sum;
+        }
+    }
+    MEM_TASK_END(t);
+}
+
+static const char tick_task_name[] PROGMEM = "task:tick";
+static const char checksum_task_name[] PROGMEM = "task:checksum";
+
+static MemTask s_tick_task = MEM_TASK_INIT(tick_task_name, tick_task, s_tick_state);
+static MemTask s_checksum_task =
+    MEM_TASK_INIT(checksum_task_name, checksum_task, s_checksum_state);
+
 // ============================================================================
 // TEST FUNCTIONS
 // ============================================================================
@@ -49,6 +143,8 @@
  * This demonstrates stack growth detection and max usage tracking.
  */
 void recursive_stack_test(uint8_t depth) {
+    MEM_STACK_CHECK();
+    
     // Local buffer to consume stack space
     volatile char buffer[32];
     
@@ -118,6 +214,7 @@ void heap_fragmentation_test(void) {
     uart_puts_P(PSTR("  Fragmentation: "));
     uart_print_float(mem_monitor_get_fragmentation_ratio() * 100.0f);
     uart_puts_P(PSTR("%\r\n"));
+    mem_monitor_print_frag_blame();   // Blocks 2, 4 and 6 pin the holes
     
     // Allocate new blocks (may not fit in fragmented space)
     uart_puts_P(PSTR("Allocating new blocks...\r\n"));
@@ -229,6 +326,170 @@ void combined_stress_test(void) {
     uart_puts_P(PSTR("Heap blocks freed\r\n\r\n"));
 }
 
+// ============================================================================
+// DEMO CONTAINER
+// ============================================================================
+
+/**
+ * @brief Minimal growable array on an allocator (avr-libc has no STL)
+ *
+ * Grows like std::vector: allocate the doubled capacity, copy, then free
+ * the old block, so the tag sees every reallocation. T must be trivially
+ * copyable.
+ */
+template <typename T, typename Alloc>
+class DemoList {
+public:
+    typedef T value_type;
+
+    explicit DemoList(const Alloc& alloc) : alloc_(alloc), data_(NULL), size_(0), capacity_(0) {}
+
+    ~DemoList() {
+        alloc_.deallocate(data_, capacity_);
+    }
+
+    DemoList(const DemoList&) = delete;
+    DemoList& operator=(const DemoList&) = delete;
+
+    bool reserve(uint16_t capacity) {
+        if (capacity <= capacity_) {
+            return true;
+        }
+        T* data = alloc_.allocate(capacity);
+        if (data == NULL) {
+            return false;
+        }
+        for (uint16_t i = 0; i < size_; i++) {
+            data[i] = data_[i];
+        }
+        alloc_.deallocate(data_, capacity_);
+        data_ = data;
+        capacity_ = capacity;
+        return true;
+    }
+
+    bool push_back(const T& value) {
+        if (size_ == capacity_ && !reserve(capacity_ ? capacity_ * 2 : 2)) {
+            return false;
+        }
+        data_[size_++] = value;
+        return true;
+    }
+
+    uint16_t size() const { return size_; }
+
+private:
+    Alloc alloc_;
+    T* data_;
+    uint16_t size_;
+    uint16_t capacity_;
+};
+
+static const char dual_heap_name[] PROGMEM = "dual:demo";
+static uint8_t s_dual_heap_buf[192];
+static MemDualHeap s_dual_heap(dual_heap_name, s_dual_heap_buf, sizeof(s_dual_heap_buf));
+
+// Container storage outlives the transient buffers: pin it to the top
+typedef MonitoredAllocator<uint16_t, MemDualHeapBackend> DualAlloc;
+static MemDualHeapBackend s_dual_long(&s_dual_heap, MEM_LIFETIME_LONG);
+static const char dual_tag_name[] PROGMEM = "list:dual";
+static MemAllocTag s_dual_tag(dual_tag_name);
+
+/**
+ * @brief Keep a small block every other round between transient buffers
+ * 
+ * In a first-fit heap each kept block would land right after the live
+ * transient one and split the space. Here kept blocks go to the top and
+ * the transient buffer is reused at the bottom.
+ */
+void dual_heap_test(void) {
+    uart_puts_P(PSTR("\r\n=== Two-Ended Heap Test ===\r\n"));
+    
+    void* kept[4];
+    uint8_t count = 0;
+    for (uint8_t round = 0; round < 8; round++) {
+        void* transient = s_dual_heap.allocate(40, MEM_LIFETIME_SHORT);
+        if (round & 1) {
+            kept[count++] = s_dual_heap.allocate(12, MEM_LIFETIME_LONG);
+        }
+        s_dual_heap.deallocate(transient);
+    }
+    
+    uart_puts_P(PSTR("  Kept 4 blocks, largest free: "));
+    uart_print_u16(s_dual_heap.largest_free());
+    uart_puts_P(PSTR(" bytes\r\n"));
+    mem_monitor_print_dual_heaps();
+    
+    {
+        // Grows through the allocator; every block lands on the long side
+        DemoList<uint16_t, DualAlloc> ids(DualAlloc(&s_dual_long, &s_dual_tag));
+        for (uint16_t i = 0; i < 4; i++) {
+            ids.push_back(i);
+        }
+        mem_alloc_sample(&s_dual_tag, ids);
+        uart_puts_P(PSTR("  Container on the long side\r\n"));
+        mem_monitor_print_dual_heaps();
+    }
+    
+    for (uint8_t i = 0; i < count; i++) {
+        s_dual_heap.deallocate(kept[i]);
+    }
+    uart_newline();
+}
+
+// ============================================================================
+// MONITORED ALLOCATOR DEMO
+// ============================================================================
+
+typedef MemBlockPool<16, 3> ListPool;
+typedef MonitoredAllocator<uint16_t, ListPool> SampleAlloc;
+typedef MonitoredAllocator<uint32_t, MemArena> EventAlloc;
+
+static const char list_pool_name[] PROGMEM = "pool:list";
+static ListPool s_list_pool(list_pool_name);
+
+static const char scratch_name[] PROGMEM = "arena:scratch";
+static uint8_t s_scratch_buf[32];
+static MemArena s_scratch(scratch_name, s_scratch_buf, sizeof(s_scratch_buf));
+
+static const char samples_tag_name[] PROGMEM = "list:samples";
+static MemAllocTag s_samples_tag(samples_tag_name);
+static const char events_tag_name[] PROGMEM = "list:events";
+static MemAllocTag s_events_tag(events_tag_name);
+
+/**
+ * @brief Grow one container on a block pool, reserve one on an arena
+ * 
+ * The pool list doubles 2 -> 4 -> 8 and shows two reallocations and the
+ * spare capacity as waste. The arena list reserves once, since an arena
+ * cannot take back the old block of a growing container.
+ */
+void allocator_test(void) {
+    uart_puts_P(PSTR("\r\n=== Monitored Allocator Test ===\r\n"));
+    
+    {
+        DemoList<uint16_t, SampleAlloc> samples(SampleAlloc(&s_list_pool, &s_samples_tag));
+        for (uint16_t i = 0; i < 5; i++) {
+            samples.push_back(i * 100);
+        }
+        mem_alloc_sample(&s_samples_tag, samples);
+        
+        DemoList<uint32_t, EventAlloc> events(EventAlloc(&s_scratch, &s_events_tag));
+        events.reserve(6);
+        for (uint16_t i = 0; i < 6; i++) {
+            events.push_back((uint32_t)i << 16);
+        }
+        mem_alloc_sample(&s_events_tag, events);
+        
+        mem_monitor_print_alloc_tags();
+        mem_monitor_print_budget();
+    }
+    
+    uart_puts_P(PSTR("  Containers released\r\n"));
+    mem_monitor_print_alloc_tags();
+    uart_newline();
+}
+
 // ============================================================================
 // MAIN
 // ============================================================================
@@ -251,12 +512,20 @@ int main(void) {
     // Initialize memory monitor (MUST be called before any malloc/free)
     mem_monitor_init();
     
+#if MEM_MONITOR_ISR_PROFILE
+    demo_tick_init();
+#endif
+#if MEM_MONITOR_ISR_PROFILE || MEM_MONITOR_PC_PROFILE || MEM_MONITOR_STACK_LIMIT
+    sei();   // Profilers and the stack-limit check run from interrupts
+#endif
+    
     uart_puts_P(PSTR("Memory monitor initialized\r\n"));
     uart_puts_P(PSTR("Stack sentinel pattern filled\r\n"));
     uart_newline();
     
     // Print initial baseline
     uart_puts_P(PSTR("=== BASELINE MEASUREMENTS ===\r\n"));
+    mem_monitor_mark_phase(PSTR("baseline"));
     mem_monitor_update();
     mem_monitor_print_diagnostics();
     
@@ -268,6 +537,7 @@ int main(void) {
     
     // Test 1: Recursive stack test
     uart_puts_P(PSTR("=== Test 1: Recursive Stack Growth ===\r\n"));
+    mem_monitor_mark_phase(PSTR("recursive_stack"));
     recursive_stack_test(1);
     uart_newline();
     mem_monitor_update();
@@ -275,33 +545,60 @@ int main(void) {
     _delay_ms(1000);
     
     // Test 2: Heap fragmentation
+    mem_monitor_mark_phase(PSTR("heap_fragmentation"));
     heap_fragmentation_test();
     mem_monitor_print_diagnostics();
     _delay_ms(1000);
     
     // Test 3: Large buffer
-    large_buffer_test();
+    mem_monitor_mark_phase(PSTR("large_buffer"));
+    MemStackReservation reservation;
+    if (mem_monitor_stack_reserve(LARGE_BUFFER_STACK, &reservation)) {
+        large_buffer_test();
+        mem_monitor_stack_release(&reservation);
+    } else {
+        uart_puts_P(PSTR("Large buffer test skipped, stack headroom: "));
+        uart_print_u16(mem_monitor_stack_headroom());
+        uart_puts_P(PSTR(" bytes\r\n"));
+    }
     mem_monitor_print_diagnostics();
     _delay_ms(1000);
     
     // Test 4: Combined stress
+    mem_monitor_mark_phase(PSTR("combined_stress"));
     combined_stress_test();
     mem_monitor_print_diagnostics();
     _delay_ms(1000);
     
+    // Test 5: Two-ended heap
+    mem_monitor_mark_phase(PSTR("dual_heap"));
+    dual_heap_test();
+    _delay_ms(1000);
+    
+    // Test 6: Containers on the monitored allocator
+    mem_monitor_mark_phase(PSTR("allocator"));
+    allocator_test();
+    _delay_ms(1000);
+    
     // ========================================================================
     // CONTINUOUS MONITORING LOOP
     // ========================================================================
     
     uart_puts_P(PSTR("=== Entering Continuous Monitoring Mode ===\r\n"));
     uart_puts_P(PSTR("Diagnostics printed every 2 seconds\r\n"));
+    mem_monitor_mark_phase(PSTR("continuous"));
     uart_newline();
     
+    // Test 7: Cooperative tasks, dispatched once per loop pass
+    mem_task_add(&s_tick_task);
+    mem_task_add(&s_checksum_task);
+    
     uint32_t last_report_ms = 0;
     
     while (1) {
         // Update memory statistics
         mem_monitor_update();
+        mem_task_run();
         
         // Print diagnostics periodically
         // Note: using delay approximation since we don't have timer setup
@@ -313,6 +610,22 @@ int main(void) {
             
             uart_puts_P(PSTR("--- Periodic Status ---\r\n"));
             mem_monitor_print_diagnostics();
+            mem_monitor_print_budget();
+            mem_monitor_print_alloc_tags();
+            mem_monitor_print_tasks();
+            mem_monitor_print_dual_heaps();
+#if MEM_MONITOR_ALLOC_FORENSICS
+            mem_monitor_print_alloc_failures();
+#endif
+#if MEM_MONITOR_IRQ_LATENCY
+            mem_monitor_print_irq_latency();
+#endif
+#if MEM_MONITOR_ISR_PROFILE
+            mem_monitor_print_isr_profile();
+#endif
+#if MEM_MONITOR_PC_PROFILE
+            mem_monitor_print_pc_profile();
+#endif
             
             // Demonstrate periodic allocation
             void* test_block = malloc(32);
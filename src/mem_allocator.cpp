@@ -0,0 +1,97 @@
+/**
+ * @file mem_allocator.cpp
+ * @brief Allocation tags and the [ALLOC] report
+ */
+
+#include "mem_allocator.h"
+#include "mem_critical.h"
+#include "uart_driver.h"
+#include <avr/pgmspace.h>
+
+MemHeapBackend mem_heap_backend;
+
+// ============================================================================
+// TAG LIST
+// ============================================================================
+
+// Intrusive singly linked list, most recently constructed first
+static MemAllocTag* s_tags;
+
+MemAllocTag::MemAllocTag(const char* tag_name)
+    : name(tag_name), live(0), peak(0), allocs(0), reallocs(0), failures(0),
+      in_use(0), sampled(0), next(NULL) {
+    MEM_CRITICAL_ENTER(MEM_CS_PROVIDER);
+    next = s_tags;
+    s_tags = this;
+    MEM_CRITICAL_EXIT(MEM_CS_PROVIDER);
+}
+
+MemAllocTag::~MemAllocTag() {
+    MEM_CRITICAL_ENTER(MEM_CS_PROVIDER);
+    MemAllocTag** link = &s_tags;
+    while (*link != NULL && *link != this) {
+        link = &(*link)->next;
+    }
+    if (*link != NULL) {
+        *link = next;
+    }
+    MEM_CRITICAL_EXIT(MEM_CS_PROVIDER);
+}
+
+// ============================================================================
+// ACCOUNTING
+// ============================================================================
+
+void MemAllocTag::note_alloc(void* ptr, uint16_t bytes) {
+    if (ptr == NULL) {
+        if (failures != 0xFFFF) {
+            failures++;
+        }
+        return;
+    }
+
+    // A container that allocates while it still holds memory is growing
+    if (live != 0 && reallocs != 0xFFFF) {
+        reallocs++;
+    }
+    if (allocs != 0xFFFF) {
+        allocs++;
+    }
+    live += bytes;
+    if (live > peak) {
+        peak = live;
+    }
+}
+
+void MemAllocTag::note_free(uint16_t bytes) {
+    live = bytes <= live ? live - bytes : 0;
+}
+
+// ============================================================================
+// REPORT
+// ============================================================================
+
+void mem_monitor_print_alloc_tags(void) {
+    for (const MemAllocTag* t = s_tags; t != NULL; t = t->next) {
+        uart_puts_P(PSTR("[ALLOC] "));
+        uart_puts_P(t->name);
+        uart_puts_P(PSTR(" live="));
+        uart_print_u16(t->live);
+        uart_puts_P(PSTR(" peak="));
+        uart_print_u16(t->peak);
+        uart_puts_P(PSTR(" allocs="));
+        uart_print_u16(t->allocs);
+        uart_puts_P(PSTR(" reallocs="));
+        uart_print_u16(t->reallocs);
+        uart_puts_P(PSTR(" fail="));
+        uart_print_u16(t->failures);
+        if (t->sampled) {
+            // Waste is capacity the growth policy holds beyond the elements
+            uart_puts_P(PSTR(" size="));
+            uart_print_u16(t->in_use);
+            uart_puts_P(PSTR(" waste="));
+            uart_print_u16(t->live > t->in_use ? t->live - t->in_use : 0);
+        }
+        uart_newline();
+    }
+}
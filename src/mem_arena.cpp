@@ -0,0 +1,73 @@
+/**
+ * @file mem_arena.cpp
+ * @brief Bump allocator implementation
+ */
+
+#include "mem_arena.h"
+
+MemArena::MemArena(const char* name, void* buffer, uint16_t size)
+    : buffer_((uint8_t*)buffer), size_(size), top_(0), peak_(0), failures_(0),
+      waste_(0) {
+    provider_.name = name;
+    provider_.fn = usage;
+    provider_.ctx = this;
+    provider_.counters.bytes = 0;
+    provider_.counters.used = 0;
+    provider_.counters.peak = 0;
+    provider_.counters.failures = 0;
+    provider_.counters.errors = 0;
+    provider_.counters.waste = 0;
+    provider_.flags = mem_provider_flags_for(buffer);
+    provider_.next = NULL;
+    mem_provider_register(&provider_);
+}
+
+MemArena::~MemArena() {
+    mem_provider_unregister(&provider_);
+}
+
+void* MemArena::allocate(uint16_t bytes) {
+    if (bytes > size_ - top_) {
+        if (failures_ != 0xFFFF) {
+            failures_++;
+        }
+        return NULL;
+    }
+
+    void* ptr = buffer_ + top_;
+    top_ += bytes;
+    if (top_ > peak_) {
+        peak_ = top_;
+    }
+    return ptr;
+}
+
+void MemArena::deallocate(void* ptr, uint16_t bytes) {
+    // Only the block on top can be given back
+    if ((uint8_t*)ptr + bytes == buffer_ + top_) {
+        top_ -= bytes;
+        if (waste_ > top_) {
+            waste_ = top_;
+        }
+    } else if (ptr != NULL) {
+        waste_ = bytes > 0xFFFF - waste_ ? 0xFFFF : waste_ + bytes;
+    }
+}
+
+void MemArena::rewind(uint16_t mark) {
+    if (mark < top_) {
+        top_ = mark;
+        if (waste_ > top_) {
+            waste_ = top_;
+        }
+    }
+}
+
+void MemArena::usage(const MemProvider* provider, MemProviderUsage* u) {
+    const MemArena* arena = static_cast<const MemArena*>(provider->ctx);
+    u->bytes = arena->size_;
+    u->used = arena->top_;
+    u->peak = arena->peak_;
+    u->failures = arena->failures_;
+    u->waste = arena->waste_;
+}
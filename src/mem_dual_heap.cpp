@@ -0,0 +1,379 @@
+/**
+ * @file mem_dual_heap.cpp
+ * @brief Two-ended heap implementation and the [DUALHEAP] report
+ */
+
+#include "mem_dual_heap.h"
+#include "mem_critical.h"
+#include "uart_driver.h"
+#include <avr/pgmspace.h>
+
+static_assert(MEM_DUAL_HEAP_SITES >= 0 && MEM_DUAL_HEAP_SITES <= 7,
+              "MEM_DUAL_HEAP_SITES must be between 0 and 7");
+
+// ============================================================================
+// BLOCK HEADER
+// ============================================================================
+
+// 16-bit header in front of every block:
+//   bits 0 - 11  block size in bytes, header included (even)
+//   bit  0       in use (sizes are even, so the bit is free)
+//   bit  12      long-lived side
+//   bits 13 - 15 profiled site, NO_SITE if none
+#define HDR_USED     0x0001
+#define HDR_SIZE     0x0FFE
+#define HDR_LONG     0x1000
+#define HDR_SITE_SHIFT 13
+#define NO_SITE      7
+
+#define HEADER_BYTES 2
+#define MIN_BLOCK    4   // Header plus the smallest payload
+
+#define SIDE_SHORT 0
+#define SIDE_LONG  1
+
+static inline uint16_t block_size(uint16_t hdr) {
+    return hdr & HDR_SIZE;
+}
+
+static inline void write_header(uint8_t* block, uint16_t hdr) {
+    block[0] = (uint8_t)hdr;
+    block[1] = (uint8_t)(hdr >> 8);
+}
+
+static inline uint16_t header_at(const uint8_t* block) {
+    return (uint16_t)block[0] | ((uint16_t)block[1] << 8);
+}
+
+// Heaps in construction order, newest first
+static MemDualHeap* s_heaps;
+
+// ============================================================================
+// CONSTRUCTION
+// ============================================================================
+
+MemDualHeap::MemDualHeap(const char* name, void* buffer, uint16_t size)
+    : buffer_((uint8_t*)buffer), failures_(0), errors_(0), next_(NULL) {
+    // Even, and small enough for the header's size field
+    size_ = (size > HDR_SIZE ? HDR_SIZE : size) & HDR_SIZE;
+    used_[SIDE_SHORT] = used_[SIDE_LONG] = 0;
+    peak_[SIDE_SHORT] = peak_[SIDE_LONG] = 0;
+    peak_total_ = 0;
+#if MEM_DUAL_HEAP_SITES > 0
+    for (uint8_t i = 0; i < MEM_DUAL_HEAP_SITES; i++) {
+        sites_[i].pc = 0;
+        sites_[i].allocs = 0;
+        sites_[i].frees = 0;
+    }
+#endif
+
+    // One free block spanning the region
+    if (size_ >= MIN_BLOCK) {
+        write_header(buffer_, size_);
+    } else {
+        size_ = 0;
+    }
+
+    provider_.name = name;
+    provider_.fn = usage;
+    provider_.ctx = this;
+    provider_.counters.bytes = 0;
+    provider_.counters.used = 0;
+    provider_.counters.peak = 0;
+    provider_.counters.failures = 0;
+    provider_.counters.errors = 0;
+    provider_.counters.waste = 0;
+    provider_.flags = mem_provider_flags_for(buffer);
+    provider_.next = NULL;
+    mem_provider_register(&provider_);
+
+    MEM_CRITICAL_ENTER(MEM_CS_PROVIDER);
+    next_ = s_heaps;
+    s_heaps = this;
+    MEM_CRITICAL_EXIT(MEM_CS_PROVIDER);
+}
+
+MemDualHeap::~MemDualHeap() {
+    mem_provider_unregister(&provider_);
+
+    MEM_CRITICAL_ENTER(MEM_CS_PROVIDER);
+    MemDualHeap** link = &s_heaps;
+    while (*link != NULL && *link != this) {
+        link = &(*link)->next_;
+    }
+    if (*link != NULL) {
+        *link = next_;
+    }
+    MEM_CRITICAL_EXIT(MEM_CS_PROVIDER);
+}
+
+// ============================================================================
+// LIFETIME PROFILE
+// ============================================================================
+
+uint8_t MemDualHeap::site_for(uint16_t pc) {
+#if MEM_DUAL_HEAP_SITES > 0
+    for (uint8_t i = 0; i < MEM_DUAL_HEAP_SITES; i++) {
+        if (sites_[i].pc == pc) {
+            return i;
+        }
+        if (sites_[i].pc == 0) {
+            sites_[i].pc = pc;
+            return i;
+        }
+    }
+#else
+    (void)pc;
+#endif
+    return NO_SITE;   // Table full: not profiled
+}
+
+uint8_t MemDualHeap::lifetime_of(uint8_t site) const {
+#if MEM_DUAL_HEAP_SITES > 0
+    if (site == NO_SITE) {
+        return SIDE_SHORT;
+    }
+    // Allocates repeatedly and keeps most of it
+    const Site& s = sites_[site];
+    return s.allocs >= 2 && s.allocs > 2 * (uint16_t)s.frees ? SIDE_LONG : SIDE_SHORT;
+#else
+    (void)site;
+    return SIDE_SHORT;
+#endif
+}
+
+// ============================================================================
+// BLOCK WALK
+// ============================================================================
+
+/**
+ * @brief Block after p, or NULL if p's size is 0 or runs past the region
+ *
+ * Every walk steps through this, so a corrupt header ends the walk (and
+ * counts as an error) instead of looping or running off the buffer.
+ */
+uint8_t* MemDualHeap::next_block(uint8_t* p) const {
+    uint16_t size = block_size(header_at(p));
+    if (size == 0 || size > (uint16_t)(buffer_ + size_ - p)) {
+        if (errors_ != 0xFFFF) {
+            errors_++;
+        }
+        return NULL;
+    }
+    return p + size;
+}
+
+// ============================================================================
+// ALLOCATION
+// ============================================================================
+
+/**
+ * @brief Carve need bytes from a free block on the given side
+ * @return Block start, or NULL if nothing fits
+ *
+ * Short: lowest fitting block, lower part. Long: highest fitting block,
+ * upper part. A remainder smaller than MIN_BLOCK is handed out with it.
+ */
+uint8_t* MemDualHeap::take(uint16_t need, uint8_t side) {
+    uint8_t* end = buffer_ + size_;
+    uint8_t* fit = NULL;
+    uint16_t fit_size = 0;
+
+    uint8_t* next;
+    for (uint8_t* p = buffer_; p < end; p = next) {
+        next = next_block(p);
+        if (next == NULL) {
+            break;
+        }
+        uint16_t hdr = header_at(p);
+        if (!(hdr & HDR_USED) && block_size(hdr) >= need) {
+            fit = p;
+            fit_size = block_size(hdr);
+            if (side == SIDE_SHORT) {
+                break;
+            }
+        }
+    }
+    if (fit == NULL) {
+        return NULL;
+    }
+
+    uint16_t rest = fit_size - need;
+    if (rest < MIN_BLOCK) {
+        need = fit_size;
+        rest = 0;
+    }
+    if (rest == 0) {
+        return fit;
+    }
+    if (side == SIDE_SHORT) {
+        write_header(fit, need);
+        write_header(fit + need, rest);
+        return fit;
+    }
+    write_header(fit, rest);
+    write_header(fit + rest, need);
+    return fit + rest;
+}
+
+void* MemDualHeap::allocate(uint16_t bytes, MemLifetime lifetime) {
+    uint8_t site = NO_SITE;
+    uint8_t side = lifetime == MEM_LIFETIME_LONG ? SIDE_LONG : SIDE_SHORT;
+    if (lifetime == MEM_LIFETIME_AUTO) {
+        site = site_for((uint16_t)__builtin_return_address(0) << 1);
+        side = lifetime_of(site);
+    }
+
+    // Header plus payload rounded up to even (payload at least 2 bytes)
+    uint16_t need = bytes < MIN_BLOCK - HEADER_BYTES ? MIN_BLOCK - HEADER_BYTES : bytes;
+    uint8_t* block = NULL;
+    if (need <= size_ - HEADER_BYTES) {
+        need = (need + HEADER_BYTES + 1) & HDR_SIZE;
+        block = take(need, side);
+    }
+    if (block == NULL) {
+        if (failures_ != 0xFFFF) {
+            failures_++;
+        }
+        return NULL;
+    }
+
+    uint16_t held = block_size(header_at(block));
+    write_header(block, held | HDR_USED | (side == SIDE_LONG ? HDR_LONG : 0) |
+                        ((uint16_t)site << HDR_SITE_SHIFT));
+    used_[side] += held;
+    if (used_[side] > peak_[side]) {
+        peak_[side] = used_[side];
+    }
+    if (used_[SIDE_SHORT] + used_[SIDE_LONG] > peak_total_) {
+        peak_total_ = used_[SIDE_SHORT] + used_[SIDE_LONG];
+    }
+#if MEM_DUAL_HEAP_SITES > 0
+    if (site != NO_SITE) {
+        Site& s = sites_[site];
+        if (s.allocs == 0xFF) {
+            s.allocs >>= 1;
+            s.frees >>= 1;
+        }
+        s.allocs++;
+    }
+#endif
+    return block + HEADER_BYTES;
+}
+
+// ============================================================================
+// RELEASE
+// ============================================================================
+
+/**
+ * @brief Merge every run of adjacent free blocks into one
+ */
+void MemDualHeap::merge_free() {
+    uint8_t* end = buffer_ + size_;
+    uint8_t* p = buffer_;
+    while (p != NULL && p < end) {
+        uint16_t hdr = header_at(p);
+        uint8_t* next = next_block(p);
+        if (next != NULL && !(hdr & HDR_USED) && next < end &&
+            !(header_at(next) & HDR_USED)) {
+            uint8_t* after = next_block(next);
+            if (after == NULL) {
+                return;
+            }
+            write_header(p, (uint16_t)(after - p));
+            continue;   // Try the new neighbour too
+        }
+        p = next;
+    }
+}
+
+void MemDualHeap::deallocate(void* ptr, uint16_t bytes) {
+    (void)bytes;
+    if (ptr == NULL) {
+        return;
+    }
+
+    // Must be the payload of a live block found by walking the region
+    uint8_t* target = (uint8_t*)ptr - HEADER_BYTES;
+    uint8_t* end = buffer_ + size_;
+    uint8_t* p = buffer_;
+    while (p != NULL && p < end && p < target) {
+        p = next_block(p);
+    }
+    if (p == NULL || (p == target && next_block(p) == NULL)) {
+        return;   // Corrupt block on the way, already counted
+    }
+    uint16_t hdr = p < end ? header_at(p) : 0;
+    if (p != target || !(hdr & HDR_USED)) {
+        if (errors_ != 0xFFFF) {
+            errors_++;
+        }
+        return;
+    }
+
+    uint8_t side = (hdr & HDR_LONG) ? SIDE_LONG : SIDE_SHORT;
+    used_[side] -= block_size(hdr);
+#if MEM_DUAL_HEAP_SITES > 0
+    uint8_t site = hdr >> HDR_SITE_SHIFT;
+    if (site < MEM_DUAL_HEAP_SITES && sites_[site].frees < sites_[site].allocs) {
+        sites_[site].frees++;
+    }
+#endif
+
+    write_header(p, block_size(hdr));
+    merge_free();
+}
+
+// ============================================================================
+// REPORT
+// ============================================================================
+
+uint16_t MemDualHeap::largest_free() const {
+    uint16_t largest = 0;
+    const uint8_t* end = buffer_ + size_;
+    uint8_t* next;
+    for (uint8_t* p = buffer_; p < end; p = next) {
+        next = next_block(p);
+        if (next == NULL) {
+            break;
+        }
+        uint16_t hdr = header_at(p);
+        if (!(hdr & HDR_USED) && block_size(hdr) > largest) {
+            largest = block_size(hdr);
+        }
+    }
+    return largest > HEADER_BYTES ? largest - HEADER_BYTES : 0;
+}
+
+void MemDualHeap::usage(const MemProvider* provider, MemProviderUsage* u) {
+    const MemDualHeap* heap = static_cast<const MemDualHeap*>(provider->ctx);
+    u->bytes = heap->size_;
+    u->used = heap->used_[SIDE_SHORT] + heap->used_[SIDE_LONG];
+    u->peak = heap->peak_total_;
+    u->failures = heap->failures_;
+    u->errors = heap->errors_;
+}
+
+void mem_monitor_print_dual_heaps(void) {
+    for (const MemDualHeap* h = s_heaps; h != NULL; h = h->next()) {
+        uart_puts_P(PSTR("[DUALHEAP] "));
+        uart_puts_P(h->name());
+        uart_puts_P(PSTR(" bytes="));
+        uart_print_u16(h->capacity());
+        uart_puts_P(PSTR(" short="));
+        uart_print_u16(h->short_used());
+        uart_putc('/');
+        uart_print_u16(h->short_peak());
+        uart_puts_P(PSTR(" long="));
+        uart_print_u16(h->long_used());
+        uart_putc('/');
+        uart_print_u16(h->long_peak());
+        uart_puts_P(PSTR(" largest="));
+        uart_print_u16(h->largest_free());
+        uart_puts_P(PSTR(" fail="));
+        uart_print_u16(h->failures());
+        uart_puts_P(PSTR(" err="));
+        uart_print_u16(h->errors());
+        uart_newline();
+    }
+}
@@ -0,0 +1,137 @@
+/**
+ * @file mem_provider.cpp
+ * @brief Provider registry and SRAM budget report
+ */
+
+#include "mem_provider.h"
+#include "memory_monitor.h"
+#include "mem_critical.h"
+#include "uart_driver.h"
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stddef.h>
+
+extern uint8_t __heap_start;
+extern uint8_t *__brkval;
+
+// ============================================================================
+// REGISTRY
+// ============================================================================
+
+// Intrusive singly linked list, most recently registered first
+static MemProvider* s_providers;
+
+void mem_provider_register(MemProvider* provider) {
+    MEM_CRITICAL_ENTER(MEM_CS_PROVIDER);
+    MemProvider* p = s_providers;
+    while (p != NULL && p != provider) {
+        p = p->next;
+    }
+    if (p == NULL) {
+        provider->next = s_providers;
+        s_providers = provider;
+    }
+    MEM_CRITICAL_EXIT(MEM_CS_PROVIDER);
+}
+
+void mem_provider_unregister(MemProvider* provider) {
+    MEM_CRITICAL_ENTER(MEM_CS_PROVIDER);
+    MemProvider** link = &s_providers;
+    while (*link != NULL && *link != provider) {
+        link = &(*link)->next;
+    }
+    if (*link != NULL) {
+        *link = provider->next;
+        provider->next = NULL;
+    }
+    MEM_CRITICAL_EXIT(MEM_CS_PROVIDER);
+}
+
+uint8_t mem_provider_flags_for(const void* addr) {
+    // .data, .bss and .noinit all lie below __heap_start
+    return (uint16_t)addr >= (uint16_t)&__heap_start ? MEM_PROVIDER_NESTED : 0;
+}
+
+// ============================================================================
+// BUDGET REPORT
+// ============================================================================
+
+static void print_line(const char* prefix, const char* name, uint16_t bytes) {
+    uart_puts_P(PSTR("[BUDGET] "));
+    uart_puts_P(prefix);
+    uart_puts_P(name);
+    uart_puts_P(PSTR(" bytes="));
+    uart_print_u16(bytes);
+}
+
+void mem_monitor_print_budget(void) {
+    const uint16_t total = RAMEND - 0x0100 + 1;
+    uint16_t count = 0;
+    uint16_t claimed = 0;
+
+    for (const MemProvider* p = s_providers; p != NULL; p = p->next) {
+        count++;
+    }
+
+    uart_puts_P(PSTR("[BUDGET] sram="));
+    uart_print_u16(total);
+    uart_puts_P(PSTR(" providers="));
+    uart_print_u16(count);
+    uart_newline();
+
+    // Providers registered from an ISR during the walk show up next time
+    for (const MemProvider* p = s_providers; p != NULL; p = p->next) {
+        MemProviderUsage usage = p->counters;
+        if (p->fn != NULL) {
+            p->fn(p, &usage);
+        }
+
+        uint8_t nested = p->flags & MEM_PROVIDER_NESTED;
+        print_line(nested ? PSTR("+") : PSTR(""), p->name, usage.bytes);
+        uart_puts_P(PSTR(" used="));
+        uart_print_u16(usage.used);
+        if (usage.peak != 0) {
+            uart_puts_P(PSTR(" peak="));
+            uart_print_u16(usage.peak);
+        }
+        if (usage.waste != 0) {
+            uart_puts_P(PSTR(" waste="));
+            uart_print_u16(usage.waste);
+        }
+        if (usage.failures != 0) {
+            uart_puts_P(PSTR(" fail="));
+            uart_print_u16(usage.failures);
+        }
+        if (usage.errors != 0) {
+            uart_puts_P(PSTR(" err="));
+            uart_print_u16(usage.errors);
+        }
+        uart_newline();
+
+        if (!nested) {
+            claimed += usage.bytes;
+        }
+    }
+
+    // Stack occupies SP+1..RAMEND; free is heap end..SP inclusive
+    uint16_t sp = mem_monitor_get_stack_pointer();
+    uint16_t heap_end = (uint16_t)(__brkval ? __brkval : &__heap_start);
+    uint16_t stack = RAMEND - sp;
+    uint16_t free_bytes = sp >= heap_end ? sp - heap_end + 1 : 0;
+
+    print_line(PSTR(""), PSTR("stack"), stack);
+    uart_newline();
+    print_line(PSTR(""), PSTR("free"), free_bytes);
+    uart_newline();
+
+    // Negative when registered providers overlap
+    uint16_t rest = claimed + stack + free_bytes;
+    uart_puts_P(PSTR("[BUDGET] unaccounted bytes="));
+    if (rest > total) {
+        uart_putc('-');
+        uart_print_u16(rest - total);
+    } else {
+        uart_print_u16(total - rest);
+    }
+    uart_newline();
+}
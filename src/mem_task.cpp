@@ -0,0 +1,183 @@
+/**
+ * @file mem_task.cpp
+ * @brief Cooperative task scheduler and per-task stack probe
+ */
+
+#include "mem_task.h"
+#include "uart_driver.h"
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+// ============================================================================
+// TASK LIST
+// ============================================================================
+
+// Dispatch order is the order tasks were added
+static MemTask* s_tasks;
+
+// Deepest scheduler stack seen at a dispatch (bytes below RAMEND)
+static uint16_t s_base_usage;
+
+void mem_task_add(MemTask* task) {
+    MemTask** link = &s_tasks;
+    while (*link != NULL) {
+        if (*link == task) {
+            return;
+        }
+        link = &(*link)->next;
+    }
+    task->next = NULL;
+    *link = task;
+
+    // The state struct is the task's only persistent memory
+    task->provider.name = task->name;
+    task->provider.fn = NULL;
+    task->provider.ctx = task;
+    task->provider.counters.bytes = task->state_size;
+    task->provider.counters.used = task->state_size;
+    task->provider.counters.peak = 0;
+    task->provider.counters.failures = 0;
+    task->provider.counters.errors = 0;
+    task->provider.counters.waste = 0;
+    task->provider.flags = mem_provider_flags_for(task->state);
+    mem_provider_register(&task->provider);
+}
+
+void mem_task_restart(MemTask* task) {
+    task->lc = 0;
+    task->done = 0;
+}
+
+// ============================================================================
+// DISPATCH
+// ============================================================================
+
+#if MEM_TASK_STACK_PROBE > 0
+
+/**
+ * @brief Paint the probe window below sp, minus what the task already used
+ * @return Lowest painted byte (== top when there is nothing to paint)
+ *
+ * A byte in the window that is no longer a sentinel was disturbed since
+ * the monitor's last scan; its depth is handed to the monitor first so
+ * repainting cannot hide it. Inlined: the window starts right below the
+ * caller's frame, where a call frame of our own would be painted over.
+ */
+static inline __attribute__((always_inline))
+uint8_t* probe_paint(uint8_t* sp, uint8_t* top) {
+    uint16_t room = mem_monitor_get_free_stack_space();
+    room = room > MEM_GUARD_BAND_BYTES ? room - MEM_GUARD_BAND_BYTES : 0;
+    uint16_t depth = room < MEM_TASK_STACK_PROBE ? room : MEM_TASK_STACK_PROBE;
+    uint8_t* bottom = sp - depth;
+    if (bottom >= top) {
+        return top;
+    }
+
+    for (uint8_t* p = bottom; p < top; p++) {
+        if (*p != STACK_SENTINEL) {
+            mem_monitor_note_stack_usage(RAMEND - (uint16_t)p);
+            break;
+        }
+    }
+    // No calls from here until the task runs
+    for (uint8_t* p = bottom; p < top; p++) {
+        *p = STACK_SENTINEL;
+    }
+    return bottom;
+}
+
+/**
+ * @brief Depth below sp of the first disturbed byte in [bottom, top)
+ * @return 0 if the task stayed above the window
+ */
+static uint16_t probe_scan(uint8_t* sp, uint8_t* bottom, uint8_t* top) {
+    for (uint8_t* p = bottom; p < top; p++) {
+        if (*p != STACK_SENTINEL) {
+            return (uint16_t)(sp - p);
+        }
+    }
+    return 0;
+}
+
+#endif // MEM_TASK_STACK_PROBE > 0
+
+uint8_t mem_task_run(void) {
+    uint8_t waiting = 0;
+
+    for (MemTask* t = s_tasks; t != NULL; t = t->next) {
+        if (t->done) {
+            continue;
+        }
+
+        // Tasks start from this frame; everything below it is theirs
+        uint16_t sp_addr = mem_monitor_get_stack_pointer();
+        uint16_t base = RAMEND - sp_addr;
+        if (base > s_base_usage) {
+            s_base_usage = base;
+        }
+
+#if MEM_TASK_STACK_PROBE > 0
+        uint8_t* sp = (uint8_t*)sp_addr;
+        uint8_t* top = sp - (t->stack_peak < MEM_TASK_STACK_PROBE
+                                 ? t->stack_peak : MEM_TASK_STACK_PROBE);
+        uint8_t* bottom = probe_paint(sp, top);
+#endif
+
+        MemTaskStatus status = t->fn(t);
+
+#if MEM_TASK_STACK_PROBE > 0
+        uint16_t used = probe_scan(sp, bottom, top);
+        if (used > t->stack_peak) {
+            t->stack_peak = used;
+        }
+#endif
+
+        if (t->runs != 0xFFFF) {
+            t->runs++;
+        }
+        if (status == MEM_TASK_DONE) {
+            t->done = 1;
+        } else {
+            waiting++;
+        }
+    }
+    return waiting;
+}
+
+// ============================================================================
+// REPORT
+// ============================================================================
+
+void mem_monitor_print_tasks(void) {
+    uint8_t count = 0;
+    uint16_t deepest = 0;
+    for (const MemTask* t = s_tasks; t != NULL; t = t->next) {
+        count++;
+        if (t->stack_peak > deepest) {
+            deepest = t->stack_peak;
+        }
+    }
+
+    uart_puts_P(PSTR("[TASK] tasks="));
+    uart_print_u16(count);
+    uart_puts_P(PSTR(" base="));
+    uart_print_u16(s_base_usage);
+    uart_puts_P(PSTR(" stack="));
+    uart_print_u16(deepest);
+    uart_newline();
+
+    for (const MemTask* t = s_tasks; t != NULL; t = t->next) {
+        uart_puts_P(PSTR("[TASK] "));
+        uart_puts_P(t->name);
+        uart_puts_P(PSTR(" state="));
+        uart_print_u16(t->state_size);
+        uart_puts_P(PSTR(" stack="));
+        uart_print_u16(t->stack_peak);
+        uart_puts_P(PSTR(" runs="));
+        uart_print_u16(t->runs);
+        if (t->done) {
+            uart_puts_P(PSTR(" done"));
+        }
+        uart_newline();
+    }
+}
@@ -10,6 +10,13 @@
  */
 
 #include "memory_monitor.h"
+#include "mem_critical.h"
+#include "mem_provider.h"
+#include "mem_budget.h"
+#include "isr_profile.h"
+#include "pc_profile.h"
+#include "stack_limit.h"
+#include "alloc_failure.h"
 #include "uart_driver.h"
 #include <avr/io.h>
 #include <avr/pgmspace.h>
@@ -31,8 +38,39 @@ extern uint8_t __bss_end;       // End of .bss segment
 // STATIC STATE
 // ============================================================================
 
+#if MEM_MONITOR_TRACK_MODE == MEM_TRACK_TABLE
 // Heap allocation tracking table (fixed size, no dynamic allocation)
 static AllocationEntry s_alloc_table[MAX_HEAP_ALLOCATIONS];
+#if MEM_MONITOR_FRAG_BLAME
+// alloc_count when each entry was made (kept outside the mailbox table layout)
+static uint16_t s_alloc_seq[MAX_HEAP_ALLOCATIONS];
+#endif
+#elif MEM_MONITOR_TRACK_MODE != MEM_TRACK_HEADER
+#error "MEM_MONITOR_TRACK_MODE must be MEM_TRACK_TABLE or MEM_TRACK_HEADER"
+#endif
+
+#if MEM_MONITOR_PAINT_MODE == MEM_PAINT_GUARD
+static_assert(MEM_GUARD_BAND_BYTES >= 1 && MEM_GUARD_BAND_BYTES <= 255,
+              "MEM_GUARD_BAND_BYTES must be between 1 and 255");
+
+// Guard band state (band sits directly above the heap end)
+static uint8_t* s_guard_base;   // Heap end the band was painted at
+static uint8_t s_guard_len;     // Bytes painted (short if SP was closer)
+static uint8_t s_guard_tripped; // A replaced band had been disturbed
+#elif MEM_MONITOR_PAINT_MODE != MEM_PAINT_FULL
+#error "MEM_MONITOR_PAINT_MODE must be MEM_PAINT_FULL or MEM_PAINT_GUARD"
+#endif
+
+#if MEM_MONITOR_DEFERRED_FREE
+static_assert(MEM_MONITOR_DEFERRED_FREE >= 2 && MEM_MONITOR_DEFERRED_FREE <= 16,
+              "MEM_MONITOR_DEFERRED_FREE must be 0 or between 2 and 16");
+
+// Frees not yet handed to the allocator (headers still intact)
+static void* s_free_queue[MEM_MONITOR_DEFERRED_FREE];
+static uint8_t s_free_queued;       // Entries in s_free_queue
+static uint8_t s_free_queue_peak;   // Most entries at once
+static uint16_t s_free_batches;     // Drains that released something
+#endif
 
 // Memory statistics
 static struct {
@@ -43,9 +81,23 @@ static struct {
     uint16_t heap_total_freed;      // Cumulative freed
     uint16_t alloc_count;           // Number of malloc calls
     uint16_t free_count;            // Number of free calls
+    uint16_t update_count;          // mem_monitor_update() calls
     uint8_t collision_warning;      // Collision flag
 } s_mem_state;
 
+#if MEM_MONITOR_IRQ_LATENCY
+// Interrupts-disabled window statistics per critical section site
+CriticalSectionStats mem_critical_stats[MEM_CS_COUNT];
+#endif
+
+#if MEM_MONITOR_MAILBOX
+// Debugger mailbox, linked to MEM_MAILBOX_ADDR (not initialized by crt)
+MemoryMailbox mem_mailbox __attribute__((section(".mailbox"), used));
+
+static_assert(sizeof(MemoryMailbox) <= MEM_MAILBOX_SIZE,
+              "MemoryMailbox exceeds the SRAM reserved for it in the Makefile");
+#endif
+
 // ============================================================================
 // STACK POINTER ACCESS (inline assembly)
 // ============================================================================
@@ -61,37 +113,225 @@ static struct {
  * Must disable interrupts during read to ensure atomicity.
  */
 uint16_t mem_monitor_get_stack_pointer(void) {
-    uint8_t sreg;
     uint16_t sp;
     
     // Save interrupt state and disable interrupts
-    sreg = SREG;
-    __asm__ __volatile__ ("cli");
+    MEM_CRITICAL_ENTER(MEM_CS_STACK_POINTER);
     
     // Read stack pointer (SPL must be read before SPH on AVR)
     sp = SPL;
     sp |= ((uint16_t)SPH << 8);
     
     // Restore interrupt state
-    SREG = sreg;
+    MEM_CRITICAL_EXIT(MEM_CS_STACK_POINTER);
     
     return sp;
 }
 
+// ============================================================================
+// DEBUGGER MAILBOX
+// ============================================================================
+
+#if MEM_MONITOR_MAILBOX
+/**
+ * @brief Copy current statistics into the mailbox
+ * 
+ * The snapshot is computed first; only the copy runs with interrupts off,
+ * so an allocation inside an ISR cannot interleave with the update. The
+ * generation is odd while the copy is in progress.
+ */
+static void publish_mailbox(void) {
+    MemoryStats stats;
+    mem_monitor_get_stats(&stats);
+    
+    MEM_CRITICAL_ENTER(MEM_CS_MAILBOX);
+    mem_mailbox.generation++;
+    memcpy(&mem_mailbox.stats, &stats, sizeof(stats));
+    mem_mailbox.generation++;
+    MEM_CRITICAL_EXIT(MEM_CS_MAILBOX);
+}
+
+static void init_mailbox(void) {
+    memset(&mem_mailbox, 0, sizeof(mem_mailbox));
+    mem_mailbox.magic = MEM_MAILBOX_MAGIC;
+    mem_mailbox.version = MEM_MAILBOX_VERSION;
+    mem_mailbox.size = sizeof(MemoryMailbox);
+#if MEM_MONITOR_TRACK_MODE == MEM_TRACK_TABLE
+    mem_mailbox.alloc_table = s_alloc_table;
+    mem_mailbox.alloc_table_len = MAX_HEAP_ALLOCATIONS;
+    mem_mailbox.alloc_entry_size = sizeof(AllocationEntry);
+#endif
+}
+#endif
+
+// ============================================================================
+// BUILD-TIME BUDGET
+// ============================================================================
+
+#define MEM_STR_(x) #x
+#define MEM_STR(x) MEM_STR_(x)
+
+// Stack requirement for tools/membudget; absolute symbols take no memory
+__asm__(".global __mem_budget_min_stack\n\t"
+        ".set __mem_budget_min_stack, " MEM_STR(MEM_BUDGET_MIN_STACK) "\n\t"
+        ".global __mem_budget_isr_reserve\n\t"
+        ".set __mem_budget_isr_reserve, " MEM_STR(MEM_MONITOR_ISR_STACK_RESERVE) "\n\t"
+        ".global __mem_budget_ramend\n\t"
+        ".set __mem_budget_ramend, " MEM_STR(RAMEND));
+
+// ============================================================================
+// BUILT-IN PROVIDERS
+// ============================================================================
+
+static const char provider_mailbox[] PROGMEM = "mailbox";
+static const char provider_monitor[] PROGMEM = "monitor";
+static const char provider_heap[] PROGMEM = "heap";
+
+#if MEM_MONITOR_MAILBOX
+// Reserved SRAM in front of .data (see the Makefile)
+static MemProvider s_mailbox_provider = {
+    provider_mailbox, NULL, NULL, {MEM_MAILBOX_SIZE, sizeof(MemoryMailbox), 0, 0, 0}, 0, NULL
+};
+#endif
+
+// The monitor's own tables
+static const uint16_t MONITOR_STATE_BYTES = sizeof(s_mem_state)
+#if MEM_MONITOR_TRACK_MODE == MEM_TRACK_TABLE
+    + sizeof(s_alloc_table)
+#if MEM_MONITOR_FRAG_BLAME
+    + sizeof(s_alloc_seq)
+#endif
+#endif
+#if MEM_MONITOR_IRQ_LATENCY
+    + sizeof(mem_critical_stats)
+#endif
+#if MEM_MONITOR_DEFERRED_FREE
+    + sizeof(s_free_queue) + sizeof(s_free_queued) + sizeof(s_free_queue_peak)
+    + sizeof(s_free_batches)
+#endif
+    ;
+
+MEM_BUDGET_ASSERT("Monitor state and mailbox", MONITOR_STATE_BYTES + MEM_MAILBOX_SIZE);
+
+static MemProvider s_monitor_provider = {
+    provider_monitor, NULL, NULL, {MONITOR_STATE_BYTES, MONITOR_STATE_BYTES, 0, 0, 0}, 0, NULL
+};
+
+/**
+ * @brief avr-libc heap: bytes up to the heap end, used as tracked
+ */
+static void heap_usage(const MemProvider* provider, MemProviderUsage* usage) {
+    (void)provider;
+    uint8_t* heap_end = __brkval ? __brkval : &__heap_start;
+    usage->bytes = (uint16_t)(heap_end - &__heap_start);
+    usage->used = s_mem_state.heap_used;
+    usage->peak = 0;
+#if MEM_MONITOR_ALLOC_FORENSICS
+    usage->failures = mem_monitor_get_alloc_failures()->count;
+#endif
+}
+
+static MemProvider s_heap_provider = {
+    provider_heap, heap_usage, NULL, {0, 0, 0, 0, 0, 0}, 0, NULL
+};
+
+#if MEM_MONITOR_PAINT_MODE == MEM_PAINT_GUARD
+// ============================================================================
+// GUARD BAND
+// ============================================================================
+
+/**
+ * @brief Paint the guard band at the current heap end
+ * 
+ * Only bytes below SP are painted; with less than MEM_GUARD_BAND_BYTES
+ * free the band is short and the collision margin check already fires.
+ */
+static void guard_place(void) {
+    uint8_t* base = __brkval ? __brkval : &__heap_start;
+    uint8_t* stack_ptr = (uint8_t*)mem_monitor_get_stack_pointer();
+    uint8_t len = 0;
+    
+    for (uint8_t* ptr = base; ptr < stack_ptr && len < MEM_GUARD_BAND_BYTES; ptr++) {
+        *ptr = STACK_SENTINEL;
+        len++;
+    }
+    
+    s_guard_base = base;
+    s_guard_len = len;
+}
+
+/**
+ * @brief Offset of the lowest disturbed band byte
+ * @param skip Leading bytes to ignore
+ * @return Band length if the band is intact
+ */
+static uint8_t guard_scan(uint8_t skip) {
+    uint8_t i = skip;
+    while (i < s_guard_len && s_guard_base[i] == STACK_SENTINEL) {
+        i++;
+    }
+    return i < s_guard_len ? i : s_guard_len;
+}
+
+/**
+ * @brief Move the band after malloc/free changed the heap end
+ * 
+ * The old band is checked before it is given up, so a stack excursion
+ * between two updates is not lost. When the heap grew, the new chunk's
+ * 2-byte header may sit on the first band bytes; those are skipped.
+ */
+static void guard_follow_heap(void) {
+    uint8_t* base = __brkval ? __brkval : &__heap_start;
+    if (base == s_guard_base) {
+        return;
+    }
+    
+    uint8_t skip = base > s_guard_base ? 2 : 0;
+    if (guard_scan(skip) < s_guard_len) {
+        s_guard_tripped = 1;
+    }
+    guard_place();
+}
+#endif // MEM_MONITOR_PAINT_MODE == MEM_PAINT_GUARD
+
 // ============================================================================
 // INITIALIZATION
 // ============================================================================
 
 void mem_monitor_init(void) {
+#if MEM_MONITOR_TRACK_MODE == MEM_TRACK_TABLE
     // Clear allocation tracking table
     memset(s_alloc_table, 0, sizeof(s_alloc_table));
+#endif
     
     // Reset memory state
     memset(&s_mem_state, 0, sizeof(s_mem_state));
     
+#if MEM_MONITOR_IRQ_LATENCY
+    timebase_init();
+    memset(mem_critical_stats, 0, sizeof(mem_critical_stats));
+#endif
+    
+#if MEM_MONITOR_ISR_PROFILE
+    mem_isr_profile_init();
+#endif
+    
+#if MEM_MONITOR_PC_PROFILE
+    mem_pc_profile_init();
+#endif
+    
+#if MEM_MONITOR_STACK_LIMIT
+    mem_stack_limit_init();
+#endif
+    
     // Record initial stack pointer (baseline for measurements)
     s_mem_state.init_stack_pointer = mem_monitor_get_stack_pointer();
     
+#if MEM_MONITOR_PAINT_MODE == MEM_PAINT_GUARD
+    // Paint only the guard band above the heap end
+    s_guard_tripped = 0;
+    guard_place();
+#else
     // Fill stack region with sentinel pattern
     // This allows us to detect maximum stack penetration
     // 
@@ -103,12 +343,85 @@ void mem_monitor_init(void) {
     for (uint8_t* ptr = heap_end; ptr < stack_ptr; ptr++) {
         *ptr = STACK_SENTINEL;
     }
+#endif
+    
+#if MEM_MONITOR_MAILBOX
+    init_mailbox();
+    publish_mailbox();
+#endif
+    
+#if MEM_MONITOR_MAILBOX
+    mem_provider_register(&s_mailbox_provider);
+#endif
+    mem_provider_register(&s_monitor_provider);
+    mem_provider_register(&s_heap_provider);
 }
 
 // ============================================================================
 // HEAP TRACKING
 // ============================================================================
 
+#if MEM_MONITOR_TRACK_MODE == MEM_TRACK_HEADER
+/**
+ * @brief Heap bytes owned by a block, from its avr-libc chunk header
+ * @param ptr Pointer returned by malloc
+ * @return Chunk size including the 2-byte header, 0 if ptr is not in the heap
+ * 
+ * avr-libc keeps the usable size of every chunk in the size_t just below
+ * the pointer (struct __freelist.sz). It can exceed the requested size:
+ * requests under 2 bytes are rounded up, and a leftover too small for a
+ * free-list entry is handed out with the block.
+ */
+static uint16_t chunk_size(void* ptr) {
+    uint8_t* p = (uint8_t*)ptr;
+    uint8_t* heap_end = __brkval ? __brkval : &__heap_start;
+    
+    if (p < &__heap_start + sizeof(size_t) || p >= heap_end) {
+        return 0;
+    }
+    return *((uint16_t*)p - 1) + sizeof(size_t);
+}
+
+void mem_monitor_track_alloc(void* ptr, uint16_t size) {
+    (void)size; // The header holds the size actually reserved
+    
+    uint16_t chunk = chunk_size(ptr);
+    if (chunk == 0) {
+        return; // Failed allocation
+    }
+    
+    s_mem_state.heap_used += chunk;
+    s_mem_state.heap_total_allocated += chunk;
+    s_mem_state.alloc_count++;
+#if MEM_MONITOR_MAILBOX
+    publish_mailbox();
+#endif
+}
+
+void mem_monitor_track_free(void* ptr) {
+    // Read before __real_free: merging with a neighbour rewrites the header
+    uint16_t chunk = chunk_size(ptr);
+    if (chunk == 0 || chunk > s_mem_state.heap_used) {
+        return; // free(NULL), foreign pointer or a corrupted header
+    }
+    
+    s_mem_state.heap_used -= chunk;
+    s_mem_state.heap_total_freed += chunk;
+    s_mem_state.free_count++;
+#if MEM_MONITOR_MAILBOX
+    publish_mailbox();
+#endif
+}
+
+uint8_t mem_monitor_find_alloc(const void* ptr, uint16_t* callsite, uint16_t* seq) {
+    (void)ptr;
+    *callsite = 0;
+    *seq = 0;
+    return 0; // No per-block records in header mode
+}
+
+#else // MEM_TRACK_TABLE
+
 /**
  * @brief Track a new heap allocation
  * @param ptr Pointer returned by malloc
@@ -125,11 +438,20 @@ void mem_monitor_track_alloc(void* ptr, uint16_t size) {
             s_alloc_table[i].ptr = ptr;
             s_alloc_table[i].size = size;
             s_alloc_table[i].active = 1;
+#if MEM_MONITOR_CALLSITE_DEPTH > 0
+            s_alloc_table[i].callsite = 0;
+#endif
+#if MEM_MONITOR_FRAG_BLAME
+            s_alloc_seq[i] = s_mem_state.alloc_count;
+#endif
             
             // Update statistics
             s_mem_state.heap_used += size;
             s_mem_state.heap_total_allocated += size;
             s_mem_state.alloc_count++;
+#if MEM_MONITOR_MAILBOX
+            publish_mailbox();
+#endif
             return;
         }
     }
@@ -155,8 +477,20 @@ void mem_monitor_track_free(void* ptr) {
             s_mem_state.heap_total_freed += s_alloc_table[i].size;
             s_mem_state.free_count++;
             
+#if MEM_MONITOR_CALLSITE_DEPTH > 0
+            // Close the lifetime of a sampled block for host-side tools
+            if (s_alloc_table[i].callsite) {
+                uart_puts_P(PSTR("[HEAP] F "));
+                uart_print_hex16((uint16_t)ptr);
+                uart_newline();
+            }
+#endif
+            
             // Mark slot as free
             s_alloc_table[i].active = 0;
+#if MEM_MONITOR_MAILBOX
+            publish_mailbox();
+#endif
             return;
         }
     }
@@ -164,6 +498,134 @@ void mem_monitor_track_free(void* ptr) {
     // Freeing untracked pointer - possible double-free or corruption
 }
 
+uint8_t mem_monitor_find_alloc(const void* ptr, uint16_t* callsite, uint16_t* seq) {
+    *callsite = 0;
+    *seq = 0;
+    for (uint8_t i = 0; i < MAX_HEAP_ALLOCATIONS; i++) {
+        if (s_alloc_table[i].active && s_alloc_table[i].ptr == ptr) {
+#if MEM_MONITOR_CALLSITE_DEPTH > 0
+            // 1 marks a sampled block whose caller was not recovered
+            *callsite = s_alloc_table[i].callsite > 1 ? s_alloc_table[i].callsite : 0;
+#endif
+#if MEM_MONITOR_FRAG_BLAME
+            *seq = s_alloc_seq[i];
+#endif
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#endif // MEM_MONITOR_TRACK_MODE
+
+// ============================================================================
+// CALL-SITE ATTRIBUTION
+// ============================================================================
+
+#if MEM_MONITOR_CALLSITE_DEPTH > 0
+
+#if MEM_MONITOR_CALLSITE_DEPTH > 4
+#error "MEM_MONITOR_CALLSITE_DEPTH must be between 0 and 4"
+#endif
+
+#if MEM_MONITOR_TRACK_MODE != MEM_TRACK_TABLE
+#error "Call-site capture stores sites in the allocation table (MEM_TRACK_TABLE)"
+#endif
+
+// Maximum size of __wrap_malloc in words (locates its return address)
+#define WRAPPER_MAX_WORDS 64
+
+extern uint8_t _etext;   // End of program code (flash byte address)
+
+extern "C" void* __wrap_malloc(size_t size);
+
+static uint16_t s_callsite_sample;
+
+/**
+ * @brief Check whether a stacked word is a plausible return address
+ * @param ret Return address as pushed by CALL/RCALL (flash word address)
+ * @return 1 if the preceding instruction is a call, 0 otherwise
+ * 
+ * AVR has no frame chain, so the stack is searched for values that point
+ * just behind a CALL (2 words: 1001 010k kkkk 111k), RCALL (1101 kkkk kkkk
+ * kkkk) or ICALL/EICALL instruction in flash.
+ */
+static uint8_t is_return_address(uint16_t ret) {
+    if (ret < 2 || ret > ((uint16_t)&_etext >> 1)) {
+        return 0;
+    }
+    
+    uint16_t prev = pgm_read_word((ret - 1) << 1);
+    if ((prev & 0xF000) == 0xD000 || prev == 0x9509 || prev == 0x9519) {
+        return 1; // RCALL, ICALL, EICALL
+    }
+    
+    uint16_t prev2 = pgm_read_word((ret - 2) << 1);
+    return (prev2 & 0xFE0E) == 0x940E; // CALL
+}
+
+void __attribute__((noinline)) mem_monitor_record_callsite(void* ptr, uint16_t size) {
+    if (++s_callsite_sample < MEM_MONITOR_CALLSITE_SAMPLE_RATE) {
+        return;
+    }
+    s_callsite_sample = 0;
+    
+    // Untracked block (table full): its free would never be logged, so an
+    // A event here would show up as a leak forever
+    uint8_t slot = 0;
+    while (slot < MAX_HEAP_ALLOCATIONS &&
+           !(s_alloc_table[slot].active && s_alloc_table[slot].ptr == ptr)) {
+        slot++;
+    }
+    if (slot == MAX_HEAP_ALLOCATIONS) {
+        return;
+    }
+    
+    // Return addresses are stored high byte first (at the lower address).
+    // Everything up to and including our own return into __wrap_malloc
+    // belongs to this frame; the caller chain starts right after it.
+    uint16_t wrapper = (uint16_t)(void*)&__wrap_malloc;
+    uint16_t sites[MEM_MONITOR_CALLSITE_DEPTH];
+    uint8_t found = 0;
+    uint8_t in_chain = 0;
+    
+    const uint8_t* scan = (const uint8_t*)mem_monitor_get_stack_pointer() + 1;
+    const uint8_t* end = scan + MEM_MONITOR_CALLSITE_SCAN_BYTES;
+    if (end > (const uint8_t*)RAMEND) {
+        end = (const uint8_t*)RAMEND;
+    }
+    
+    while (scan < end && found < MEM_MONITOR_CALLSITE_DEPTH) {
+        uint16_t ret = ((uint16_t)scan[0] << 8) | scan[1];
+        if (!is_return_address(ret)) {
+            scan++;
+            continue;
+        }
+        
+        if (in_chain) {
+            sites[found++] = ret << 1; // Report flash byte addresses
+        } else if (ret - wrapper < WRAPPER_MAX_WORDS) {
+            in_chain = 1;
+        }
+        scan += 2;
+    }
+    
+    // Mark the block as sampled (1 = sampled, caller not recovered)
+    s_alloc_table[slot].callsite = found ? sites[0] : 1;
+    
+    uart_puts_P(PSTR("[HEAP] A "));
+    uart_print_hex16((uint16_t)ptr);
+    uart_putc(' ');
+    uart_print_u16(size);
+    for (uint8_t i = 0; i < found; i++) {
+        uart_putc(' ');
+        uart_print_hex16(sites[i]);
+    }
+    uart_newline();
+}
+
+#endif // MEM_MONITOR_CALLSITE_DEPTH > 0
+
 // ============================================================================
 // STACK MONITORING
 // ============================================================================
@@ -175,6 +637,16 @@ void mem_monitor_track_free(void* ptr) {
  * Scans from heap end upward until non-sentinel byte found.
  * This indicates the deepest stack growth since initialization.
  */
+#if MEM_MONITOR_PAINT_MODE == MEM_PAINT_GUARD
+static uint16_t scan_stack_usage(void) {
+    // Band intact: all we know is the depth at this update
+    uint8_t reached = guard_scan(0);
+    if (reached == s_guard_len) {
+        return mem_monitor_get_current_stack_usage();
+    }
+    return RAMEND - (uint16_t)(s_guard_base + reached);
+}
+#else
 static uint16_t scan_stack_usage(void) {
     uint8_t* heap_end = __brkval ? __brkval : &__heap_start;
     uint8_t* scan_ptr = heap_end;
@@ -190,6 +662,7 @@ static uint16_t scan_stack_usage(void) {
     
     return max_usage;
 }
+#endif
 
 uint16_t mem_monitor_get_current_stack_usage(void) {
     uint16_t current_sp = mem_monitor_get_stack_pointer();
@@ -200,6 +673,12 @@ uint16_t mem_monitor_get_max_stack_usage(void) {
     return s_mem_state.max_stack_usage;
 }
 
+void mem_monitor_note_stack_usage(uint16_t bytes) {
+    if (bytes > s_mem_state.max_stack_usage) {
+        s_mem_state.max_stack_usage = bytes;
+    }
+}
+
 uint16_t mem_monitor_get_free_stack_space(void) {
     uint16_t current_sp = mem_monitor_get_stack_pointer();
     uint8_t* heap_end = __brkval ? __brkval : &__heap_start;
@@ -211,6 +690,40 @@ uint16_t mem_monitor_get_free_stack_space(void) {
     return 0; // Already collided!
 }
 
+uint16_t mem_monitor_stack_headroom(void) {
+    uint16_t free_space = mem_monitor_get_free_stack_space();
+    
+    if (free_space <= MEM_MONITOR_ISR_STACK_RESERVE) {
+        return 0;
+    }
+    return free_space - MEM_MONITOR_ISR_STACK_RESERVE;
+}
+
+uint8_t mem_monitor_stack_reserve(uint16_t bytes, MemStackReservation* r) {
+    if (mem_monitor_stack_headroom() < bytes) {
+        return 0;
+    }
+    
+    // Lowest address the reserved stack (plus the ISR reserve) may reach
+    char* limit = (char*)(mem_monitor_get_stack_pointer() - bytes -
+                          MEM_MONITOR_ISR_STACK_RESERVE);
+    
+    MEM_CRITICAL_ENTER(MEM_CS_STACK_RESERVE);
+    r->prev_heap_end = __malloc_heap_end;
+    // Never raise an enclosing reservation's limit
+    if (__malloc_heap_end == 0 || limit < __malloc_heap_end) {
+        __malloc_heap_end = limit;
+    }
+    MEM_CRITICAL_EXIT(MEM_CS_STACK_RESERVE);
+    return 1;
+}
+
+void mem_monitor_stack_release(const MemStackReservation* r) {
+    MEM_CRITICAL_ENTER(MEM_CS_STACK_RESERVE);
+    __malloc_heap_end = r->prev_heap_end;
+    MEM_CRITICAL_EXIT(MEM_CS_STACK_RESERVE);
+}
+
 // ============================================================================
 // HEAP ANALYSIS
 // ============================================================================
@@ -273,6 +786,15 @@ uint8_t mem_monitor_check_collision(void) {
         return 1;
     }
     
+#if MEM_MONITOR_PAINT_MODE == MEM_PAINT_GUARD
+    // The stack reached into the band since it was painted
+    if (s_guard_tripped || guard_scan(0) < s_guard_len) {
+        s_guard_tripped = 1;
+        s_mem_state.collision_warning = 1;
+        return 1;
+    }
+#endif
+    
     s_mem_state.collision_warning = 0;
     return 0;
 }
@@ -282,6 +804,12 @@ uint8_t mem_monitor_check_collision(void) {
 // ============================================================================
 
 void mem_monitor_update(void) {
+    s_mem_state.update_count++;
+    
+#if MEM_MONITOR_DEFERRED_FREE
+    mem_monitor_free_drain();
+#endif
+    
     // Scan stack for maximum penetration
     uint16_t max_stack = scan_stack_usage();
     if (max_stack > s_mem_state.max_stack_usage) {
@@ -290,6 +818,14 @@ void mem_monitor_update(void) {
     
     // Check for collision
     mem_monitor_check_collision();
+    
+#if MEM_MONITOR_MAILBOX
+    publish_mailbox();
+#endif
+}
+
+uint16_t mem_monitor_get_update_count(void) {
+    return s_mem_state.update_count;
 }
 
 void mem_monitor_get_stats(MemoryStats* stats) {
@@ -360,6 +896,28 @@ void mem_monitor_print_diagnostics(void) {
     uart_print_float(stats.fragmentation_ratio * 100.0f);
     uart_puts_P(PSTR("%\r\n"));
     
+#if MEM_MONITOR_PAINT_MODE == MEM_PAINT_GUARD
+    uart_puts_P(PSTR("Guard Band:    "));
+    uart_print_u16(s_guard_len);
+    uart_puts_P(PSTR(" bytes @ "));
+    uart_print_hex16((uint16_t)s_guard_base);
+    if (s_guard_tripped) {
+        uart_puts_P(PSTR(" DISTURBED\r\n"));
+    } else {
+        uart_puts_P(PSTR(" OK\r\n"));
+    }
+#endif
+    
+#if MEM_MONITOR_DEFERRED_FREE
+    uart_puts_P(PSTR("Deferred Free: "));
+    uart_print_u16(s_free_queued);
+    uart_puts_P(PSTR(" queued (peak "));
+    uart_print_u16(s_free_queue_peak);
+    uart_puts_P(PSTR("), "));
+    uart_print_u16(s_free_batches);
+    uart_puts_P(PSTR(" batches\r\n"));
+#endif
+    
     uart_puts_P(PSTR("Collision:     "));
     if (stats.collision_warning) {
         uart_puts_P(PSTR("*** WARNING ***\r\n"));
@@ -370,6 +928,49 @@ void mem_monitor_print_diagnostics(void) {
     uart_puts_P(PSTR("\r\n"));
 }
 
+#if MEM_MONITOR_IRQ_LATENCY
+void mem_monitor_print_irq_latency(void) {
+    static const char site_stack_pointer[] PROGMEM = "stack_pointer";
+    static const char site_mailbox[] PROGMEM = "mailbox";
+    static const char site_isr_profile[] PROGMEM = "isr_profile";
+    static const char site_pc_profile[] PROGMEM = "pc_profile";
+    static const char site_stack_reserve[] PROGMEM = "stack_reserve";
+    static const char site_stack_limit[] PROGMEM = "stack_limit";
+    static const char site_provider[] PROGMEM = "provider";
+    static const char* const site_names[MEM_CS_COUNT] PROGMEM = {
+        site_stack_pointer,
+        site_mailbox,
+        site_isr_profile,
+        site_pc_profile,
+        site_stack_reserve,
+        site_stack_limit,
+        site_provider,
+    };
+    
+    for (uint8_t i = 0; i < MEM_CS_COUNT; i++) {
+        // Copy with interrupts off so an ISR update cannot tear the values
+        uint8_t sreg = SREG;
+        __asm__ __volatile__ ("cli" ::: "memory");
+        CriticalSectionStats snap = mem_critical_stats[i];
+        SREG = sreg;
+        
+        uart_puts_P(PSTR("[IRQOFF] "));
+        uart_puts_P((const char*)pgm_read_word(&site_names[i]));
+        uart_puts_P(PSTR(" count="));
+        uart_print_u16(snap.count);
+        uart_puts_P(PSTR(" max="));
+        uart_print_u16(snap.max_cycles);
+        uart_newline();
+    }
+}
+#endif
+
+void mem_monitor_mark_phase(const char* name) {
+    uart_puts_P(PSTR("[PHASE] "));
+    uart_puts_P(name);
+    uart_newline();
+}
+
 // ============================================================================
 // MALLOC/FREE WRAPPERS (override default allocator)
 // ============================================================================
@@ -393,16 +994,104 @@ extern "C" {
      * @brief Wrapped malloc with tracking
      */
     void* __wrap_malloc(size_t size) {
+#if MEM_MONITOR_DEFERRED_FREE
+        // Low on room: give queued blocks back before the heap grows
+        if (s_free_queued != 0 &&
+            mem_monitor_get_free_stack_space() < MEM_DEFERRED_FREE_PRESSURE) {
+            mem_monitor_free_drain();
+        }
+#endif
         void* ptr = __real_malloc(size);
+#if MEM_MONITOR_DEFERRED_FREE
+        if (ptr == NULL && s_free_queued != 0) {
+            mem_monitor_free_drain();
+            ptr = __real_malloc(size);
+        }
+#endif
+#if MEM_MONITOR_ALLOC_FORENSICS
+        if (ptr == NULL) {
+            mem_alloc_failure_record((uint16_t)size,
+                                     (uint16_t)__builtin_return_address(0) << 1);
+        }
+#endif
+#if MEM_MONITOR_PAINT_MODE == MEM_PAINT_GUARD
+        guard_follow_heap();
+#endif
+#if MEM_MONITOR_STACK_LIMIT
+        mem_stack_limit_after_malloc((uint16_t)__builtin_return_address(0) << 1);
+#endif
         mem_monitor_track_alloc(ptr, (uint16_t)size);
+#if MEM_MONITOR_CALLSITE_DEPTH > 0
+        if (ptr != NULL) {
+            mem_monitor_record_callsite(ptr, (uint16_t)size);
+        }
+#endif
         return ptr;
     }
     
     /**
      * @brief Wrapped free with tracking
+     * 
+     * With MEM_MONITOR_DEFERRED_FREE the block is only queued (O(1)); it
+     * is accounted as freed at once, but stays allocated until the drain.
      */
     void __wrap_free(void* ptr) {
         mem_monitor_track_free(ptr);
+#if MEM_MONITOR_DEFERRED_FREE
+        if (ptr == NULL) {
+            return;
+        }
+        if (s_free_queued == MEM_MONITOR_DEFERRED_FREE) {
+            mem_monitor_free_drain();
+        }
+        s_free_queue[s_free_queued++] = ptr;
+        if (s_free_queued > s_free_queue_peak) {
+            s_free_queue_peak = s_free_queued;
+        }
+#else
         __real_free(ptr);
+#if MEM_MONITOR_PAINT_MODE == MEM_PAINT_GUARD
+        guard_follow_heap();
+#endif
+#if MEM_MONITOR_STACK_LIMIT
+        mem_stack_limit_after_free();
+#endif
+#endif
+    }
+}
+
+#if MEM_MONITOR_DEFERRED_FREE
+void mem_monitor_free_drain(void) {
+    uint8_t count = s_free_queued;
+    if (count == 0) {
+        return;
+    }
+    
+    // Insertion sort, highest address first (at most 16 entries)
+    for (uint8_t i = 1; i < count; i++) {
+        void* ptr = s_free_queue[i];
+        uint8_t j = i;
+        while (j > 0 && (uint8_t*)s_free_queue[j - 1] < (uint8_t*)ptr) {
+            s_free_queue[j] = s_free_queue[j - 1];
+            j--;
+        }
+        s_free_queue[j] = ptr;
+    }
+    
+    for (uint8_t i = 0; i < count; i++) {
+        __real_free(s_free_queue[i]);
+    }
+    s_free_queued = 0;
+    if (s_free_batches != 0xFFFF) {
+        s_free_batches++;
     }
+    
+    // The heap end moves once per batch, not once per block
+#if MEM_MONITOR_PAINT_MODE == MEM_PAINT_GUARD
+    guard_follow_heap();
+#endif
+#if MEM_MONITOR_STACK_LIMIT
+    mem_stack_limit_after_free();
+#endif
 }
+#endif // MEM_MONITOR_DEFERRED_FREE
@@ -0,0 +1,155 @@
+/**
+ * @file pc_profile.cpp
+ * @brief PC sampling ISR, sample hash and telemetry drain
+ */
+
+#include "pc_profile.h"
+
+#if MEM_MONITOR_PC_PROFILE
+
+#include "mem_critical.h"
+#include "sampling_isr.h"
+#include "timebase.h"
+#include "uart_driver.h"
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <string.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+// Timer1 cycles between samples
+#define PC_PROFILE_PERIOD (F_CPU / MEM_PC_PROFILE_HZ)
+
+static_assert(PC_PROFILE_PERIOD > 0 && PC_PROFILE_PERIOD < 65536UL,
+              "MEM_PC_PROFILE_HZ out of range for the 16-bit timebase");
+static_assert((MEM_PC_PROFILE_SLOTS & (MEM_PC_PROFILE_SLOTS - 1)) == 0,
+              "MEM_PC_PROFILE_SLOTS must be a power of two");
+static_assert(MEM_PC_PROFILE_PROBES >= 1 && MEM_PC_PROFILE_PROBES <= MEM_PC_PROFILE_SLOTS,
+              "MEM_PC_PROFILE_PROBES must be between 1 and MEM_PC_PROFILE_SLOTS");
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+static PcProfileEntry s_table[MEM_PC_PROFILE_SLOTS];
+static uint16_t s_samples;    // Samples since the last drain (saturating)
+static uint16_t s_dropped;    // Samples that found no free entry
+
+// ============================================================================
+// SAMPLING
+// ============================================================================
+
+extern "C" void mem_pc_profile_sample(uint16_t pc_word, uint16_t sp)
+    __attribute__((used, externally_visible));
+
+/**
+ * @brief Record one sample (called from the naked ISR, interrupts off)
+ * @param pc_word Interrupted PC (flash word address)
+ * @param sp SP of the interrupted context
+ */
+void mem_pc_profile_sample(uint16_t pc_word, uint16_t sp) {
+    OCR1A += (uint16_t)PC_PROFILE_PERIOD;
+
+    if (s_samples != 0xFFFF) {
+        s_samples++;
+    }
+
+    uint16_t bucket = (uint16_t)(pc_word << 1) >> MEM_PC_PROFILE_BUCKET_SHIFT;
+    uint16_t key = bucket + 1;
+    uint16_t depth = RAMEND - sp;
+    uint8_t h = (uint8_t)(bucket ^ (bucket >> 5)) & (MEM_PC_PROFILE_SLOTS - 1);
+
+    for (uint8_t probe = 0; probe < MEM_PC_PROFILE_PROBES; probe++) {
+        PcProfileEntry* e = &s_table[h];
+        if (e->key == key) {
+            if (e->count != 0xFFFF) {
+                e->count++;
+            }
+            if (depth > e->max_depth) {
+                e->max_depth = depth;
+            }
+            return;
+        }
+        if (e->key == 0) {
+            e->key = key;
+            e->count = 1;
+            e->max_depth = depth;
+            return;
+        }
+        h = (h + 1) & (MEM_PC_PROFILE_SLOTS - 1);
+    }
+
+    if (s_dropped != 0xFFFF) {
+        s_dropped++;
+    }
+}
+
+// Naked trampoline: passes the interrupted PC and SP to the sampler
+MEM_SAMPLING_ISR(TIMER1_COMPA_vect, mem_pc_profile_sample)
+
+// ============================================================================
+// SETUP & DRAIN
+// ============================================================================
+
+void mem_pc_profile_init(void) {
+    timebase_init();
+
+    MEM_CRITICAL_ENTER(MEM_CS_PC_PROFILE);
+    memset(s_table, 0, sizeof(s_table));
+    s_samples = 0;
+    s_dropped = 0;
+    OCR1A = timebase_now() + (uint16_t)PC_PROFILE_PERIOD;
+    TIFR1 = (1 << OCF1A);     // Write 1 to clear a stale match
+    TIMSK1 |= (1 << OCIE1A);
+    MEM_CRITICAL_EXIT(MEM_CS_PC_PROFILE);
+}
+
+void mem_monitor_print_pc_profile(void) {
+    uint16_t samples;
+    uint16_t dropped;
+    {
+        MEM_CRITICAL_ENTER(MEM_CS_PC_PROFILE);
+        samples = s_samples;
+        dropped = s_dropped;
+        s_samples = 0;
+        s_dropped = 0;
+        MEM_CRITICAL_EXIT(MEM_CS_PC_PROFILE);
+    }
+
+    uart_puts_P(PSTR("[PROF] samples="));
+    uart_print_u16(samples);
+    uart_puts_P(PSTR(" dropped="));
+    uart_print_u16(dropped);
+    uart_puts_P(PSTR(" hz="));
+    uart_print_u16(MEM_PC_PROFILE_HZ);
+    uart_puts_P(PSTR(" bucket="));
+    uart_print_u16(1u << MEM_PC_PROFILE_BUCKET_SHIFT);
+    uart_newline();
+
+    // One entry per critical section; a sample arriving mid-drain may
+    // re-create a key in an already drained entry, which the host merges
+    for (uint8_t i = 0; i < MEM_PC_PROFILE_SLOTS; i++) {
+        PcProfileEntry e;
+        {
+            MEM_CRITICAL_ENTER(MEM_CS_PC_PROFILE);
+            e = s_table[i];
+            s_table[i].key = 0;
+            MEM_CRITICAL_EXIT(MEM_CS_PC_PROFILE);
+        }
+        if (e.key == 0) {
+            continue;
+        }
+
+        uart_puts_P(PSTR("[PROF] pc="));
+        uart_print_hex16((uint16_t)((e.key - 1) << MEM_PC_PROFILE_BUCKET_SHIFT));
+        uart_puts_P(PSTR(" n="));
+        uart_print_u16(e.count);
+        uart_puts_P(PSTR(" depth="));
+        uart_print_u16(e.max_depth);
+        uart_newline();
+    }
+}
+
+#endif // MEM_MONITOR_PC_PROFILE
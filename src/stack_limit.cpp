@@ -0,0 +1,203 @@
+/**
+ * @file stack_limit.cpp
+ * @brief Stack-limit checks, crash record and fault reporting
+ */
+
+#include "stack_limit.h"
+
+#if MEM_MONITOR_STACK_LIMIT
+
+#include "mem_critical.h"
+#include "sampling_isr.h"
+#include "timebase.h"
+#include "uart_driver.h"
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+// Timer1 cycles between timer checks
+#define STACK_LIMIT_PERIOD (F_CPU / MEM_STACK_LIMIT_HZ)
+
+static_assert(STACK_LIMIT_PERIOD > 0 && STACK_LIMIT_PERIOD < 65536UL,
+              "MEM_STACK_LIMIT_HZ out of range for the 16-bit timebase");
+
+extern uint8_t __heap_start;
+extern uint8_t *__brkval;
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+// Not cleared by the C runtime, so a record survives a watchdog reset
+MemCrashRecord mem_crash_record __attribute__((section(".noinit")));
+
+// Limit cached from the heap end. Only written with interrupts disabled,
+// so the timer ISR never sees a half-updated __brkval.
+static uint16_t s_floor;
+
+// Breach reported; cleared once a check finds SP above the floor again
+static uint8_t s_latched;
+
+#if MEM_STACK_LIMIT_RESET
+/**
+ * A watchdog reset leaves the watchdog running with a short timeout;
+ * turn it off before the C runtime and main() get a chance to trip it.
+ */
+static void stack_limit_wdt_off(void) __attribute__((naked, used, section(".init3")));
+static void stack_limit_wdt_off(void) {
+    MCUSR = 0;
+    wdt_disable();
+}
+#endif
+
+// ============================================================================
+// FAULT REPORTING
+// ============================================================================
+
+static void print_fault(const MemCrashRecord* rec, uint8_t previous) {
+    static const char src_timer[] PROGMEM = "timer";
+    static const char src_malloc[] PROGMEM = "malloc";
+    static const char src_check[] PROGMEM = "check";
+    static const char* const src_names[] PROGMEM = {
+        src_timer,
+        src_malloc,
+        src_check,
+    };
+
+    uart_puts_P(PSTR("[FAULT] stack-limit src="));
+    if (rec->source <= MEM_FAULT_SRC_CHECK) {
+        uart_puts_P((const char*)pgm_read_word(&src_names[rec->source]));
+    } else {
+        uart_putc('?');
+    }
+    uart_puts_P(PSTR(" pc="));
+    uart_print_hex16(rec->pc);
+    uart_puts_P(PSTR(" sp="));
+    uart_print_hex16(rec->sp);
+    uart_puts_P(PSTR(" floor="));
+    uart_print_hex16(rec->floor);
+    uart_puts_P(PSTR(" heap="));
+    uart_print_hex16(rec->heap_end);
+    if (previous) {
+        uart_puts_P(PSTR(" reset="));
+        uart_print_u16(rec->reset);
+    }
+    uart_newline();
+}
+
+/**
+ * @brief Record and report a breach
+ *
+ * Runs with interrupts disabled from start to end (including the UART
+ * output); this is a fault path, not a budgeted critical section.
+ */
+static void fault(uint8_t source, uint16_t pc, uint16_t sp, uint16_t floor) {
+    uint8_t sreg = SREG;
+    __asm__ __volatile__ ("cli" ::: "memory");
+
+    if (s_latched) {
+        SREG = sreg;
+        return;
+    }
+    s_latched = 1;
+
+    mem_crash_record.source = source;
+    mem_crash_record.reset = MEM_STACK_LIMIT_RESET ? 1 : 0;
+    mem_crash_record.pc = pc;
+    mem_crash_record.sp = sp;
+    mem_crash_record.floor = floor;
+    mem_crash_record.heap_end = floor - MEM_STACK_LIMIT_MARGIN;
+    mem_crash_record.magic = MEM_CRASH_MAGIC;
+
+    print_fault(&mem_crash_record, 0);
+
+#if MEM_STACK_LIMIT_RESET
+    wdt_enable(WDTO_15MS);
+    for (;;) {
+    }
+#endif
+
+    SREG = sreg;
+}
+
+static inline void check(uint8_t source, uint16_t pc, uint16_t sp) {
+    uint16_t floor = s_floor;
+    if (sp >= floor) {
+        s_latched = 0;
+        return;
+    }
+    fault(source, pc, sp, floor);
+}
+
+// ============================================================================
+// CHECK POINTS
+// ============================================================================
+
+static void refresh_floor(void) {
+    MEM_CRITICAL_ENTER(MEM_CS_STACK_LIMIT);
+    uint8_t* heap_end = __brkval ? __brkval : &__heap_start;
+    s_floor = (uint16_t)heap_end + MEM_STACK_LIMIT_MARGIN;
+    MEM_CRITICAL_EXIT(MEM_CS_STACK_LIMIT);
+}
+
+uint16_t mem_monitor_stack_floor(void) {
+    return s_floor;
+}
+
+extern "C" void mem_stack_limit_sample(uint16_t pc_word, uint16_t sp)
+    __attribute__((used, externally_visible));
+
+/**
+ * @brief Timer check (called from the naked ISR, interrupts off)
+ * @param pc_word Interrupted PC (flash word address)
+ * @param sp SP of the interrupted context
+ */
+void mem_stack_limit_sample(uint16_t pc_word, uint16_t sp) {
+    OCR1B += (uint16_t)STACK_LIMIT_PERIOD;
+    check(MEM_FAULT_SRC_TIMER, pc_word << 1, sp);
+}
+
+MEM_SAMPLING_ISR(TIMER1_COMPB_vect, mem_stack_limit_sample)
+
+void __attribute__((noinline)) mem_monitor_stack_check(void) {
+    // SPL/SPH need no cli: an ISR restores SP before we continue
+    uint16_t sp = SP;
+    check(MEM_FAULT_SRC_CHECK, (uint16_t)__builtin_return_address(0) << 1, sp);
+}
+
+void mem_stack_limit_after_malloc(uint16_t caller) {
+    refresh_floor();
+    check(MEM_FAULT_SRC_MALLOC, caller, SP);
+}
+
+void mem_stack_limit_after_free(void) {
+    refresh_floor();
+}
+
+// ============================================================================
+// SETUP
+// ============================================================================
+
+void mem_stack_limit_init(void) {
+    // A record left behind by the previous run (watchdog reset or not)
+    if (mem_crash_record.magic == MEM_CRASH_MAGIC) {
+        print_fault(&mem_crash_record, 1);
+        mem_crash_record.magic = 0;
+    }
+
+    s_latched = 0;
+    refresh_floor();
+
+    timebase_init();
+    MEM_CRITICAL_ENTER(MEM_CS_STACK_LIMIT);
+    OCR1B = timebase_now() + (uint16_t)STACK_LIMIT_PERIOD;
+    TIFR1 = (1 << OCF1B);     // Write 1 to clear a stale match
+    TIMSK1 |= (1 << OCIE1B);
+    MEM_CRITICAL_EXIT(MEM_CS_STACK_LIMIT);
+}
+
+#endif // MEM_MONITOR_STACK_LIMIT
@@ -0,0 +1,47 @@
+/**
+ * @file timebase.cpp
+ * @brief Timer1 free-running counter setup
+ */
+
+#include "timebase.h"
+#include <avr/interrupt.h>
+
+#if MEM_MONITOR_ISR_PROFILE
+// Timer1 wraps counted by the overflow ISR (upper half of timebase_now32)
+static volatile uint16_t s_overflows;
+#endif
+
+void timebase_init(void) {
+    if (TCCR1B & ((1 << CS12) | (1 << CS11) | (1 << CS10))) {
+        return; // Already running
+    }
+    
+    // Normal mode (WGM13:0 = 0), no output compare pins, clk/1
+    TCCR1A = 0;
+    TCNT1 = 0;
+    TCCR1B = (1 << CS10);
+}
+
+#if MEM_MONITOR_ISR_PROFILE
+void timebase_enable_overflow(void) {
+    TIFR1 = (1 << TOV1);   // Discard a stale overflow flag (write 1 to clear)
+    TIMSK1 |= (1 << TOIE1);
+}
+
+uint32_t timebase_now32(void) {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t low = TCNT1;
+    uint16_t high = s_overflows;
+    // Wrapped before the read but the ISR has not run yet
+    if ((TIFR1 & (1 << TOV1)) && low < 0x8000) {
+        high++;
+    }
+    SREG = sreg;
+    return ((uint32_t)high << 16) | low;
+}
+
+ISR(TIMER1_OVF_vect) {
+    s_overflows++;
+}
+#endif // MEM_MONITOR_ISR_PROFILE
@@ -64,6 +64,25 @@ void uart_print_u16(uint16_t value) {
     uart_puts(ptr);
 }
 
+void uart_print_u32(uint32_t value) {
+    // 16-bit path avoids the 32-bit division for small values
+    if (value <= 0xFFFF) {
+        uart_print_u16((uint16_t)value);
+        return;
+    }
+    
+    static char buffer[11]; // Max 10 digits + null
+    char* ptr = buffer + sizeof(buffer) - 1;
+    *ptr = '\0';
+    
+    while (value > 0) {
+        *--ptr = '0' + (value % 10);
+        value /= 10;
+    }
+    
+    uart_puts(ptr);
+}
+
 void uart_print_hex16(uint16_t value) {
     static const char hex_digits[] PROGMEM = "0123456789ABCDEF";
     
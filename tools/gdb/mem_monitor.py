@@ -0,0 +1,199 @@
+"""
+@file mem_monitor.py
+@brief GDB helpers for the memory monitor debugger mailbox
+
+Load in avr-gdb (simavr's GDB stub, debugWIRE/JTAG bridges):
+
+    (gdb) source tools/gdb/mem_monitor.py
+    (gdb) mem-mailbox          # Current MemoryStats snapshot
+    (gdb) mem-allocs           # Active entries of the allocation table
+    (gdb) print mem_mailbox    # Pretty-printed mailbox
+
+The commands decode the mailbox from raw SRAM at its fixed address, so they
+also work when the ELF is not loaded. SRAM is at 0x800000 + address in the
+AVR GDB address space.
+"""
+
+import struct
+
+import gdb
+import gdb.printing
+
+SRAM_OFFSET = 0x800000
+MAILBOX_ADDR = 0x0100
+MAILBOX_MAGIC = 0x4D4D
+MAILBOX_VERSION = 1
+
+# Header: magic, version, size, generation
+HEADER = struct.Struct("<HBBH")
+# MemoryStats (avr-gcc packs without padding; float is IEEE single)
+STATS = struct.Struct("<11HfB")
+STATS_FIELDS = (
+    "total_sram", "static_data", "static_bss", "heap_used",
+    "heap_total_allocated", "heap_total_freed", "alloc_count", "free_count",
+    "current_stack_usage", "max_stack_usage", "free_ram",
+    "fragmentation_ratio", "collision_warning",
+)
+# Tail: alloc_table pointer, length, entry size
+TAIL = struct.Struct("<HBB")
+
+READ_RETRIES = 16
+
+
+def read_sram(addr, length):
+    mem = gdb.selected_inferior().read_memory(SRAM_OFFSET + addr, length)
+    return bytes(mem)
+
+
+def read_mailbox():
+    """Return (generation, stats dict, table address, length, entry size)."""
+    total = HEADER.size + STATS.size + TAIL.size
+    for _ in range(READ_RETRIES):
+        raw = read_sram(MAILBOX_ADDR, total)
+        magic, version, size, gen = HEADER.unpack_from(raw, 0)
+        if magic != MAILBOX_MAGIC:
+            raise gdb.GdbError("no mailbox at 0x%04x (magic 0x%04x); "
+                               "mem_monitor_init() not run yet?" % (MAILBOX_ADDR, magic))
+        if version != MAILBOX_VERSION:
+            raise gdb.GdbError("unsupported mailbox version %d" % version)
+        if gen & 1:
+            continue  # Update in progress
+        (gen_after,) = struct.unpack_from("<H", read_sram(MAILBOX_ADDR + 4, 2))
+        if gen_after != gen:
+            continue
+        stats = dict(zip(STATS_FIELDS, STATS.unpack_from(raw, HEADER.size)))
+        table, length, entry_size = TAIL.unpack_from(raw, HEADER.size + STATS.size)
+        return gen, stats, table, length, entry_size
+    raise gdb.GdbError("mailbox kept changing while being read")
+
+
+def format_stats(stats):
+    lines = []
+    for name in STATS_FIELDS:
+        value = stats[name]
+        if name == "fragmentation_ratio":
+            lines.append("  %-22s %.1f%%" % (name, value * 100.0))
+        else:
+            lines.append("  %-22s %d" % (name, value))
+    return "\n".join(lines)
+
+
+def read_alloc_table(table, length, entry_size):
+    raw = read_sram(table, length * entry_size)
+    entries = []
+    for i in range(length):
+        off = i * entry_size
+        ptr, size, active = struct.unpack_from("<HHB", raw, off)
+        callsite = None
+        if entry_size >= 7:
+            (callsite,) = struct.unpack_from("<H", raw, off + 5)
+        entries.append((i, ptr, size, active, callsite))
+    return entries
+
+
+class MemMailboxCommand(gdb.Command):
+    """Print the memory monitor statistics mailbox."""
+
+    def __init__(self):
+        super(MemMailboxCommand, self).__init__("mem-mailbox", gdb.COMMAND_DATA)
+
+    def invoke(self, arg, from_tty):
+        gen, stats, table, length, _ = read_mailbox()
+        print("mailbox @0x%04x generation %d (table @0x%04x, %d slots)"
+              % (MAILBOX_ADDR, gen, table, length))
+        print(format_stats(stats))
+
+
+class MemAllocsCommand(gdb.Command):
+    """Print the active entries of the heap allocation table."""
+
+    def __init__(self):
+        super(MemAllocsCommand, self).__init__("mem-allocs", gdb.COMMAND_DATA)
+
+    def invoke(self, arg, from_tty):
+        _, _, table, length, entry_size = read_mailbox()
+        if length == 0:
+            print("no allocation table (MEM_TRACK_HEADER build)")
+            return
+        active = [e for e in read_alloc_table(table, length, entry_size) if e[3]]
+        print("%d of %d slots active" % (len(active), length))
+        for slot, ptr, size, _, callsite in active:
+            line = "  [%2d] 0x%04x %5d bytes" % (slot, ptr, size)
+            if callsite and callsite != 1:
+                line += "  from %s" % describe_code(callsite)
+            print(line)
+
+
+def describe_code(addr):
+    """Function name for a flash byte address (return address: look at addr-1)."""
+    try:
+        block = gdb.block_for_pc(addr - 1)
+        while block and not block.function:
+            block = block.superblock
+        if block and block.function:
+            return "0x%04x <%s>" % (addr, block.function.print_name)
+    except RuntimeError:
+        pass
+    return "0x%04x" % addr
+
+
+# ============================================================================
+# PRETTY PRINTERS
+# ============================================================================
+
+class MemoryStatsPrinter(object):
+    def __init__(self, val):
+        self.val = val
+
+    def to_string(self):
+        frag = float(self.val["fragmentation_ratio"]) * 100.0
+        return ("heap %d B (%d allocs, %d frees), stack %d/%d B, free %d B, "
+                "frag %.1f%%, collision %s"
+                % (int(self.val["heap_used"]), int(self.val["alloc_count"]),
+                   int(self.val["free_count"]), int(self.val["current_stack_usage"]),
+                   int(self.val["max_stack_usage"]), int(self.val["free_ram"]), frag,
+                   "YES" if int(self.val["collision_warning"]) else "no"))
+
+
+class AllocationEntryPrinter(object):
+    def __init__(self, val):
+        self.val = val
+
+    def to_string(self):
+        if not int(self.val["active"]):
+            return "<free slot>"
+        text = "0x%04x, %d bytes" % (int(self.val["ptr"]), int(self.val["size"]))
+        fields = [f.name for f in self.val.type.fields()]
+        if "callsite" in fields and int(self.val["callsite"]) > 1:
+            text += ", from " + describe_code(int(self.val["callsite"]))
+        return text
+
+
+class MemoryMailboxPrinter(object):
+    def __init__(self, val):
+        self.val = val
+
+    def to_string(self):
+        magic = int(self.val["magic"])
+        gen = int(self.val["generation"])
+        state = "valid" if magic == MAILBOX_MAGIC else "uninitialized"
+        if gen & 1:
+            state += ", update in progress"
+        return "mailbox v%d gen %d (%s)" % (int(self.val["version"]), gen, state)
+
+    def children(self):
+        yield "stats", self.val["stats"]
+        yield "alloc_table", self.val["alloc_table"]
+
+
+def build_printers():
+    pp = gdb.printing.RegexpCollectionPrettyPrinter("mem_monitor")
+    pp.add_printer("MemoryStats", "^MemoryStats$", MemoryStatsPrinter)
+    pp.add_printer("AllocationEntry", "^AllocationEntry$", AllocationEntryPrinter)
+    pp.add_printer("MemoryMailbox", "^MemoryMailbox$", MemoryMailboxPrinter)
+    return pp
+
+
+gdb.printing.register_pretty_printer(gdb.current_objfile(), build_printers())
+MemMailboxCommand()
+MemAllocsCommand()
@@ -0,0 +1,170 @@
+/**
+ * @file membudget.cpp
+ * @brief Post-link SRAM budget check
+ *
+ * Usage:
+ *   membudget [-n top] [--min-stack bytes] [--isr-reserve bytes] build/memory_monitor.elf
+ *
+ * Adds up the statically reserved SRAM sections (.mailbox, .data, .bss,
+ * .noinit) of a linked firmware image and checks that the stack the build
+ * promised (MEM_BUDGET_MIN_STACK + MEM_MONITOR_ISR_STACK_RESERVE, exported
+ * by the monitor as __mem_budget_* absolute symbols) still fits:
+ *
+ *   membudget: build/memory_monitor.elf, SRAM 2048 bytes
+ *     .mailbox              48
+ *     .data                 48
+ *     .bss                 402
+ *       s_alloc_table           192
+ *       ...
+ *     stack (min)          256
+ *     stack (ISR)           64
+ *     committed            818
+ *     heap headroom       1230
+ *
+ * Every section lists its -n largest objects (default 8). The exit status
+ * is 1 when static data plus the stack requirement exceed the SRAM; the
+ * Makefile runs this after every link and deletes the ELF on failure.
+ */
+
+#include "../symbolizer/elf_file.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+// AVR data memory appears at this offset in the ELF address space
+constexpr uint64_t kSramOffset = 0x800000;
+constexpr uint64_t kSramStart = 0x0100;
+
+// Sections that reserve SRAM before the heap, in address order
+const char* const kStaticSections[] = {".mailbox", ".data", ".bss", ".noinit"};
+
+struct Object {
+    std::string name;
+    uint64_t size;
+};
+
+std::string demangle(const std::string& name) {
+    int status = 0;
+    char* plain = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+    if (status != 0 || !plain) {
+        return name;
+    }
+    std::string out = plain;
+    free(plain);
+    return out;
+}
+
+bool find_abs(const std::vector<memsym::ElfSymbol>& syms, const char* name, uint64_t* value) {
+    for (const memsym::ElfSymbol& s : syms) {
+        if (s.name == name) {
+            *value = s.addr;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string path;
+    size_t top = 8;
+    long min_stack = -1;
+    long isr_reserve = -1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            top = (size_t)atoi(argv[++i]);
+        } else if (arg == "--min-stack" && i + 1 < argc) {
+            min_stack = atol(argv[++i]);
+        } else if (arg == "--isr-reserve" && i + 1 < argc) {
+            isr_reserve = atol(argv[++i]);
+        } else if (arg == "-h" || arg == "--help") {
+            fprintf(stderr, "usage: membudget [-n top] [--min-stack bytes] [--isr-reserve bytes] elf\n");
+            return 2;
+        } else {
+            path = arg;
+        }
+    }
+    if (path.empty()) {
+        fprintf(stderr, "usage: membudget [-n top] [--min-stack bytes] [--isr-reserve bytes] elf\n");
+        return 2;
+    }
+
+    memsym::ElfFile elf;
+    if (elf.open(path) != 0) {
+        fprintf(stderr, "membudget: %s\n", elf.error().c_str());
+        return 1;
+    }
+    std::vector<memsym::ElfSymbol> syms = elf.symbols();
+
+    // Stack requirement and SRAM end exported by memory_monitor.cpp
+    uint64_t v;
+    uint64_t ramend = find_abs(syms, "__mem_budget_ramend", &v) ? v : 0x08FF;
+    if (min_stack < 0) {
+        if (!find_abs(syms, "__mem_budget_min_stack", &v)) {
+            fprintf(stderr, "membudget: %s has no __mem_budget_min_stack (use --min-stack)\n",
+                    path.c_str());
+            return 1;
+        }
+        min_stack = (long)v;
+    }
+    if (isr_reserve < 0) {
+        isr_reserve = find_abs(syms, "__mem_budget_isr_reserve", &v) ? (long)v : 0;
+    }
+    uint64_t sram = ramend + 1 - kSramStart;
+
+    printf("membudget: %s, SRAM %" PRIu64 " bytes\n", path.c_str(), sram);
+
+    uint64_t committed = 0;
+    for (const char* name : kStaticSections) {
+        const memsym::ElfSection* sec = elf.section(name);
+        if (!sec || sec->size == 0 || sec->addr < kSramOffset) {
+            continue;
+        }
+        printf("  %-16s %6" PRIu64 "\n", name, sec->size);
+        committed += sec->size;
+
+        std::vector<Object> objects;
+        for (const memsym::ElfSymbol& s : syms) {
+            if (s.type == memsym::kSttObject && s.size != 0 && s.addr >= sec->addr &&
+                s.addr < sec->addr + sec->size) {
+                objects.push_back(Object{demangle(s.name), s.size});
+            }
+        }
+        std::sort(objects.begin(), objects.end(), [](const Object& a, const Object& b) {
+            return a.size != b.size ? a.size > b.size : a.name < b.name;
+        });
+
+        uint64_t listed = 0;
+        for (size_t i = 0; i < objects.size() && i < top; i++) {
+            printf("    %-28s %6" PRIu64 "\n", objects[i].name.c_str(), objects[i].size);
+            listed += objects[i].size;
+        }
+        if (listed < sec->size && !objects.empty()) {
+            printf("    %-28s %6" PRIu64 "\n", "(other)", sec->size - listed);
+        }
+    }
+
+    printf("  %-16s %6ld\n", "stack (min)", min_stack);
+    printf("  %-16s %6ld\n", "stack (ISR)", isr_reserve);
+    committed += (uint64_t)min_stack + (uint64_t)isr_reserve;
+    printf("  %-16s %6" PRIu64 "\n", "committed", committed);
+
+    if (committed > sram) {
+        printf("  %-16s %6" PRIu64 "\n", "over by", committed - sram);
+        fprintf(stderr, "membudget: SRAM over-committed by %" PRIu64 " bytes; shrink static buffers "
+                "or lower MEM_BUDGET_MIN_STACK\n", committed - sram);
+        return 1;
+    }
+    printf("  %-16s %6" PRIu64 "\n", "heap headroom", sram - committed);
+    return 0;
+}
@@ -0,0 +1,460 @@
+/**
+ * @file capture.cpp
+ * @brief Capture file writer and memory-mapped reader
+ */
+
+#include "capture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace memcap {
+
+// ============================================================================
+// SCHEMA
+// ============================================================================
+
+static const ColumnInfo kColumns[kColIdCount] = {
+    {kColTime,          8, "time_us"},
+    {kColHeapUsed,      2, "heap_used"},
+    {kColAllocCount,    2, "alloc_count"},
+    {kColFreeCount,     2, "free_count"},
+    {kColStackCurrent,  2, "stack_current"},
+    {kColStackPeak,     2, "stack_peak"},
+    {kColFreeRam,       2, "free_ram"},
+    {kColFragmentation, 2, "fragmentation_permille"},
+    {kColCollision,     2, "collision"},
+    {kColStaticData,    2, "static_data"},
+    {kColStaticBss,     2, "static_bss"},
+    {kColPhase,         2, "phase"},
+};
+
+const ColumnInfo* column_info(uint16_t id) {
+    return id < kColIdCount ? &kColumns[id] : nullptr;
+}
+
+int column_by_name(const std::string& name, ColumnId* id) {
+    for (const ColumnInfo& c : kColumns) {
+        if (name == c.name) {
+            *id = c.id;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static size_t align_up(size_t v, size_t a) {
+    return (v + a - 1) / a * a;
+}
+
+static bool extent_ok(uint64_t offset, uint64_t length, size_t size) {
+    return offset <= size && length <= size - offset;
+}
+
+static int64_t load_value(const uint8_t* p, uint16_t width) {
+    if (width == 8) {
+        int64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+CaptureWriter::CaptureWriter()
+    : file_(nullptr), rows_per_block_(0), block_rows_(0), row_count_(0),
+      data_offset_(0), last_time_(INT64_MIN) {}
+
+CaptureWriter::~CaptureWriter() {
+    if (file_) {
+        close();
+    }
+}
+
+int CaptureWriter::open(const std::string& path, uint32_t rows_per_block) {
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        error_ = "cannot create " + path;
+        return -1;
+    }
+
+    rows_per_block_ = rows_per_block ? rows_per_block : kDefaultRowsPerBlock;
+    block_rows_ = 0;
+    row_count_ = 0;
+    last_time_ = INT64_MIN;
+    index_.clear();
+    summaries_.clear();
+
+    columns_.assign(kColIdCount, std::vector<uint8_t>());
+    for (uint16_t c = 0; c < kColIdCount; c++) {
+        columns_[c].assign((size_t)rows_per_block_ * kColumns[c].width, 0);
+    }
+    block_summary_.assign(kColIdCount, MinMax{INT64_MAX, INT64_MIN});
+
+    // Placeholder header (rewritten by close()) followed by the schema
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    fwrite(&header, sizeof(header), 1, file_);
+
+    for (uint16_t c = 0; c < kColIdCount; c++) {
+        ColumnDesc desc;
+        memset(&desc, 0, sizeof(desc));
+        desc.id = kColumns[c].id;
+        desc.width = kColumns[c].width;
+        strncpy(desc.name, kColumns[c].name, sizeof(desc.name) - 1);
+        fwrite(&desc, sizeof(desc), 1, file_);
+    }
+
+    size_t pos = sizeof(FileHeader) + kColIdCount * sizeof(ColumnDesc);
+    data_offset_ = align_up(pos, 64);
+    static const uint8_t zeros[64] = {0};
+    fwrite(zeros, 1, data_offset_ - pos, file_);
+    return 0;
+}
+
+void CaptureWriter::append(const Sample& sample) {
+    int64_t t = sample.value[kColTime];
+    if (t < last_time_) {
+        t = last_time_;
+    }
+    last_time_ = t;
+
+    for (uint16_t c = 0; c < kColIdCount; c++) {
+        int64_t v = (c == kColTime) ? t : sample.value[c];
+        if (c != kColTime) {
+            // Telemetry fields are 16-bit on the target; clamp stray input
+            v = std::min<int64_t>(std::max<int64_t>(v, 0), UINT16_MAX);
+        }
+
+        uint8_t* dst = &columns_[c][(size_t)block_rows_ * kColumns[c].width];
+        if (kColumns[c].width == 8) {
+            memcpy(dst, &v, 8);
+        } else {
+            uint16_t v16 = (uint16_t)v;
+            memcpy(dst, &v16, 2);
+        }
+
+        MinMax& mm = block_summary_[c];
+        mm.min = std::min(mm.min, v);
+        mm.max = std::max(mm.max, v);
+    }
+
+    block_rows_++;
+    row_count_++;
+    if (block_rows_ == rows_per_block_) {
+        flush_block();
+    }
+}
+
+void CaptureWriter::flush_block() {
+    if (block_rows_ == 0) {
+        return;
+    }
+
+    BlockIndex entry;
+    memset(&entry, 0, sizeof(entry));
+    memcpy(&entry.t_first, &columns_[kColTime][0], 8);
+    memcpy(&entry.t_last, &columns_[kColTime][(size_t)(block_rows_ - 1) * 8], 8);
+    entry.rows = block_rows_;
+    entry.offset = (uint64_t)ftell(file_);
+
+    // Full-size columns keep every block the same length
+    size_t written = 0;
+    for (uint16_t c = 0; c < kColIdCount; c++) {
+        size_t used = (size_t)block_rows_ * kColumns[c].width;
+        memset(&columns_[c][used], 0, columns_[c].size() - used);
+        fwrite(columns_[c].data(), 1, columns_[c].size(), file_);
+        written += columns_[c].size();
+    }
+
+    // Keep the next block and the index 8-byte aligned for any rows_per_block
+    static const uint8_t zeros[8] = {0};
+    fwrite(zeros, 1, align_up(written, 8) - written, file_);
+
+    index_.push_back(entry);
+    summaries_.insert(summaries_.end(), block_summary_.begin(), block_summary_.end());
+    block_summary_.assign(kColIdCount, MinMax{INT64_MAX, INT64_MIN});
+    block_rows_ = 0;
+}
+
+int CaptureWriter::close() {
+    if (!file_) {
+        return -1;
+    }
+    flush_block();
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.column_count = kColIdCount;
+    header.rows_per_block = rows_per_block_;
+    header.row_count = row_count_;
+    header.block_count = index_.size();
+    header.data_offset = data_offset_;
+    header.index_offset = (uint64_t)ftell(file_);
+
+    for (size_t b = 0; b < index_.size(); b++) {
+        fwrite(&index_[b], sizeof(BlockIndex), 1, file_);
+        fwrite(&summaries_[b * kColIdCount], sizeof(MinMax), kColIdCount, file_);
+    }
+
+    if (!phase_names_.empty()) {
+        header.strings_offset = (uint64_t)ftell(file_);
+        uint32_t count = (uint32_t)phase_names_.size();
+        fwrite(&count, sizeof(count), 1, file_);
+        for (const std::string& name : phase_names_) {
+            uint16_t len = (uint16_t)std::min<size_t>(name.size(), UINT16_MAX);
+            fwrite(&len, sizeof(len), 1, file_);
+            fwrite(name.data(), 1, len, file_);
+        }
+    }
+
+    fseek(file_, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file_);
+
+    int rc = ferror(file_) ? -1 : 0;
+    if (fclose(file_) != 0) {
+        rc = -1;
+    }
+    file_ = nullptr;
+    if (rc != 0) {
+        error_ = "write error";
+    }
+    return rc;
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+
+CaptureReader::CaptureReader()
+    : base_(nullptr), size_(0), header_(nullptr), columns_(nullptr),
+      index_(nullptr), index_stride_(0), time_index_(-1) {}
+
+CaptureReader::~CaptureReader() {
+    close();
+}
+
+void CaptureReader::close() {
+    if (base_) {
+        munmap((void*)base_, size_);
+    }
+    base_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    columns_ = nullptr;
+    index_ = nullptr;
+    time_index_ = -1;
+    column_offset_.clear();
+    phase_names_.clear();
+}
+
+int CaptureReader::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = "cannot open " + path;
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FileHeader)) {
+        ::close(fd);
+        error_ = path + ": not a capture file";
+        return -1;
+    }
+
+    void* map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        error_ = "cannot map " + path;
+        return -1;
+    }
+    base_ = (const uint8_t*)map;
+    size_ = (size_t)st.st_size;
+    header_ = (const FileHeader*)base_;
+
+    if (memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0 ||
+        header_->version != kFormatVersion) {
+        error_ = path + ": bad magic or unsupported version";
+        close();
+        return -1;
+    }
+
+    // Every offset and count below comes from the file; check each extent
+    // against the mapping before anything dereferences it
+    if (header_->column_count == 0 ||
+        header_->column_count > (size_ - sizeof(FileHeader)) / sizeof(ColumnDesc)) {
+        error_ = path + ": column table out of range";
+        close();
+        return -1;
+    }
+    columns_ = (const ColumnDesc*)(base_ + sizeof(FileHeader));
+    index_stride_ = sizeof(BlockIndex) + header_->column_count * sizeof(MinMax);
+
+    bool have_time = false;
+    size_t offset = 0;
+    for (uint32_t c = 0; c < header_->column_count; c++) {
+        uint16_t width = columns_[c].width;
+        if ((width != 2 && width != 8) ||
+            header_->rows_per_block > (size_ - offset) / width) {
+            error_ = path + ": bad column width or block size";
+            close();
+            return -1;
+        }
+        if (columns_[c].id == kColTime) {
+            have_time = (width == 8);
+            time_index_ = (int)c;
+        }
+        column_offset_.push_back(offset);
+        offset += (size_t)header_->rows_per_block * width;
+    }
+    if (!have_time) {
+        error_ = path + ": no 64-bit time column";
+        close();
+        return -1;
+    }
+    const size_t block_bytes = offset;
+
+    if (!extent_ok(header_->index_offset, 0, size_) ||
+        header_->block_count > (size_ - header_->index_offset) / index_stride_) {
+        error_ = path + ": truncated capture (writer not closed?)";
+        close();
+        return -1;
+    }
+    index_ = base_ + header_->index_offset;
+
+    for (uint64_t b = 0; b < header_->block_count; b++) {
+        const BlockIndex& blk = block(b);
+        if (blk.rows == 0 || blk.rows > header_->rows_per_block ||
+            !extent_ok(blk.offset, block_bytes, size_)) {
+            error_ = path + ": block " + std::to_string(b) + " out of range";
+            close();
+            return -1;
+        }
+    }
+
+    if (header_->strings_offset && extent_ok(header_->strings_offset, 4, size_)) {
+        const uint8_t* p = base_ + header_->strings_offset;
+        const uint8_t* end = base_ + size_;
+        uint32_t count;
+        memcpy(&count, p, 4);
+        p += 4;
+        for (uint32_t i = 0; i < count && p + 2 <= end; i++) {
+            uint16_t len;
+            memcpy(&len, p, 2);
+            p += 2;
+            if (p + len > end) {
+                break;
+            }
+            phase_names_.emplace_back((const char*)p, len);
+            p += len;
+        }
+    }
+
+    // Hint the kernel that the index will be binary-searched
+    madvise((void*)base_, size_, MADV_RANDOM);
+    return 0;
+}
+
+int CaptureReader::column_index(uint16_t id) const {
+    for (uint32_t c = 0; c < column_count(); c++) {
+        if (columns_[c].id == id) {
+            return (int)c;
+        }
+    }
+    return -1;
+}
+
+const BlockIndex& CaptureReader::block(uint64_t b) const {
+    return *(const BlockIndex*)(index_ + b * index_stride_);
+}
+
+const MinMax& CaptureReader::block_summary(uint64_t b, int col_index) const {
+    const MinMax* mm = (const MinMax*)(index_ + b * index_stride_ + sizeof(BlockIndex));
+    return mm[col_index];
+}
+
+int64_t CaptureReader::time(uint64_t b, uint32_t row) const {
+    return load_value(base_ + block(b).offset + column_offset_[time_index_] + (size_t)row * 8, 8);
+}
+
+uint32_t CaptureReader::first_row_at(uint64_t b, int64_t t) const {
+    uint32_t lo = 0;
+    uint32_t hi = block(b).rows;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (time(b, mid) < t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int64_t CaptureReader::value(uint64_t b, int col_index, uint32_t row) const {
+    uint16_t width = columns_[col_index].width;
+    const uint8_t* p = base_ + block(b).offset + column_offset_[col_index] + (size_t)row * width;
+    return load_value(p, width);
+}
+
+uint64_t CaptureReader::first_block_at(int64_t t) const {
+    uint64_t lo = 0;
+    uint64_t hi = block_count();
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (block(mid).t_last < t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+uint64_t CaptureReader::range_minmax(int col_index, int64_t t1, int64_t t2, MinMax* out) const {
+    MinMax acc = {INT64_MAX, INT64_MIN};
+    uint64_t count = 0;
+
+    for (uint64_t b = first_block_at(t1); b < block_count(); b++) {
+        const BlockIndex& blk = block(b);
+        if (blk.t_first > t2) {
+            break;
+        }
+
+        if (blk.t_first >= t1 && blk.t_last <= t2) {
+            // Whole block inside the range: summary answers it
+            const MinMax& mm = block_summary(b, col_index);
+            acc.min = std::min(acc.min, mm.min);
+            acc.max = std::max(acc.max, mm.max);
+            count += blk.rows;
+            continue;
+        }
+
+        uint32_t row = first_row_at(b, t1);
+        for (; row < blk.rows && time(b, row) <= t2; row++) {
+            int64_t v = value(b, col_index, row);
+            acc.min = std::min(acc.min, v);
+            acc.max = std::max(acc.max, v);
+            count++;
+        }
+    }
+
+    if (count) {
+        *out = acc;
+    }
+    return count;
+}
+
+} // namespace memcap
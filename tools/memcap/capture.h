@@ -0,0 +1,284 @@
+/**
+ * @file capture.h
+ * @brief Columnar, memory-mapped capture format for memory telemetry
+ *
+ * Long UART soak logs are converted once into a binary capture that can be
+ * queried without re-parsing text. The file is laid out so that the reader
+ * can mmap() it and touch only the blocks a query actually needs.
+ *
+ * FILE LAYOUT (little-endian):
+ *
+ *  +---------------------------+  offset 0
+ *  | FileHeader (64 bytes)     |
+ *  +---------------------------+
+ *  | ColumnDesc[column_count]  |  <- self-describing schema
+ *  +---------------------------+  aligned to 64
+ *  | Block 0                   |  <- one fixed-width array per column:
+ *  |   col0[rows_per_block]    |     time (int64 us), then uint16 fields
+ *  |   col1[rows_per_block]    |
+ *  |   ...                     |
+ *  +---------------------------+
+ *  | Block 1 ...               |
+ *  +---------------------------+  index_offset
+ *  | BlockIndex[block_count]   |  <- sparse time index + per-column min/max
+ *  +---------------------------+  strings_offset
+ *  | Phase name table          |  <- u32 count, then (u16 length, bytes)
+ *  +---------------------------+
+ *
+ * Every block reserves rows_per_block slots per column (the last block may
+ * be partially filled), so a block is a constant-size unit and column data
+ * is found by arithmetic rather than by scanning. Blocks are padded to a
+ * multiple of 8 bytes; the reader still copies values out of the map
+ * rather than casting, so captures with unaligned blocks read the same.
+ *
+ * Rows are stored in non-decreasing time order. Queries binary-search the
+ * block index on time and skip blocks whose min/max summary cannot affect
+ * the answer.
+ */
+
+#ifndef MEMCAP_CAPTURE_H
+#define MEMCAP_CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace memcap {
+
+// ============================================================================
+// SCHEMA
+// ============================================================================
+
+/**
+ * @brief Stable column identifiers (stored in the file; never renumber)
+ */
+enum ColumnId : uint16_t {
+    kColTime = 0,          // Sample timestamp in microseconds (int64)
+    kColHeapUsed,          // Heap Used
+    kColAllocCount,        // malloc() calls
+    kColFreeCount,         // free() calls
+    kColStackCurrent,      // Stack Current
+    kColStackPeak,         // Stack Peak (sentinel high-water)
+    kColFreeRam,           // Free RAM between heap and stack
+    kColFragmentation,     // Fragmentation in permille (0 - 1000)
+    kColCollision,         // 1 if collision warning was active
+    kColStaticData,        // .data size
+    kColStaticBss,         // .bss size
+    kColPhase,             // Index into the phase name table ([PHASE] markers)
+    kColIdCount
+};
+
+/**
+ * @brief Name and storage width of a column
+ */
+struct ColumnInfo {
+    ColumnId id;
+    uint16_t width;        // Bytes per value (8 for time, 2 otherwise)
+    const char* name;
+};
+
+/**
+ * @brief Look up schema information for a column id
+ * @return Pointer to static info, or nullptr for unknown ids
+ */
+const ColumnInfo* column_info(uint16_t id);
+
+/**
+ * @brief Look up a column id by name (e.g. "free_ram")
+ * @return 1 if found, 0 otherwise
+ */
+int column_by_name(const std::string& name, ColumnId* id);
+
+// ============================================================================
+// ON-DISK STRUCTURES
+// ============================================================================
+
+static const char kMagic[8] = {'M', 'E', 'M', 'C', 'A', 'P', 0x1A, 0x00};
+static const uint32_t kFormatVersion = 1;
+static const uint32_t kDefaultRowsPerBlock = 4096;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+    uint32_t rows_per_block;
+    uint32_t reserved0;
+    uint64_t row_count;
+    uint64_t block_count;
+    uint64_t data_offset;      // First block
+    uint64_t index_offset;     // BlockIndex array (written on close)
+    uint64_t strings_offset;   // Phase name table (0 if absent)
+};
+static_assert(sizeof(FileHeader) == 64, "FileHeader must be 64 bytes");
+
+struct ColumnDesc {
+    uint16_t id;
+    uint16_t width;
+    char name[28];
+};
+static_assert(sizeof(ColumnDesc) == 32, "ColumnDesc must be 32 bytes");
+
+/**
+ * @brief Per-block index entry
+ *
+ * Followed in the file by column_count pairs of int64 (min, max), one per
+ * column in schema order.
+ */
+struct BlockIndex {
+    int64_t t_first;
+    int64_t t_last;
+    uint32_t rows;
+    uint32_t reserved;
+    uint64_t offset;
+};
+static_assert(sizeof(BlockIndex) == 32, "BlockIndex must be 32 bytes");
+
+struct MinMax {
+    int64_t min;
+    int64_t max;
+};
+
+/**
+ * @brief One decoded telemetry sample (values indexed by ColumnId)
+ */
+struct Sample {
+    int64_t value[kColIdCount];
+    uint32_t present;      // Bit mask of columns that were parsed
+};
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+/**
+ * @brief Streaming capture writer
+ *
+ * Buffers one block in memory, writes it when full and appends the block
+ * index on close(). Samples older than the previous one are clamped to the
+ * previous timestamp so the time index stays monotonic.
+ */
+class CaptureWriter {
+public:
+    CaptureWriter();
+    ~CaptureWriter();
+
+    int open(const std::string& path, uint32_t rows_per_block = kDefaultRowsPerBlock);
+    void append(const Sample& sample);
+
+    /**
+     * @brief Set the names referenced by the phase column (index 0 first)
+     */
+    void set_phase_names(const std::vector<std::string>& names) { phase_names_ = names; }
+
+    int close();
+
+    uint64_t rows_written() const { return row_count_; }
+    const std::string& error() const { return error_; }
+
+private:
+    void flush_block();
+
+    FILE* file_;
+    uint32_t rows_per_block_;
+    uint32_t block_rows_;
+    uint64_t row_count_;
+    uint64_t data_offset_;
+    int64_t last_time_;
+    std::vector<std::vector<uint8_t>> columns_;
+    std::vector<BlockIndex> index_;
+    std::vector<MinMax> summaries_;
+    std::vector<MinMax> block_summary_;
+    std::vector<std::string> phase_names_;
+    std::string error_;
+};
+
+// ============================================================================
+// READER
+// ============================================================================
+
+/**
+ * @brief Read-only, memory-mapped view of a capture file
+ */
+class CaptureReader {
+public:
+    CaptureReader();
+    ~CaptureReader();
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    /**
+     * @brief Map a capture and validate its layout
+     * @return 0, or -1 with error() set if any table or block lies outside
+     *         the file (truncated or corrupt capture)
+     */
+    int open(const std::string& path);
+    void close();
+
+    uint64_t row_count() const { return header_ ? header_->row_count : 0; }
+    uint64_t block_count() const { return header_ ? header_->block_count : 0; }
+    uint32_t column_count() const { return header_ ? header_->column_count : 0; }
+    const ColumnDesc& column(uint32_t i) const { return columns_[i]; }
+
+    /**
+     * @brief Schema position of a column id
+     * @return Index into the column table, or -1 if the capture lacks it
+     */
+    int column_index(uint16_t id) const;
+
+    const BlockIndex& block(uint64_t b) const;
+    const MinMax& block_summary(uint64_t b, int col_index) const;
+
+    /**
+     * @brief Timestamp of one row (the column may be unaligned in the map)
+     */
+    int64_t time(uint64_t b, uint32_t row) const;
+
+    /**
+     * @brief First row of block b with a timestamp >= t (rows if none)
+     */
+    uint32_t first_row_at(uint64_t b, int64_t t) const;
+
+    /**
+     * @brief Read one value of a column (any width) as int64
+     */
+    int64_t value(uint64_t b, int col_index, uint32_t row) const;
+
+    /**
+     * @brief First block whose t_last >= t (block_count() if none)
+     */
+    uint64_t first_block_at(int64_t t) const;
+
+    /**
+     * @brief Min/max of a column over samples with t1 <= time <= t2
+     * @return Number of samples in range (0 leaves *out untouched)
+     *
+     * Blocks entirely inside the range are answered from their summary;
+     * only the (at most two) boundary blocks are scanned row by row.
+     */
+    uint64_t range_minmax(int col_index, int64_t t1, int64_t t2, MinMax* out) const;
+
+    /**
+     * @brief Names for the values of the phase column
+     */
+    const std::vector<std::string>& phase_names() const { return phase_names_; }
+
+    const std::string& error() const { return error_; }
+
+private:
+    const uint8_t* base_;
+    size_t size_;
+    const FileHeader* header_;
+    const ColumnDesc* columns_;
+    const uint8_t* index_;
+    size_t index_stride_;
+    int time_index_;                      // Column holding the timestamps
+    std::vector<size_t> column_offset_;   // Byte offset of each column inside a block
+    std::vector<std::string> phase_names_;
+    std::string error_;
+};
+
+} // namespace memcap
+
+#endif // MEMCAP_CAPTURE_H
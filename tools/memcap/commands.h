@@ -0,0 +1,28 @@
+/**
+ * @file commands.h
+ * @brief memcap subcommand entry points
+ */
+
+#ifndef MEMCAP_COMMANDS_H
+#define MEMCAP_COMMANDS_H
+
+#include <cstdint>
+#include <string>
+
+namespace memcap {
+
+int cmd_ingest(int argc, char** argv);
+int cmd_info(int argc, char** argv);
+int cmd_range(int argc, char** argv);
+int cmd_query(int argc, char** argv);
+int cmd_diff(int argc, char** argv);
+
+/**
+ * @brief Parse a duration/time such as "1.5", "250ms", "2m", "1h"
+ * @return 1 on success (seconds are the default unit)
+ */
+int parse_time_us(const std::string& text, int64_t* us);
+
+} // namespace memcap
+
+#endif // MEMCAP_COMMANDS_H
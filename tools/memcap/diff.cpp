@@ -0,0 +1,312 @@
+/**
+ * @file diff.cpp
+ * @brief A/B comparison of memory telemetry between two firmware builds
+ *
+ * Usage:
+ *   memcap diff [--alpha 0.05] [--min-delta 1] -a base... -b candidate...
+ *
+ * Inputs are capture files or raw UART logs (hardware or simavr runs of the
+ * same workload). Samples are grouped by the "[PHASE]" marker active when
+ * they were printed, so both sides are compared phase by phase even when
+ * the runs differ in length or timing.
+ *
+ * For every phase and metric the report shows median and worst-case values,
+ * Cliff's delta (effect size, -1..1, positive = B larger) and a two-sided
+ * Mann-Whitney U p-value. A metric is flagged as a regression when it moves
+ * in its "worse" direction by at least --min-delta and the difference is
+ * significant at --alpha. The exit status is 1 if any regression is found.
+ */
+
+#include "capture.h"
+#include "commands.h"
+#include "log_parser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace memcap {
+
+// ============================================================================
+// METRICS
+// ============================================================================
+
+struct Metric {
+    ColumnId column;
+    int higher_is_worse;
+    const char* label;
+};
+
+static const Metric kMetrics[] = {
+    {kColStackPeak,     1, "peak stack"},
+    {kColFreeRam,       0, "min gap (free RAM)"},
+    {kColFragmentation, 1, "fragmentation (permille)"},
+    {kColHeapUsed,      1, "heap used"},
+};
+static const size_t kMetricCount = sizeof(kMetrics) / sizeof(kMetrics[0]);
+
+// phase name -> metric -> values
+typedef std::map<std::string, std::vector<std::vector<double>>> PhaseSamples;
+
+static void add_sample(PhaseSamples* out, const std::string& phase, const Sample& s) {
+    std::vector<std::vector<double>>& m = (*out)[phase];
+    m.resize(kMetricCount);
+    for (size_t i = 0; i < kMetricCount; i++) {
+        if (s.present & (1u << kMetrics[i].column)) {
+            m[i].push_back((double)s.value[kMetrics[i].column]);
+        }
+    }
+}
+
+static int is_capture(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return 0;
+    }
+    char magic[sizeof(kMagic)];
+    size_t n = fread(magic, 1, sizeof(magic), f);
+    fclose(f);
+    return n == sizeof(magic) && memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+static int load_input(const std::string& path, PhaseSamples* out) {
+    if (is_capture(path)) {
+        CaptureReader r;
+        if (r.open(path) != 0) {
+            fprintf(stderr, "memcap diff: %s\n", r.error().c_str());
+            return -1;
+        }
+        int phase_col = r.column_index(kColPhase);
+        std::vector<int> cols(kColIdCount, -1);
+        for (size_t i = 0; i < kMetricCount; i++) {
+            cols[kMetrics[i].column] = r.column_index(kMetrics[i].column);
+        }
+
+        for (uint64_t b = 0; b < r.block_count(); b++) {
+            for (uint32_t row = 0; row < r.block(b).rows; row++) {
+                Sample s;
+                memset(&s, 0, sizeof(s));
+                for (size_t i = 0; i < kMetricCount; i++) {
+                    int c = cols[kMetrics[i].column];
+                    if (c >= 0) {
+                        s.value[kMetrics[i].column] = r.value(b, c, row);
+                        s.present |= 1u << kMetrics[i].column;
+                    }
+                }
+                std::string phase = "-";
+                if (phase_col >= 0) {
+                    size_t p = (size_t)r.value(b, phase_col, row);
+                    if (p < r.phase_names().size()) {
+                        phase = r.phase_names()[p];
+                    }
+                }
+                add_sample(out, phase, s);
+            }
+        }
+        return 0;
+    }
+
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "memcap diff: cannot open %s\n", path.c_str());
+        return -1;
+    }
+    LogParser parser(0);
+    std::string line;
+    Sample s;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (parser.feed(line, &s)) {
+            add_sample(out, parser.phase_names()[(size_t)s.value[kColPhase]], s);
+        }
+    }
+    return 0;
+}
+
+// ============================================================================
+// STATISTICS
+// ============================================================================
+
+static double quantile(std::vector<double> v, double q) {
+    std::sort(v.begin(), v.end());
+    size_t rank = (size_t)std::ceil(q * (double)v.size());
+    return v[rank ? rank - 1 : 0];
+}
+
+struct Comparison {
+    double cliff;          // P(B > A) - P(B < A)
+    double p_value;        // Two-sided Mann-Whitney U (normal approximation)
+};
+
+static Comparison mann_whitney(const std::vector<double>& a, const std::vector<double>& b) {
+    struct Item {
+        double v;
+        int group;
+    };
+    std::vector<Item> all;
+    for (double v : a) {
+        all.push_back(Item{v, 0});
+    }
+    for (double v : b) {
+        all.push_back(Item{v, 1});
+    }
+    std::sort(all.begin(), all.end(), [](const Item& x, const Item& y) { return x.v < y.v; });
+
+    // Average ranks over ties; accumulate the tie correction term
+    double rank_b = 0.0;
+    double tie_term = 0.0;
+    size_t n = all.size();
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && all[j].v == all[i].v) {
+            j++;
+        }
+        double avg = (double)(i + j + 1) / 2.0;
+        double t = (double)(j - i);
+        tie_term += t * t * t - t;
+        for (size_t k = i; k < j; k++) {
+            if (all[k].group == 1) {
+                rank_b += avg;
+            }
+        }
+        i = j;
+    }
+
+    double na = (double)a.size();
+    double nb = (double)b.size();
+    double u_b = rank_b - nb * (nb + 1.0) / 2.0;
+    double mean = na * nb / 2.0;
+    double var = na * nb / 12.0 * ((double)n + 1.0 - tie_term / ((double)n * ((double)n - 1.0)));
+
+    Comparison c;
+    c.cliff = 2.0 * u_b / (na * nb) - 1.0;
+    if (var <= 0.0) {
+        c.p_value = 1.0;
+    } else {
+        double diff = std::fabs(u_b - mean) - 0.5; // Continuity correction
+        double z = std::max(diff, 0.0) / std::sqrt(var);
+        c.p_value = std::erfc(z / std::sqrt(2.0));
+    }
+    return c;
+}
+
+// ============================================================================
+// COMMAND
+// ============================================================================
+
+int cmd_diff(int argc, char** argv) {
+    double alpha = 0.05;
+    double min_delta = 1.0;
+    std::vector<std::string> inputs[2];
+    int side = -1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-a") {
+            side = 0;
+        } else if (arg == "-b") {
+            side = 1;
+        } else if (arg == "--alpha" && i + 1 < argc) {
+            alpha = strtod(argv[++i], nullptr);
+        } else if (arg == "--min-delta" && i + 1 < argc) {
+            min_delta = strtod(argv[++i], nullptr);
+        } else if (side >= 0) {
+            inputs[side].push_back(arg);
+        } else {
+            side = -2;
+            break;
+        }
+    }
+    if (side == -2 || inputs[0].empty() || inputs[1].empty()) {
+        fprintf(stderr, "usage: memcap diff [--alpha p] [--min-delta n] -a <base>... -b <candidate>...\n");
+        return 2;
+    }
+
+    PhaseSamples samples[2];
+    for (int s = 0; s < 2; s++) {
+        for (const std::string& path : inputs[s]) {
+            if (load_input(path, &samples[s]) != 0) {
+                return 1;
+            }
+        }
+    }
+
+    printf("A/B memory telemetry comparison (alpha %.3g, min delta %.3g)\n", alpha, min_delta);
+    printf("A: %zu input(s)  B: %zu input(s)\n\n", inputs[0].size(), inputs[1].size());
+    printf("%-20s %-26s %5s %5s %9s %9s %9s %9s %7s %8s  %s\n",
+           "phase", "metric", "nA", "nB", "A med", "B med", "A worst", "B worst",
+           "cliff", "p", "verdict");
+
+    int regressions = 0;
+    int improvements = 0;
+    for (const auto& kv : samples[0]) {
+        auto other = samples[1].find(kv.first);
+        if (other == samples[1].end()) {
+            printf("%-20s (missing in B)\n", kv.first.c_str());
+            continue;
+        }
+
+        for (size_t m = 0; m < kMetricCount; m++) {
+            const std::vector<double>& a = kv.second[m];
+            const std::vector<double>& b = other->second[m];
+            if (a.empty() || b.empty()) {
+                continue;
+            }
+
+            const Metric& metric = kMetrics[m];
+            double med_a = quantile(a, 0.5);
+            double med_b = quantile(b, 0.5);
+            double worst_a = metric.higher_is_worse ? *std::max_element(a.begin(), a.end())
+                                                    : *std::min_element(a.begin(), a.end());
+            double worst_b = metric.higher_is_worse ? *std::max_element(b.begin(), b.end())
+                                                    : *std::min_element(b.begin(), b.end());
+            Comparison c = mann_whitney(a, b);
+
+            // Positive = B moved in the "worse" direction
+            double sign = metric.higher_is_worse ? 1.0 : -1.0;
+            double worse_med = sign * (med_b - med_a);
+            double worse_peak = sign * (worst_b - worst_a);
+            bool small = a.size() < 3 || b.size() < 3;
+
+            const char* verdict = "ok";
+            if (small) {
+                // Too few samples for a test; report worst-case movement only
+                if (worse_peak >= min_delta) {
+                    verdict = "worse (n<3)";
+                } else if (-worse_peak >= min_delta) {
+                    verdict = "better (n<3)";
+                }
+            } else if (c.p_value < alpha && std::max(worse_med, worse_peak) >= min_delta &&
+                       sign * c.cliff > 0.0) {
+                verdict = "REGRESSION";
+                regressions++;
+            } else if (c.p_value < alpha && std::min(worse_med, worse_peak) <= -min_delta &&
+                       sign * c.cliff < 0.0) {
+                verdict = "improved";
+                improvements++;
+            }
+
+            printf("%-20s %-26s %5zu %5zu %9.1f %9.1f %9.1f %9.1f %+7.3f %8.2g  %s\n",
+                   kv.first.c_str(), metric.label, a.size(), b.size(),
+                   med_a, med_b, worst_a, worst_b, c.cliff, c.p_value, verdict);
+        }
+    }
+    for (const auto& kv : samples[1]) {
+        if (samples[0].find(kv.first) == samples[0].end()) {
+            printf("%-20s (missing in A)\n", kv.first.c_str());
+        }
+    }
+
+    printf("\n%d regression(s), %d improvement(s)\n", regressions, improvements);
+    return regressions ? 1 : 0;
+}
+
+} // namespace memcap
@@ -0,0 +1,154 @@
+/**
+ * @file log_parser.cpp
+ * @brief UART diagnostic text to Sample conversion
+ */
+
+#include "log_parser.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace memcap {
+
+const char* strip_timestamp(const char* line, int64_t* stamp_us) {
+    *stamp_us = -1;
+    if (line[0] != '[') {
+        return line;
+    }
+
+    char* end = nullptr;
+    double seconds = strtod(line + 1, &end);
+    if (end == line + 1) {
+        return line; // "[MEM DIAGNOSTICS]" and friends
+    }
+
+    // Some loggers emit "[abs delta]"; only the first number matters
+    const char* close = strchr(end, ']');
+    if (!close) {
+        return line;
+    }
+    *stamp_us = (int64_t)(seconds * 1e6 + 0.5);
+
+    const char* rest = close + 1;
+    while (*rest == ' ' || *rest == '\t') {
+        rest++;
+    }
+    return rest;
+}
+
+// Parse the integer following a "Label:" prefix; returns 1 on match
+static int field(const char* text, const char* label, int64_t* out, const char** after = nullptr) {
+    size_t n = strlen(label);
+    if (strncmp(text, label, n) != 0) {
+        return 0;
+    }
+    char* end = nullptr;
+    *out = strtoll(text + n, &end, 10);
+    if (after) {
+        *after = end;
+    }
+    return 1;
+}
+
+LogParser::LogParser(int64_t interval_us)
+    : interval_us_(interval_us), synthetic_time_(0), last_stamp_(0),
+      have_stamp_(false), in_block_(false), lines_(0), phase_(0) {
+    memset(&current_, 0, sizeof(current_));
+    phases_.push_back("-");
+}
+
+int LogParser::feed(const std::string& raw, Sample* sample) {
+    lines_++;
+
+    int64_t stamp = -1;
+    const char* text = strip_timestamp(raw.c_str(), &stamp);
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    if (stamp >= 0) {
+        last_stamp_ = stamp;
+        have_stamp_ = true;
+    }
+
+    if (strncmp(text, "[PHASE]", 7) == 0) {
+        std::string name(text + 7);
+        size_t first = name.find_first_not_of(" \t");
+        name = first == std::string::npos ? std::string() : name.substr(first);
+
+        size_t i = 0;
+        while (i < phases_.size() && phases_[i] != name) {
+            i++;
+        }
+        if (i == phases_.size()) {
+            phases_.push_back(name);
+        }
+        phase_ = (uint16_t)i;
+        return 0;
+    }
+
+    if (strncmp(text, "[MEM DIAGNOSTICS]", 17) == 0) {
+        memset(&current_, 0, sizeof(current_));
+        in_block_ = true;
+        if (have_stamp_) {
+            current_.value[kColTime] = last_stamp_;
+        } else {
+            current_.value[kColTime] = synthetic_time_;
+            synthetic_time_ += interval_us_;
+        }
+        current_.value[kColPhase] = phase_;
+        current_.present = (1u << kColTime) | (1u << kColPhase);
+        return 0;
+    }
+    if (!in_block_) {
+        return 0;
+    }
+
+    int64_t v = 0;
+    const char* after = nullptr;
+    if (field(text, "Static (.data):", &v)) {
+        current_.value[kColStaticData] = v;
+        current_.present |= 1u << kColStaticData;
+    } else if (field(text, "Static (.bss):", &v)) {
+        current_.value[kColStaticBss] = v;
+        current_.present |= 1u << kColStaticBss;
+    } else if (field(text, "Heap Used:", &v, &after)) {
+        current_.value[kColHeapUsed] = v;
+        current_.present |= 1u << kColHeapUsed;
+
+        // " bytes (A allocs, F frees)"
+        const char* paren = strchr(after, '(');
+        if (paren) {
+            char* end = nullptr;
+            current_.value[kColAllocCount] = strtoll(paren + 1, &end, 10);
+            const char* comma = strchr(end, ',');
+            if (comma) {
+                current_.value[kColFreeCount] = strtoll(comma + 1, nullptr, 10);
+            }
+            current_.present |= (1u << kColAllocCount) | (1u << kColFreeCount);
+        }
+    } else if (field(text, "Stack Current:", &v)) {
+        current_.value[kColStackCurrent] = v;
+        current_.present |= 1u << kColStackCurrent;
+    } else if (field(text, "Stack Peak:", &v)) {
+        current_.value[kColStackPeak] = v;
+        current_.present |= 1u << kColStackPeak;
+    } else if (field(text, "Free RAM:", &v)) {
+        current_.value[kColFreeRam] = v;
+        current_.present |= 1u << kColFreeRam;
+    } else if (strncmp(text, "Fragmentation:", 14) == 0) {
+        double pct = strtod(text + 14, nullptr);
+        current_.value[kColFragmentation] = (int64_t)(pct * 10.0 + 0.5);
+        current_.present |= 1u << kColFragmentation;
+    } else if (strncmp(text, "Collision:", 10) == 0) {
+        current_.value[kColCollision] = strstr(text, "WARNING") ? 1 : 0;
+        current_.present |= 1u << kColCollision;
+
+        // Collision is the last line of the block
+        in_block_ = false;
+        *sample = current_;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace memcap
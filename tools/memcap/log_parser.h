@@ -0,0 +1,72 @@
+/**
+ * @file log_parser.h
+ * @brief Incremental parser for the firmware's UART diagnostic text
+ *
+ * Recognises the block printed by mem_monitor_print_diagnostics():
+ *
+ *   [MEM DIAGNOSTICS]
+ *   SRAM Total:    2048 bytes
+ *   Static (.data): 12 bytes
+ *   ...
+ *   Collision:     OK
+ *
+ * Lines may carry a host-side timestamp prefix in seconds, as written by
+ * common serial loggers: "[12.345678] Heap Used: ...". When no prefix is
+ * present, samples are spaced by a fixed nominal interval.
+ *
+ * "[PHASE] <name>" markers switch the phase recorded with every following
+ * sample. Phase 0 ("-") covers samples printed before the first marker.
+ */
+
+#ifndef MEMCAP_LOG_PARSER_H
+#define MEMCAP_LOG_PARSER_H
+
+#include "capture.h"
+
+#include <string>
+#include <vector>
+
+namespace memcap {
+
+class LogParser {
+public:
+    /**
+     * @param interval_us Spacing assigned to samples without timestamps
+     */
+    explicit LogParser(int64_t interval_us);
+
+    /**
+     * @brief Feed one line of UART text
+     * @param sample Filled in when the line completes a diagnostics block
+     * @return 1 if a complete sample is available, 0 otherwise
+     */
+    int feed(const std::string& line, Sample* sample);
+
+    uint64_t lines() const { return lines_; }
+
+    /**
+     * @brief Phase names in order of first appearance (index = phase value)
+     */
+    const std::vector<std::string>& phase_names() const { return phases_; }
+
+private:
+    int64_t interval_us_;
+    int64_t synthetic_time_;
+    int64_t last_stamp_;
+    bool have_stamp_;
+    bool in_block_;
+    Sample current_;
+    uint64_t lines_;
+    uint16_t phase_;
+    std::vector<std::string> phases_;
+};
+
+/**
+ * @brief Strip an optional "[seconds]" prefix
+ * @return Pointer to the remaining text; *stamp_us set to -1 if absent
+ */
+const char* strip_timestamp(const char* line, int64_t* stamp_us);
+
+} // namespace memcap
+
+#endif // MEMCAP_LOG_PARSER_H
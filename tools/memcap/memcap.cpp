@@ -0,0 +1,279 @@
+/**
+ * @file memcap.cpp
+ * @brief Host CLI for converting and querying memory telemetry captures
+ *
+ * Usage:
+ *   memcap ingest [-i interval] [-b rows] -o out.mcap [log.txt|-]
+ *   memcap info capture.mcap
+ *   memcap range -c free_ram [--from t1] [--to t2] capture.mcap...
+ *   memcap query -w 1m -a min:free_ram -a p99:stack_peak capture.mcap...
+ *   memcap diff -a base.mcap... -b candidate.mcap...
+ */
+
+#include "capture.h"
+#include "commands.h"
+#include "log_parser.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+
+namespace memcap {
+
+int parse_time_us(const std::string& text, int64_t* us) {
+    char* end = nullptr;
+    double v = strtod(text.c_str(), &end);
+    if (end == text.c_str()) {
+        return 0;
+    }
+
+    std::string unit(end);
+    double scale = 1e6;
+    if (unit.empty() || unit == "s") {
+        scale = 1e6;
+    } else if (unit == "ms") {
+        scale = 1e3;
+    } else if (unit == "us") {
+        scale = 1.0;
+    } else if (unit == "m") {
+        scale = 60e6;
+    } else if (unit == "h") {
+        scale = 3600e6;
+    } else if (unit == "d") {
+        scale = 86400e6;
+    } else {
+        return 0;
+    }
+    *us = (int64_t)(v * scale + (v < 0 ? -0.5 : 0.5));
+    return 1;
+}
+
+// ============================================================================
+// INGEST
+// ============================================================================
+
+int cmd_ingest(int argc, char** argv) {
+    std::string out_path;
+    std::string in_path = "-";
+    int64_t interval_us = 2000000; // Firmware reports roughly every 2 s
+    uint32_t rows_per_block = kDefaultRowsPerBlock;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (arg == "-i" && i + 1 < argc) {
+            if (!parse_time_us(argv[++i], &interval_us)) {
+                fprintf(stderr, "memcap ingest: bad interval '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if (arg == "-b" && i + 1 < argc) {
+            rows_per_block = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else {
+            in_path = arg;
+        }
+    }
+    if (out_path.empty()) {
+        fprintf(stderr, "memcap ingest: -o <capture> is required\n");
+        return 2;
+    }
+
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (in_path != "-") {
+        file.open(in_path);
+        if (!file) {
+            fprintf(stderr, "memcap ingest: cannot open %s\n", in_path.c_str());
+            return 1;
+        }
+        in = &file;
+    }
+
+    CaptureWriter writer;
+    if (writer.open(out_path, rows_per_block) != 0) {
+        fprintf(stderr, "memcap ingest: %s\n", writer.error().c_str());
+        return 1;
+    }
+
+    LogParser parser(interval_us);
+    std::string line;
+    Sample sample;
+    while (std::getline(*in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (parser.feed(line, &sample)) {
+            writer.append(sample);
+        }
+    }
+
+    uint64_t rows = writer.rows_written();
+    writer.set_phase_names(parser.phase_names());
+    if (writer.close() != 0) {
+        fprintf(stderr, "memcap ingest: %s\n", writer.error().c_str());
+        return 1;
+    }
+    fprintf(stderr, "memcap ingest: %" PRIu64 " lines, %" PRIu64 " samples -> %s\n",
+            parser.lines(), rows, out_path.c_str());
+    return 0;
+}
+
+// ============================================================================
+// INFO
+// ============================================================================
+
+int cmd_info(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: memcap info <capture>\n");
+        return 2;
+    }
+
+    CaptureReader reader;
+    if (reader.open(argv[1]) != 0) {
+        fprintf(stderr, "memcap info: %s\n", reader.error().c_str());
+        return 1;
+    }
+
+    printf("rows:    %" PRIu64 "\n", reader.row_count());
+    printf("blocks:  %" PRIu64 "\n", reader.block_count());
+    if (reader.block_count()) {
+        printf("time:    %.6f .. %.6f s\n",
+               reader.block(0).t_first / 1e6,
+               reader.block(reader.block_count() - 1).t_last / 1e6);
+    }
+    printf("columns:\n");
+    for (uint32_t c = 0; c < reader.column_count(); c++) {
+        const ColumnDesc& d = reader.column(c);
+        int64_t lo = INT64_MAX;
+        int64_t hi = INT64_MIN;
+        for (uint64_t b = 0; b < reader.block_count(); b++) {
+            const MinMax& mm = reader.block_summary(b, (int)c);
+            lo = mm.min < lo ? mm.min : lo;
+            hi = mm.max > hi ? mm.max : hi;
+        }
+        if (reader.block_count()) {
+            printf("  %-24.*s %u bytes  [%" PRId64 " .. %" PRId64 "]\n", (int)sizeof(d.name), d.name, d.width, lo, hi);
+        } else {
+            printf("  %-24.*s %u bytes\n", (int)sizeof(d.name), d.name, d.width);
+        }
+    }
+    if (!reader.phase_names().empty()) {
+        printf("phases:\n");
+        for (size_t i = 0; i < reader.phase_names().size(); i++) {
+            printf("  %zu %s\n", i, reader.phase_names()[i].c_str());
+        }
+    }
+    return 0;
+}
+
+// ============================================================================
+// RANGE
+// ============================================================================
+
+int cmd_range(int argc, char** argv) {
+    std::string column = "free_ram";
+    int64_t t1 = INT64_MIN;
+    int64_t t2 = INT64_MAX;
+    int first_file = argc;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-c" && i + 1 < argc) {
+            column = argv[++i];
+        } else if (arg == "--from" && i + 1 < argc) {
+            if (!parse_time_us(argv[++i], &t1)) {
+                fprintf(stderr, "memcap range: bad time '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if (arg == "--to" && i + 1 < argc) {
+            if (!parse_time_us(argv[++i], &t2)) {
+                fprintf(stderr, "memcap range: bad time '%s'\n", argv[i]);
+                return 2;
+            }
+        } else {
+            first_file = i;
+            break;
+        }
+    }
+
+    ColumnId id;
+    if (!column_by_name(column, &id)) {
+        fprintf(stderr, "memcap range: unknown column '%s'\n", column.c_str());
+        return 2;
+    }
+    if (first_file >= argc) {
+        fprintf(stderr, "usage: memcap range -c <column> [--from t] [--to t] <capture>...\n");
+        return 2;
+    }
+
+    printf("file,column,samples,min,max\n");
+    for (int i = first_file; i < argc; i++) {
+        CaptureReader reader;
+        if (reader.open(argv[i]) != 0) {
+            fprintf(stderr, "memcap range: %s\n", reader.error().c_str());
+            return 1;
+        }
+        int col = reader.column_index(id);
+        if (col < 0) {
+            fprintf(stderr, "memcap range: %s has no column %s\n", argv[i], column.c_str());
+            return 1;
+        }
+
+        MinMax mm = {0, 0};
+        uint64_t n = reader.range_minmax(col, t1, t2, &mm);
+        if (n) {
+            printf("%s,%s,%" PRIu64 ",%" PRId64 ",%" PRId64 "\n", argv[i], column.c_str(), n, mm.min, mm.max);
+        } else {
+            printf("%s,%s,0,,\n", argv[i], column.c_str());
+        }
+    }
+    return 0;
+}
+
+} // namespace memcap
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: memcap <command> [args]\n"
+            "\n"
+            "Commands:\n"
+            "  ingest  Convert UART diagnostic text into a capture file\n"
+            "  info    Show capture layout and per-column ranges\n"
+            "  range   Min/max of a column between two times\n"
+            "  query   Windowed aggregates (min/max/mean/count/pNN) as CSV\n"
+            "  diff    A/B regression report between two sets of captures/logs\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    std::string cmd = argv[1];
+    if (cmd == "ingest") {
+        return memcap::cmd_ingest(argc - 1, argv + 1);
+    }
+    if (cmd == "info") {
+        return memcap::cmd_info(argc - 1, argv + 1);
+    }
+    if (cmd == "range") {
+        return memcap::cmd_range(argc - 1, argv + 1);
+    }
+    if (cmd == "query") {
+        return memcap::cmd_query(argc - 1, argv + 1);
+    }
+    if (cmd == "diff") {
+        return memcap::cmd_diff(argc - 1, argv + 1);
+    }
+
+    usage();
+    return 2;
+}
@@ -0,0 +1,402 @@
+/**
+ * @file query.cpp
+ * @brief Parallel windowed aggregation over one or many captures
+ *
+ * Usage:
+ *   memcap query -w 1m -a min:free_ram -a p99:stack_peak [-a count]
+ *                [--from t] [--to t] [-j threads] capture.mcap...
+ *
+ * Every capture is split into block ranges that worker threads pull from a
+ * shared queue. Each worker aggregates into its own per-window table; the
+ * tables are merged once at the end, so no locking happens on the hot path.
+ * Windows are aligned to multiples of the window length, which makes
+ * captures from different devices land in the same rows.
+ *
+ * Output is CSV: window_start_s followed by one column per aggregate.
+ */
+
+#include "capture.h"
+#include "commands.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace memcap {
+
+// ============================================================================
+// AGGREGATE SPECIFICATION
+// ============================================================================
+
+enum AggKind { kAggMin, kAggMax, kAggMean, kAggCount, kAggQuantile };
+
+struct AggSpec {
+    AggKind kind;
+    double quantile;       // 0..1 for kAggQuantile
+    ColumnId column;
+    int slot;              // Index into the per-window column accumulators
+    std::string label;
+};
+
+/**
+ * @brief Running aggregate of one column within one window
+ *
+ * The histogram is exact: telemetry values are 16-bit and cluster tightly,
+ * so a value->count map stays small and merges by addition.
+ */
+struct ColumnAcc {
+    int64_t min = INT64_MAX;
+    int64_t max = INT64_MIN;
+    double sum = 0.0;
+    uint64_t count = 0;
+    std::unordered_map<int64_t, uint64_t> hist;
+
+    void add(int64_t v, bool keep_hist) {
+        min = std::min(min, v);
+        max = std::max(max, v);
+        sum += (double)v;
+        count++;
+        if (keep_hist) {
+            hist[v]++;
+        }
+    }
+
+    void merge(const ColumnAcc& other) {
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+        sum += other.sum;
+        count += other.count;
+        for (const auto& kv : other.hist) {
+            hist[kv.first] += kv.second;
+        }
+    }
+
+    // Nearest-rank quantile
+    int64_t quantile(double q) const {
+        std::vector<std::pair<int64_t, uint64_t>> sorted(hist.begin(), hist.end());
+        std::sort(sorted.begin(), sorted.end());
+        uint64_t rank = (uint64_t)std::ceil(q * (double)count);
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (const auto& kv : sorted) {
+            seen += kv.second;
+            if (seen >= rank) {
+                return kv.first;
+            }
+        }
+        return max;
+    }
+};
+
+struct WindowAcc {
+    uint64_t rows = 0;
+    std::vector<ColumnAcc> cols;
+};
+
+typedef std::map<int64_t, WindowAcc> WindowTable;
+
+struct QueryPlan {
+    int64_t window_us;
+    int64_t t1;
+    int64_t t2;
+    std::vector<AggSpec> aggs;
+    std::vector<ColumnId> columns;        // Distinct columns, slot order
+    std::vector<bool> needs_hist;         // Per slot
+    std::vector<bool> summary_ok;         // Per slot: only min/max/count used
+};
+
+static int parse_agg(const std::string& text, AggSpec* spec) {
+    std::string kind = text;
+    std::string column;
+    size_t colon = text.find(':');
+    if (colon != std::string::npos) {
+        kind = text.substr(0, colon);
+        column = text.substr(colon + 1);
+    }
+
+    spec->quantile = 0.0;
+    spec->label = column.empty() ? kind : kind + "_" + column;
+    if (kind == "min") {
+        spec->kind = kAggMin;
+    } else if (kind == "max") {
+        spec->kind = kAggMax;
+    } else if (kind == "mean") {
+        spec->kind = kAggMean;
+    } else if (kind == "count") {
+        spec->kind = kAggCount;
+        if (column.empty()) {
+            spec->column = kColTime;
+            return 1;
+        }
+    } else if (kind.size() > 1 && kind[0] == 'p') {
+        char* end = nullptr;
+        double pct = strtod(kind.c_str() + 1, &end);
+        if (*end != '\0' || pct <= 0.0 || pct > 100.0) {
+            return 0;
+        }
+        spec->kind = kAggQuantile;
+        spec->quantile = pct / 100.0;
+    } else {
+        return 0;
+    }
+
+    return !column.empty() && column_by_name(column, &spec->column);
+}
+
+static int64_t window_of(int64_t t, int64_t window_us) {
+    int64_t w = t / window_us;
+    if (t < 0 && w * window_us != t) {
+        w--;
+    }
+    return w * window_us;
+}
+
+// ============================================================================
+// WORKERS
+// ============================================================================
+
+struct WorkItem {
+    size_t file;
+    const CaptureReader* reader;
+    uint64_t first_block;
+    uint64_t end_block;
+};
+
+static void aggregate_range(const QueryPlan& plan, const WorkItem& item,
+                            const std::vector<int>& col_index, WindowTable* table) {
+    const CaptureReader& r = *item.reader;
+    size_t slots = plan.columns.size();
+
+    for (uint64_t b = item.first_block; b < item.end_block; b++) {
+        const BlockIndex& blk = r.block(b);
+        if (blk.t_last < plan.t1 || blk.t_first > plan.t2) {
+            continue;
+        }
+
+        int64_t w_first = window_of(blk.t_first, plan.window_us);
+        bool one_window = w_first == window_of(blk.t_last, plan.window_us);
+        bool inside = blk.t_first >= plan.t1 && blk.t_last <= plan.t2;
+
+        if (one_window && inside) {
+            // Answer summary-friendly columns without touching the rows
+            WindowAcc& acc = (*table)[w_first];
+            acc.cols.resize(slots);
+            acc.rows += blk.rows;
+            bool scan = false;
+            for (size_t s = 0; s < slots; s++) {
+                if (!plan.summary_ok[s]) {
+                    scan = true;
+                    continue;
+                }
+                const MinMax& mm = r.block_summary(b, col_index[s]);
+                ColumnAcc& c = acc.cols[s];
+                c.min = std::min(c.min, mm.min);
+                c.max = std::max(c.max, mm.max);
+                c.count += blk.rows;
+            }
+            if (!scan) {
+                continue;
+            }
+            for (uint32_t row = 0; row < blk.rows; row++) {
+                for (size_t s = 0; s < slots; s++) {
+                    if (!plan.summary_ok[s]) {
+                        acc.cols[s].add(r.value(b, col_index[s], row), plan.needs_hist[s]);
+                    }
+                }
+            }
+            continue;
+        }
+
+        uint32_t row = r.first_row_at(b, plan.t1);
+        int64_t cur_window = INT64_MIN;
+        WindowAcc* acc = nullptr;
+        for (; row < blk.rows; row++) {
+            int64_t t = r.time(b, row);
+            if (t > plan.t2) {
+                break;
+            }
+            int64_t w = window_of(t, plan.window_us);
+            if (w != cur_window) {
+                cur_window = w;
+                acc = &(*table)[w];
+                acc->cols.resize(slots);
+            }
+            acc->rows++;
+            for (size_t s = 0; s < slots; s++) {
+                acc->cols[s].add(r.value(b, col_index[s], row), plan.needs_hist[s]);
+            }
+        }
+    }
+}
+
+// ============================================================================
+// COMMAND
+// ============================================================================
+
+int cmd_query(int argc, char** argv) {
+    QueryPlan plan;
+    plan.window_us = 60000000;
+    plan.t1 = INT64_MIN;
+    plan.t2 = INT64_MAX;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-w" || arg == "--window") && i + 1 < argc) {
+            if (!parse_time_us(argv[++i], &plan.window_us) || plan.window_us <= 0) {
+                fprintf(stderr, "memcap query: bad window '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if ((arg == "-a" || arg == "--agg") && i + 1 < argc) {
+            AggSpec spec;
+            if (!parse_agg(argv[++i], &spec)) {
+                fprintf(stderr, "memcap query: bad aggregate '%s'\n", argv[i]);
+                return 2;
+            }
+            plan.aggs.push_back(spec);
+        } else if (arg == "--from" && i + 1 < argc) {
+            if (!parse_time_us(argv[++i], &plan.t1)) {
+                fprintf(stderr, "memcap query: bad time '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if (arg == "--to" && i + 1 < argc) {
+            if (!parse_time_us(argv[++i], &plan.t2)) {
+                fprintf(stderr, "memcap query: bad time '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if (arg == "-j" && i + 1 < argc) {
+            threads = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (plan.aggs.empty() || files.empty()) {
+        fprintf(stderr, "usage: memcap query -w <window> -a <agg>:<column>... "
+                        "[--from t] [--to t] [-j n] <capture>...\n"
+                        "  aggregates: min max mean count pNN (e.g. p99, p99.9)\n");
+        return 2;
+    }
+    threads = std::max(1u, threads);
+
+    // Assign accumulator slots to distinct columns
+    for (AggSpec& spec : plan.aggs) {
+        auto it = std::find(plan.columns.begin(), plan.columns.end(), spec.column);
+        spec.slot = (int)(it - plan.columns.begin());
+        if (it == plan.columns.end()) {
+            plan.columns.push_back(spec.column);
+            plan.needs_hist.push_back(false);
+            plan.summary_ok.push_back(true);
+        }
+        if (spec.kind == kAggQuantile) {
+            plan.needs_hist[spec.slot] = true;
+        }
+        if (spec.kind == kAggQuantile || spec.kind == kAggMean) {
+            plan.summary_ok[spec.slot] = false;
+        }
+    }
+
+    std::vector<std::unique_ptr<CaptureReader>> readers;
+    std::vector<std::vector<int>> col_index;
+    std::vector<WorkItem> work;
+    for (const std::string& path : files) {
+        std::unique_ptr<CaptureReader> r(new CaptureReader());
+        if (r->open(path) != 0) {
+            fprintf(stderr, "memcap query: %s\n", r->error().c_str());
+            return 1;
+        }
+
+        std::vector<int> idx;
+        for (ColumnId id : plan.columns) {
+            int c = r->column_index(id);
+            if (c < 0) {
+                fprintf(stderr, "memcap query: %s lacks column %s\n",
+                        path.c_str(), column_info(id)->name);
+                return 1;
+            }
+            idx.push_back(c);
+        }
+
+        // Skip to the first relevant block; split the rest into chunks
+        uint64_t first = r->first_block_at(plan.t1);
+        uint64_t total = r->block_count();
+        uint64_t chunk = std::max<uint64_t>(1, (total - first) / (threads * 4));
+        for (uint64_t b = first; b < total; b += chunk) {
+            work.push_back(WorkItem{readers.size(), r.get(), b, std::min(total, b + chunk)});
+        }
+
+        col_index.push_back(idx);
+        readers.push_back(std::move(r));
+    }
+
+    std::vector<WindowTable> partial(threads);
+    std::atomic<size_t> next(0);
+    auto worker = [&](unsigned id) {
+        for (size_t i = next++; i < work.size(); i = next++) {
+            aggregate_range(plan, work[i], col_index[work[i].file], &partial[id]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < threads; i++) {
+        pool.emplace_back(worker, i);
+    }
+    for (std::thread& t : pool) {
+        t.join();
+    }
+
+    WindowTable merged;
+    for (WindowTable& table : partial) {
+        for (auto& kv : table) {
+            WindowAcc& dst = merged[kv.first];
+            dst.cols.resize(plan.columns.size());
+            dst.rows += kv.second.rows;
+            for (size_t s = 0; s < plan.columns.size(); s++) {
+                dst.cols[s].merge(kv.second.cols[s]);
+            }
+        }
+    }
+
+    printf("window_start_s");
+    for (const AggSpec& spec : plan.aggs) {
+        printf(",%s", spec.label.c_str());
+    }
+    printf("\n");
+
+    for (const auto& kv : merged) {
+        printf("%.6f", kv.first / 1e6);
+        for (const AggSpec& spec : plan.aggs) {
+            const ColumnAcc& c = kv.second.cols[spec.slot];
+            switch (spec.kind) {
+            case kAggMin:
+                printf(",%" PRId64, c.min);
+                break;
+            case kAggMax:
+                printf(",%" PRId64, c.max);
+                break;
+            case kAggMean:
+                printf(",%.3f", c.count ? c.sum / (double)c.count : 0.0);
+                break;
+            case kAggCount:
+                printf(",%" PRIu64, kv.second.rows);
+                break;
+            case kAggQuantile:
+                printf(",%" PRId64, c.quantile(spec.quantile));
+                break;
+            }
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+} // namespace memcap
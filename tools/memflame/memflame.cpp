@@ -0,0 +1,182 @@
+/**
+ * @file memflame.cpp
+ * @brief Heap flame graphs from sampled allocation call chains
+ *
+ * Usage:
+ *   memflame [-e build/memory_monitor.elf] [-m live|alloc] [-s scale] log.txt
+ *
+ * Reads the "[HEAP] A/F" events emitted by firmware built with
+ * MEM_MONITOR_CALLSITE_DEPTH > 0 and writes folded stacks, one line per
+ * distinct call chain:
+ *
+ *   main;heap_fragmentation_test 96
+ *
+ * which flamegraph.pl, speedscope or inferno render directly.
+ *
+ * Modes:
+ *   live   Bytes still allocated at the end of the log (leaks, long-lived)
+ *   alloc  Total bytes allocated over the log (allocation rate / churn)
+ *
+ * Counts are multiplied by -s (use the firmware's
+ * MEM_MONITOR_CALLSITE_SAMPLE_RATE) to estimate totals from samples.
+ */
+
+#include "../symbolizer/symbolizer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// SYMBOLIZATION
+// ============================================================================
+
+/**
+ * @brief Resolve flash addresses to function names in one batch
+ */
+static std::map<uint32_t, std::string> symbolize(const std::string& elf,
+                                                 const std::vector<uint32_t>& addrs) {
+    std::map<uint32_t, std::string> names;
+    for (uint32_t a : addrs) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "0x%04x", a);
+        names[a] = buf;
+    }
+    if (elf.empty() || addrs.empty()) {
+        return names;
+    }
+
+    memsym::Symbolizer sym;
+    if (sym.load(elf) != 0) {
+        fprintf(stderr, "memflame: %s\n", sym.error().c_str());
+        return names;
+    }
+
+    // Return addresses point behind the call; look up the call itself
+    std::vector<uint64_t> calls;
+    for (uint32_t a : addrs) {
+        calls.push_back(a ? a - 1 : 0);
+    }
+    std::vector<memsym::Location> locs;
+    sym.resolve_batch(calls, &locs);
+    for (size_t i = 0; i < addrs.size(); i++) {
+        if (locs[i].function) {
+            names[addrs[i]] = locs[i].function;
+        }
+    }
+    return names;
+}
+
+// ============================================================================
+// EVENT PARSING
+// ============================================================================
+
+struct Block {
+    uint32_t size;
+    std::vector<uint32_t> chain;   // Innermost caller first
+};
+
+int main(int argc, char** argv) {
+    std::string elf;
+    std::string mode = "live";
+    double scale = 1.0;
+    std::string path = "-";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-e" && i + 1 < argc) {
+            elf = argv[++i];
+        } else if (arg == "-m" && i + 1 < argc) {
+            mode = argv[++i];
+        } else if (arg == "-s" && i + 1 < argc) {
+            scale = strtod(argv[++i], nullptr);
+        } else if (arg == "-h" || arg == "--help") {
+            fprintf(stderr, "usage: memflame [-e elf] [-m live|alloc] [-s scale] [log|-]\n");
+            return 2;
+        } else {
+            path = arg;
+        }
+    }
+    if (mode != "live" && mode != "alloc") {
+        fprintf(stderr, "memflame: unknown mode '%s'\n", mode.c_str());
+        return 2;
+    }
+
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            fprintf(stderr, "memflame: cannot open %s\n", path.c_str());
+            return 1;
+        }
+        in = &file;
+    }
+
+    std::map<uint32_t, Block> live;                       // ptr -> block
+    std::map<std::vector<uint32_t>, double> allocated;    // chain -> bytes
+    std::string line;
+    while (std::getline(*in, line)) {
+        size_t at = line.find("[HEAP] ");
+        if (at == std::string::npos) {
+            continue;
+        }
+        std::istringstream ev(line.substr(at + 7));
+        std::string kind;
+        std::string ptr_text;
+        ev >> kind >> ptr_text;
+        uint32_t ptr = (uint32_t)strtoul(ptr_text.c_str(), nullptr, 16);
+
+        if (kind == "A") {
+            Block b;
+            ev >> b.size;
+            std::string site;
+            while (ev >> site) {
+                b.chain.push_back((uint32_t)strtoul(site.c_str(), nullptr, 16));
+            }
+            allocated[b.chain] += b.size;
+            live[ptr] = b;
+        } else if (kind == "F") {
+            live.erase(ptr);
+        }
+    }
+
+    std::map<std::vector<uint32_t>, double> weights;
+    if (mode == "alloc") {
+        weights = allocated;
+    } else {
+        for (const auto& kv : live) {
+            weights[kv.second.chain] += kv.second.size;
+        }
+    }
+
+    std::set<uint32_t> unique;
+    for (const auto& kv : weights) {
+        unique.insert(kv.first.begin(), kv.first.end());
+    }
+    std::map<uint32_t, std::string> names =
+        symbolize(elf, std::vector<uint32_t>(unique.begin(), unique.end()));
+
+    // Folded format lists the outermost frame first
+    for (const auto& kv : weights) {
+        std::string stack;
+        for (size_t i = kv.first.size(); i-- > 0;) {
+            if (!stack.empty()) {
+                stack += ';';
+            }
+            stack += names[kv.first[i]];
+        }
+        if (stack.empty()) {
+            stack = "[unknown]";
+        }
+        printf("%s %.0f\n", stack.c_str(), kv.second * scale);
+    }
+    return 0;
+}
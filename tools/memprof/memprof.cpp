@@ -0,0 +1,217 @@
+/**
+ * @file memprof.cpp
+ * @brief Hot-function and stack-depth profile from PC samples
+ *
+ * Usage:
+ *   memprof [-e build/memory_monitor.elf] [-l] [-p phase] [-n top] log.txt
+ *
+ * Reads the "[PROF]" lines drained by firmware built with
+ * MEM_MONITOR_PC_PROFILE=1, merges the per-window sample tables and prints
+ * one row per function (or per source line with -l):
+ *
+ *   samples   Samples whose PC bucket resolves to the row
+ *   share     Fraction of all samples in the log (CPU time estimate)
+ *   time      samples / sample rate
+ *   depth     Deepest stack (bytes) seen at any of those samples
+ *
+ * -p limits the profile to samples drained after "[PHASE] <phase>" and
+ * before the next phase marker. Buckets are resolved at their first byte,
+ * so with MEM_PC_PROFILE_BUCKET_SHIFT > 1 a bucket straddling two functions
+ * is charged to the first one.
+ */
+
+#include "../symbolizer/symbolizer.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Bucket {
+    uint64_t samples = 0;
+    uint32_t max_depth = 0;
+};
+
+struct Row {
+    std::string name;
+    uint64_t samples = 0;
+    uint32_t max_depth = 0;
+};
+
+/**
+ * @brief Value of "key=<number>" in a line (decimal or 0x hex)
+ */
+bool field(const std::string& line, const char* key, uint64_t* value) {
+    std::string token = std::string(" ") + key + "=";
+    size_t at = line.find(token);
+    if (at == std::string::npos) {
+        return false;
+    }
+    *value = strtoull(line.c_str() + at + token.size(), nullptr, 0);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string elf;
+    std::string phase;
+    std::string path = "-";
+    bool by_line = false;
+    size_t top = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-e" && i + 1 < argc) {
+            elf = argv[++i];
+        } else if (arg == "-p" && i + 1 < argc) {
+            phase = argv[++i];
+        } else if (arg == "-n" && i + 1 < argc) {
+            top = (size_t)atoi(argv[++i]);
+        } else if (arg == "-l") {
+            by_line = true;
+        } else if (arg == "-h" || arg == "--help") {
+            fprintf(stderr, "usage: memprof [-e elf] [-l] [-p phase] [-n top] [log|-]\n");
+            return 2;
+        } else {
+            path = arg;
+        }
+    }
+
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            fprintf(stderr, "memprof: cannot open %s\n", path.c_str());
+            return 1;
+        }
+        in = &file;
+    }
+
+    // Merge all drained windows; a bucket may appear more than once per
+    // window when a sample re-created it during the drain
+    std::map<uint32_t, Bucket> buckets;
+    uint64_t total = 0;
+    uint64_t dropped = 0;
+    uint64_t hz = 0;
+    uint64_t bucket_bytes = 0;
+    bool in_phase = phase.empty();
+    std::string line;
+    while (std::getline(*in, line)) {
+        size_t at = line.find("[PHASE] ");
+        if (at != std::string::npos && !phase.empty()) {
+            std::string name = line.substr(at + 8);
+            while (!name.empty() && (name.back() == '\r' || name.back() == ' ')) {
+                name.pop_back();
+            }
+            in_phase = name == phase;
+            continue;
+        }
+        at = line.find("[PROF]");
+        if (at == std::string::npos || !in_phase) {
+            continue;
+        }
+        std::string rest = line.substr(at + 6);
+        uint64_t v;
+        if (field(rest, "samples", &v)) {
+            total += v;
+            if (field(rest, "dropped", &v)) {
+                dropped += v;
+            }
+            field(rest, "hz", &hz);
+            field(rest, "bucket", &bucket_bytes);
+        } else if (field(rest, "pc", &v)) {
+            Bucket& b = buckets[(uint32_t)v];
+            uint64_t n = 0;
+            uint64_t depth = 0;
+            field(rest, "n", &n);
+            field(rest, "depth", &depth);
+            b.samples += n;
+            b.max_depth = std::max(b.max_depth, (uint32_t)depth);
+        }
+    }
+    if (buckets.empty()) {
+        fprintf(stderr, "memprof: no [PROF] samples%s%s\n", phase.empty() ? "" : " in phase ",
+                phase.c_str());
+        return 1;
+    }
+
+    std::vector<uint64_t> addrs;
+    for (const auto& kv : buckets) {
+        addrs.push_back(kv.first);
+    }
+    std::vector<memsym::Location> locs(addrs.size(), memsym::Location{nullptr, 0, nullptr, 0});
+    if (!elf.empty()) {
+        memsym::Symbolizer sym;
+        if (sym.load(elf) != 0) {
+            fprintf(stderr, "memprof: %s\n", sym.error().c_str());
+            return 1;
+        }
+        // Sampled PCs are the next instruction to execute, not return
+        // addresses: no adjustment
+        sym.resolve_batch(addrs, &locs);
+    }
+
+    std::map<std::string, Row> rows;
+    size_t i = 0;
+    for (const auto& kv : buckets) {
+        const memsym::Location& loc = locs[i++];
+        std::string name;
+        if (by_line && loc.file) {
+            name = std::string(loc.file) + ":" + std::to_string(loc.line);
+            if (loc.function) {
+                name += " (" + std::string(loc.function) + ")";
+            }
+        } else if (loc.function) {
+            name = loc.function;
+        } else {
+            char buf[16];
+            snprintf(buf, sizeof(buf), "0x%04x", kv.first);
+            name = buf;
+        }
+        Row& r = rows[name];
+        r.name = name;
+        r.samples += kv.second.samples;
+        r.max_depth = std::max(r.max_depth, kv.second.max_depth);
+    }
+
+    std::vector<Row> sorted;
+    uint64_t resolved = 0;
+    for (const auto& kv : rows) {
+        sorted.push_back(kv.second);
+        resolved += kv.second.samples;
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Row& a, const Row& b) {
+        return a.samples != b.samples ? a.samples > b.samples : a.name < b.name;
+    });
+
+    // Window totals saturate at 65535 per drain; never report less than
+    // the samples actually listed
+    total = std::max(total, resolved + dropped);
+    printf("memprof: %" PRIu64 " samples", total);
+    if (hz) {
+        printf(" (%.2f s at %" PRIu64 " Hz)", (double)total / hz, hz);
+    }
+    printf(", %" PRIu64 " dropped (%.1f%%), %" PRIu64 "-byte buckets\n", dropped,
+           total ? 100.0 * dropped / total : 0.0, bucket_bytes);
+    printf("%10s %7s %10s %7s  %s\n", "samples", "share", "time ms", "depth", by_line ? "line" : "function");
+
+    size_t shown = 0;
+    for (const Row& r : sorted) {
+        if (top && shown++ >= top) {
+            break;
+        }
+        printf("%10" PRIu64 " %6.1f%% %10.1f %7u  %s\n", r.samples, 100.0 * r.samples / total,
+               hz ? 1000.0 * r.samples / hz : 0.0, r.max_depth, r.name.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,494 @@
+/**
+ * @file memfault.cpp
+ * @brief Fault injection harness measuring monitor detection coverage
+ *
+ * Usage:
+ *   memfault [-f fault,...] [-n trials] [--from time] [--to time]
+ *            [--window time] [--bytes n] [--seed n] [--csv] firmware.elf...
+ *
+ * For every firmware build (one ELF per monitor configuration) the harness
+ * first records a fault-free control run, then repeats the run once per
+ * trial, injects a single fault at the trial's cycle and watches for the
+ * monitor's reaction within the detection window:
+ *
+ *   heap-overrun   Write past the end of a live tracked block
+ *   freelist       Corrupt the next link of the first avr-libc free chunk
+ *   stack-burst    Dirty the stack below SP, as a burst of nested ISRs that
+ *                  has already unwound would
+ *   double-free    Force a call of free() on an already released block
+ *   bss-stray      Flip a random byte in .bss
+ *
+ * Detection signals: a "[FAULT]" line, a UART line containing "WARNING",
+ * the mailbox collision flag rising, and (stack-burst only) the reported
+ * stack peak reaching the burst depth. A signal only counts if the control
+ * run shows no signal of the same kind over the same interval, so
+ * deliberate warnings of the demo workload are not credited. A CPU crash
+ * or reset is reported separately.
+ */
+
+#include "sim_common.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum Fault { kHeapOverrun, kFreelist, kStackBurst, kDoubleFree, kBssStray, kFaultCount };
+
+const char* const kFaultNames[kFaultCount] = {
+    "heap-overrun", "freelist", "stack-burst", "double-free", "bss-stray",
+};
+
+enum Signal { kSigFault, kSigWarning, kSigCollision, kSigPeak, kSignalCount };
+
+const char* const kSignalNames[kSignalCount] = {"fault", "warning", "collision", "peak"};
+
+enum Result { kDetected, kCrashed, kMissed, kNotApplicable };
+
+struct Event {
+    uint64_t cycle;
+    Signal signal;
+};
+
+/**
+ * @brief Detection signals and stack peak history of one run
+ */
+struct RunLog {
+    std::vector<Event> events;
+    std::vector<std::pair<uint64_t, uint16_t>> peaks;   // (cycle, max_stack_usage) steps
+    uint16_t last_gen = 0;
+    uint8_t last_collision = 0;
+    bool reset = false;
+
+    /**
+     * @brief First event of a kind in [from, to], or UINT64_MAX
+     */
+    uint64_t first(Signal sig, uint64_t from, uint64_t to) const {
+        for (const Event& e : events) {
+            if (e.signal == sig && e.cycle >= from && e.cycle <= to) {
+                return e.cycle;
+            }
+        }
+        return UINT64_MAX;
+    }
+
+    /**
+     * @brief Cycle at which the reported stack peak first reached a depth
+     */
+    uint64_t peak_reached(uint16_t depth) const {
+        for (const auto& p : peaks) {
+            if (p.second >= depth) {
+                return p.first;
+            }
+        }
+        return UINT64_MAX;
+    }
+};
+
+struct TrialResult {
+    Fault fault;
+    uint64_t inject;
+    Result result;
+    Signal signal;
+    uint64_t latency;
+    std::string detail;
+};
+
+struct Options {
+    std::vector<Fault> faults;
+    unsigned trials = 4;
+    std::string from = "500ms";
+    std::string to = "4s";
+    std::string window = "1s";
+    unsigned bytes = 0;              // 0 = per-fault default
+    unsigned seed = 1;
+    bool csv = false;
+};
+
+/**
+ * @brief Attach signal collection to a simulation
+ */
+void watch(memsim::Simulation& sim, RunLog* log) {
+    sim.on_line([log](uint64_t cycle, const std::string& line) {
+        if (line.find("[FAULT]") != std::string::npos) {
+            log->events.push_back(Event{cycle, kSigFault});
+        } else if (line.find("WARNING") != std::string::npos) {
+            log->events.push_back(Event{cycle, kSigWarning});
+        }
+    });
+}
+
+/**
+ * @brief Step until a cycle, recording mailbox-derived signals
+ * @return false if the core stopped or the firmware restarted
+ */
+bool run_until(memsim::Simulation& sim, RunLog* log, uint64_t until) {
+    uint32_t reset_vector = 0;
+    while (sim.cycle() < until) {
+        if (!sim.step()) {
+            return false;
+        }
+        if (sim.pc() == reset_vector && sim.cycle() > 16) {
+            log->reset = true;
+            return false;
+        }
+
+        uint16_t gen = sim.mailbox_generation();
+        memsim::MailboxSnapshot mb;
+        if (gen != log->last_gen && !(gen & 1) && sim.read_mailbox(&mb)) {
+            log->last_gen = gen;
+            if (mb.collision_warning && !log->last_collision) {
+                log->events.push_back(Event{sim.cycle(), kSigCollision});
+            }
+            log->last_collision = mb.collision_warning;
+            if (log->peaks.empty() || mb.max_stack_usage > log->peaks.back().second) {
+                log->peaks.push_back(std::make_pair(sim.cycle(), mb.max_stack_usage));
+            }
+        }
+    }
+    return true;
+}
+
+struct TableEntry {
+    uint16_t ptr;
+    uint16_t size;
+    uint8_t active;
+};
+
+std::vector<TableEntry> read_table(const memsim::Simulation& sim) {
+    std::vector<TableEntry> out;
+    memsim::MailboxSnapshot mb;
+    if (!sim.read_mailbox(&mb)) {
+        return out;
+    }
+    for (uint8_t i = 0; i < mb.alloc_table_len; i++) {
+        uint16_t e = mb.alloc_table + i * mb.alloc_entry_size;
+        TableEntry t;
+        t.ptr = sim.read16(e);
+        t.size = sim.read16(e + 2);
+        t.active = sim.read8(e + 4);
+        out.push_back(t);
+    }
+    return out;
+}
+
+/**
+ * @brief Apply a fault to the running simulation
+ * @param peak_depth Receives the stack depth a stack-burst reaches
+ * @return false if the fault cannot be applied in the current state
+ */
+bool inject(memsim::Simulation& sim, Fault fault, unsigned bytes, std::mt19937& rng,
+            uint16_t* peak_depth, std::string* detail) {
+    char buf[96];
+    switch (fault) {
+    case kHeapOverrun: {
+        std::vector<TableEntry> live;
+        for (const TableEntry& t : read_table(sim)) {
+            if (t.active) {
+                live.push_back(t);
+            }
+        }
+        if (live.empty()) {
+            *detail = "no live block";
+            return false;
+        }
+        const TableEntry& t = live[rng() % live.size()];
+        unsigned n = bytes ? bytes : 4;
+        for (unsigned i = 0; i < n; i++) {
+            sim.write8((uint16_t)(t.ptr + t.size + i), 0x5A);
+        }
+        snprintf(buf, sizeof(buf), "%u B past 0x%04x+%u", n, t.ptr, t.size);
+        break;
+    }
+    case kFreelist: {
+        uint16_t flp_sym = sim.data_symbol("__flp");
+        uint16_t chunk = flp_sym ? sim.read16(flp_sym) : 0;
+        if (!chunk) {
+            *detail = "free list empty";
+            return false;
+        }
+        uint16_t bogus = (uint16_t)(memsim::kSramStart + rng() % (memsim::kRamEnd - memsim::kSramStart));
+        sim.write16(chunk + 2, bogus); // struct __freelist { size_t sz; __freelist* nx; }
+        snprintf(buf, sizeof(buf), "chunk 0x%04x nx -> 0x%04x", chunk, bogus);
+        break;
+    }
+    case kStackBurst: {
+        unsigned n = bytes ? bytes : 192;
+        uint16_t sp = sim.sp();
+        uint16_t low = sp > n ? (uint16_t)(sp - n + 1) : memsim::kSramStart;
+        for (uint16_t a = low; a <= sp; a++) {
+            sim.write8(a, (uint8_t)rng());
+        }
+        *peak_depth = (uint16_t)(memsim::kRamEnd - low);
+        snprintf(buf, sizeof(buf), "%u B below SP 0x%04x", n, sp);
+        break;
+    }
+    case kDoubleFree: {
+        std::vector<TableEntry> table = read_table(sim);
+        std::vector<uint16_t> freed;
+        for (const TableEntry& t : table) {
+            bool live = false;
+            for (const TableEntry& u : table) {
+                live = live || (u.active && u.ptr == t.ptr);
+            }
+            if (!t.active && t.ptr && !live) {
+                freed.push_back(t.ptr);
+            }
+        }
+        uint32_t fn = sim.code_symbol("__wrap_free");
+        if (!fn) {
+            fn = sim.code_symbol("free");
+        }
+        if (freed.empty() || !fn || sim.in_call()) {
+            *detail = freed.empty() ? "no released block" : "free() not found";
+            return false;
+        }
+        uint16_t ptr = freed[rng() % freed.size()];
+        sim.begin_call(fn, ptr);
+        snprintf(buf, sizeof(buf), "free(0x%04x) again", ptr);
+        break;
+    }
+    case kBssStray: {
+        uint16_t start = sim.data_symbol("__bss_start");
+        uint16_t end = sim.data_symbol("__bss_end");
+        if (end <= start) {
+            *detail = "empty .bss";
+            return false;
+        }
+        uint16_t addr = (uint16_t)(start + rng() % (end - start));
+        sim.write8(addr, sim.read8(addr) ^ 0xFF);
+        snprintf(buf, sizeof(buf), "byte 0x%04x (%s)", addr,
+                 sim.symbols().describe(0x800000 + addr).c_str());
+        break;
+    }
+    default:
+        return false;
+    }
+    *detail = buf;
+    return true;
+}
+
+TrialResult run_trial(const std::string& elf, const RunLog& control, Fault fault,
+                      uint64_t at, uint64_t window, const Options& opt, unsigned index) {
+    TrialResult r;
+    r.fault = fault;
+    r.inject = at;
+    r.result = kMissed;
+    r.signal = kSigFault;
+    r.latency = 0;
+
+    memsim::Simulation sim;
+    RunLog log;
+    if (sim.open(elf) != 0) {
+        r.result = kNotApplicable;
+        r.detail = sim.error();
+        return r;
+    }
+    watch(sim, &log);
+    if (!run_until(sim, &log, at)) {
+        r.result = kNotApplicable;
+        r.detail = "firmware stopped before injection";
+        return r;
+    }
+
+    std::mt19937 rng(opt.seed * 7919u + index);
+    uint16_t peak_depth = 0;
+    if (!inject(sim, fault, opt.bytes, rng, &peak_depth, &r.detail)) {
+        r.result = kNotApplicable;
+        return r;
+    }
+    uint64_t injected = sim.cycle();
+    bool alive = run_until(sim, &log, injected + window);
+
+    // Earliest signal not also present in the control run
+    uint64_t best = UINT64_MAX;
+    for (int s = 0; s < kSignalCount; s++) {
+        Signal sig = (Signal)s;
+        uint64_t hit;
+        if (sig == kSigPeak) {
+            if (!peak_depth || control.peak_reached(peak_depth) <= injected + window) {
+                continue;
+            }
+            hit = log.peak_reached(peak_depth);
+        } else {
+            hit = log.first(sig, injected, injected + window);
+            if (hit != UINT64_MAX && control.first(sig, injected, hit) != UINT64_MAX) {
+                continue;
+            }
+        }
+        if (hit < best) {
+            best = hit;
+            r.signal = sig;
+        }
+    }
+
+    if (best != UINT64_MAX) {
+        r.result = kDetected;
+        r.latency = best > injected ? best - injected : 0;
+    } else if (!alive) {
+        r.result = kCrashed;
+        r.latency = sim.cycle() - injected;
+        r.detail += log.reset ? ", reset" : ", core stopped";
+    }
+    return r;
+}
+
+void report(const std::string& elf, const std::vector<TrialResult>& results, double us_per_cycle,
+            const Options& opt) {
+    if (opt.csv) {
+        for (const TrialResult& r : results) {
+            static const char* const kResults[] = {"detected", "crashed", "missed", "n/a"};
+            printf("%s,%s,%" PRIu64 ",%s,%s,%.1f,\"%s\"\n", elf.c_str(), kFaultNames[r.fault],
+                   r.inject, kResults[r.result], r.result == kDetected ? kSignalNames[r.signal] : "",
+                   r.latency * us_per_cycle, r.detail.c_str());
+        }
+        return;
+    }
+
+    printf("== %s\n", elf.c_str());
+    printf("%-13s %6s %8s %7s %6s %4s  %-28s %s\n", "fault", "trials", "detected", "crashed",
+           "missed", "n/a", "latency min/med/max (us)", "signals");
+    for (const Fault f : opt.faults) {
+        unsigned counts[4] = {0, 0, 0, 0};
+        unsigned signals[kSignalCount] = {0, 0, 0, 0};
+        std::vector<uint64_t> lat;
+        for (const TrialResult& r : results) {
+            if (r.fault != f) {
+                continue;
+            }
+            counts[r.result]++;
+            if (r.result == kDetected) {
+                signals[r.signal]++;
+                lat.push_back(r.latency);
+            }
+        }
+        std::string latency = "-";
+        if (!lat.empty()) {
+            std::sort(lat.begin(), lat.end());
+            char buf[64];
+            snprintf(buf, sizeof(buf), "%.0f/%.0f/%.0f", lat.front() * us_per_cycle,
+                     lat[lat.size() / 2] * us_per_cycle, lat.back() * us_per_cycle);
+            latency = buf;
+        }
+        std::string sigs;
+        for (int s = 0; s < kSignalCount; s++) {
+            if (signals[s]) {
+                sigs += (sigs.empty() ? "" : ",") + std::string(kSignalNames[s]) + "x" +
+                        std::to_string(signals[s]);
+            }
+        }
+        unsigned applicable = counts[kDetected] + counts[kCrashed] + counts[kMissed];
+        printf("%-13s %6u %8u %7u %6u %4u  %-28s %s\n", kFaultNames[f], applicable,
+               counts[kDetected], counts[kCrashed], counts[kMissed], counts[kNotApplicable],
+               latency.c_str(), sigs.empty() ? "-" : sigs.c_str());
+    }
+    printf("\n");
+}
+
+bool parse_faults(const std::string& list, std::vector<Fault>* out) {
+    std::stringstream ss(list);
+    std::string name;
+    while (std::getline(ss, name, ',')) {
+        int found = -1;
+        for (int f = 0; f < kFaultCount; f++) {
+            if (name == kFaultNames[f]) {
+                found = f;
+            }
+        }
+        if (found < 0) {
+            fprintf(stderr, "memfault: unknown fault '%s'\n", name.c_str());
+            return false;
+        }
+        out->push_back((Fault)found);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    std::vector<std::string> elfs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-f" && i + 1 < argc) {
+            if (!parse_faults(argv[++i], &opt.faults)) {
+                return 2;
+            }
+        } else if (arg == "-n" && i + 1 < argc) {
+            opt.trials = (unsigned)atoi(argv[++i]);
+        } else if (arg == "--from" && i + 1 < argc) {
+            opt.from = argv[++i];
+        } else if (arg == "--to" && i + 1 < argc) {
+            opt.to = argv[++i];
+        } else if (arg == "--window" && i + 1 < argc) {
+            opt.window = argv[++i];
+        } else if (arg == "--bytes" && i + 1 < argc) {
+            opt.bytes = (unsigned)atoi(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            opt.seed = (unsigned)atoi(argv[++i]);
+        } else if (arg == "--csv") {
+            opt.csv = true;
+        } else if (arg == "-h" || arg == "--help") {
+            fprintf(stderr, "usage: memfault [-f fault,...] [-n trials] [--from t] [--to t] "
+                            "[--window t] [--bytes n] [--seed n] [--csv] firmware.elf...\n");
+            return 2;
+        } else {
+            elfs.push_back(arg);
+        }
+    }
+    if (elfs.empty() || opt.trials == 0) {
+        fprintf(stderr, "memfault: firmware ELF required\n");
+        return 2;
+    }
+    if (opt.faults.empty()) {
+        for (int f = 0; f < kFaultCount; f++) {
+            opt.faults.push_back((Fault)f);
+        }
+    }
+    if (opt.csv) {
+        printf("elf,fault,inject_cycle,result,signal,latency_us,detail\n");
+    }
+
+    for (const std::string& elf : elfs) {
+        memsim::Simulation control_sim;
+        if (control_sim.open(elf) != 0) {
+            fprintf(stderr, "memfault: %s\n", control_sim.error().c_str());
+            return 1;
+        }
+        uint64_t from, to, window;
+        uint32_t hz = control_sim.frequency();
+        if (!memsim::parse_cycles(opt.from, hz, &from) || !memsim::parse_cycles(opt.to, hz, &to) ||
+            !memsim::parse_cycles(opt.window, hz, &window) || to < from) {
+            fprintf(stderr, "memfault: bad --from/--to/--window\n");
+            return 2;
+        }
+
+        RunLog control;
+        watch(control_sim, &control);
+        if (!run_until(control_sim, &control, to + window)) {
+            fprintf(stderr, "memfault: %s stops or resets without faults; no baseline\n",
+                    elf.c_str());
+            return 1;
+        }
+
+        std::vector<TrialResult> results;
+        unsigned index = 0;
+        for (const Fault f : opt.faults) {
+            for (unsigned t = 0; t < opt.trials; t++, index++) {
+                uint64_t at = from + (uint64_t)((to - from) * (t + 0.5) / opt.trials);
+                results.push_back(run_trial(elf, control, f, at, window, opt, index));
+            }
+        }
+        report(elf, results, 1e6 / hz, opt);
+    }
+    return 0;
+}
@@ -0,0 +1,329 @@
+/**
+ * @file memirq.cpp
+ * @brief Interrupts-disabled window measurement per monitor API
+ *
+ * Usage:
+ *   memirq [-c cycles|-t time] [--probe n] [--probe-at time] [-a function]
+ *          [--budget cycles] firmware.elf
+ *
+ * Follows the SREG I flag after every instruction. Each stretch with
+ * interrupts disabled is one window: its length is the worst extra latency
+ * an interrupt becoming pending at its start would see. Windows opened by
+ * an interrupt entry (PC in the vector table) are ISR bodies and reported
+ * per vector; all other windows are charged to every monitor API on the
+ * call stack when the window opened, along with the instruction that
+ * disabled interrupts.
+ *
+ * The workload alone may not call every API, so --probe n additionally
+ * calls each argument-free API (plus malloc/free) n times at --probe-at,
+ * with interrupts left enabled.
+ *
+ * With --budget the exit status is 1 if any monitor API holds interrupts
+ * off for longer than the given number of cycles.
+ */
+
+#include "sim_common.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+// ATmega328P: 26 vectors of 2 words each
+const uint32_t kVectorTableEnd = 26 * 4;
+
+// Monitor entry points charged for the windows they contain. Probe-safe
+// ones take no arguments and do not reset monitor state.
+struct Api {
+    const char* name;
+    bool probe;
+};
+
+const Api kApis[] = {
+    {"mem_monitor_update", true},
+    {"mem_monitor_get_stack_pointer", true},
+    {"mem_monitor_get_current_stack_usage", true},
+    {"mem_monitor_get_max_stack_usage", true},
+    {"mem_monitor_get_free_stack_space", true},
+    {"mem_monitor_get_heap_used", true},
+    {"mem_monitor_get_fragmentation_ratio", true},
+    {"mem_monitor_check_collision", true},
+    {"mem_monitor_stack_headroom", true},
+    {"mem_monitor_stack_floor", true},
+    {"mem_monitor_stack_check", true},
+    {"mem_monitor_print_diagnostics", true},
+    {"mem_monitor_print_irq_latency", true},
+    {"mem_monitor_print_isr_profile", true},
+    {"mem_monitor_print_pc_profile", true},
+    {"mem_monitor_print_budget", true},
+    {"mem_monitor_print_alloc_tags", true},
+    {"mem_monitor_print_tasks", true},
+    {"mem_monitor_free_drain", true},
+    {"mem_monitor_print_alloc_failures", true},
+    {"mem_monitor_print_frag_blame", true},
+    {"mem_monitor_print_dual_heaps", true},
+    {"mem_monitor_get_stats", false},
+    {"mem_monitor_init", false},
+    {"mem_monitor_mark_phase", false},
+    {"mem_monitor_track_alloc", false},
+    {"mem_monitor_track_free", false},
+    {"mem_monitor_record_callsite", false},
+    {"mem_monitor_stack_reserve", false},
+    {"mem_monitor_stack_release", false},
+    {"mem_provider_register", false},
+    {"mem_provider_unregister", false},
+    {"mem_monitor_note_stack_usage", false},
+    {"mem_task_add", false},
+    {"mem_task_run", false},
+    {"mem_alloc_failure_record", false},
+    {"mem_monitor_find_alloc", false},
+    {"__wrap_malloc", false},
+    {"__wrap_free", false},
+};
+
+struct Context {
+    std::string name;
+    uint32_t addr;
+    bool probe;
+    uint64_t windows = 0;
+    uint64_t total = 0;
+    uint64_t max = 0;
+    uint32_t worst_site = 0;       // Byte address of the disabling instruction
+};
+
+struct Active {
+    size_t ctx;
+    uint16_t sp;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string elf;
+    std::string limit_text = "5s";
+    std::string probe_at_text = "1s";
+    unsigned probe = 0;
+    int64_t budget = -1;
+    std::vector<std::string> extra;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-c" || arg == "-t") && i + 1 < argc) {
+            limit_text = argv[++i];
+        } else if (arg == "--probe" && i + 1 < argc) {
+            probe = (unsigned)atoi(argv[++i]);
+        } else if (arg == "--probe-at" && i + 1 < argc) {
+            probe_at_text = argv[++i];
+        } else if (arg == "-a" && i + 1 < argc) {
+            extra.push_back(argv[++i]);
+        } else if (arg == "--budget" && i + 1 < argc) {
+            budget = atoll(argv[++i]);
+        } else if (arg == "-h" || arg == "--help") {
+            fprintf(stderr, "usage: memirq [-c cycles|-t time] [--probe n] [--probe-at time] "
+                            "[-a function] [--budget cycles] firmware.elf\n");
+            return 2;
+        } else {
+            elf = arg;
+        }
+    }
+    if (elf.empty()) {
+        fprintf(stderr, "memirq: firmware ELF required\n");
+        return 2;
+    }
+
+    memsim::Simulation sim;
+    if (sim.open(elf) != 0) {
+        fprintf(stderr, "memirq: %s\n", sim.error().c_str());
+        return 1;
+    }
+    uint64_t limit, probe_at;
+    if (!memsim::parse_cycles(limit_text, sim.frequency(), &limit) ||
+        !memsim::parse_cycles(probe_at_text, sim.frequency(), &probe_at)) {
+        fprintf(stderr, "memirq: bad time argument\n");
+        return 2;
+    }
+
+    // Contexts: monitor APIs present in this build (LTO may inline some)
+    std::vector<Context> contexts;
+    std::map<uint32_t, size_t> by_addr;
+    auto add = [&](const std::string& name, bool probe_safe) {
+        uint32_t addr = sim.code_symbol(name.c_str());
+        if (addr && !by_addr.count(addr)) {
+            Context c;
+            c.name = name;
+            c.addr = addr;
+            c.probe = probe_safe;
+            by_addr[addr] = contexts.size();
+            contexts.push_back(c);
+        }
+    };
+    for (const Api& api : kApis) {
+        add(api.name, api.probe);
+    }
+    for (const std::string& name : extra) {
+        add(name, false);
+    }
+    size_t app_ctx = contexts.size();
+    contexts.push_back(Context());
+    contexts.back().name = "(outside monitor APIs)";
+    std::map<uint32_t, Context> isr_contexts;   // Vector number -> context
+
+    std::vector<Active> stack;
+    uint8_t prev_i = sim.interrupts_enabled();
+    bool in_window = false;
+    bool window_isr = false;
+    uint32_t window_vector = 0;
+    uint32_t window_site = 0;
+    uint64_t window_start = 0;
+    std::vector<size_t> window_ctx;
+    uint64_t windows = 0;
+
+    // Probe order: every probe-safe API, then malloc/free (free releases
+    // the block the preceding malloc returned)
+    std::vector<size_t> probe_queue;
+    if (probe) {
+        for (unsigned n = 0; n < probe; n++) {
+            for (size_t c = 0; c < app_ctx; c++) {
+                if (contexts[c].probe || contexts[c].name == "__wrap_malloc" ||
+                    contexts[c].name == "__wrap_free") {
+                    probe_queue.push_back(c);
+                }
+            }
+        }
+    }
+    size_t probe_next = 0;
+    uint16_t last_block = 0;
+
+    auto close_window = [&](uint64_t now) {
+        uint64_t len = now - window_start;
+        windows++;
+        std::vector<Context*> charged;
+        if (window_isr) {
+            Context& c = isr_contexts[window_vector];
+            if (c.name.empty()) {
+                c.name = "(isr vector " + std::to_string(window_vector) + ")";
+            }
+            charged.push_back(&c);
+        } else if (window_ctx.empty()) {
+            charged.push_back(&contexts[app_ctx]);
+        } else {
+            for (size_t idx : window_ctx) {
+                charged.push_back(&contexts[idx]);
+            }
+        }
+        for (Context* c : charged) {
+            c->windows++;
+            c->total += len;
+            if (len > c->max) {
+                c->max = len;
+                c->worst_site = window_site;
+            }
+        }
+        in_window = false;
+    };
+
+    while (sim.cycle() < limit) {
+        // Forced API calls once the probe point is reached
+        if (probe_next < probe_queue.size() && sim.cycle() >= probe_at && !sim.in_call()) {
+            const Context& c = contexts[probe_queue[probe_next]];
+            uint16_t arg = 0;
+            if (c.name == "__wrap_malloc") {
+                arg = 16;
+            } else if (c.name == "__wrap_free") {
+                arg = last_block;
+            }
+            sim.begin_call(c.addr, arg, true);
+            probe_next++;
+        }
+
+        // Track monitor API frames
+        uint32_t pc = sim.pc();
+        auto api = by_addr.find(pc);
+        if (api != by_addr.end() &&
+            (stack.empty() || stack.back().ctx != api->second || stack.back().sp != sim.sp())) {
+            stack.push_back(Active{api->second, sim.sp()});
+        }
+
+        bool was_in_call = sim.in_call();
+        if (!sim.step()) {
+            break;
+        }
+        if (was_in_call && !sim.in_call()) {
+            const Context& c = contexts[probe_queue[probe_next - 1]];
+            if (c.name == "__wrap_malloc") {
+                last_block = sim.call_result();
+            }
+        }
+        while (!stack.empty() && sim.sp() > stack.back().sp) {
+            stack.pop_back();
+        }
+
+        uint8_t now_i = sim.interrupts_enabled();
+        if (prev_i && !now_i && !in_window) {
+            in_window = true;
+            window_start = sim.cycle();
+            window_site = pc;
+            window_isr = sim.pc() < kVectorTableEnd && sim.pc() != 0;
+            window_vector = sim.pc() / 4;
+            window_ctx.clear();
+            for (const Active& a : stack) {
+                bool seen = false;
+                for (size_t idx : window_ctx) {
+                    seen = seen || idx == a.ctx;
+                }
+                if (!seen) {
+                    window_ctx.push_back(a.ctx);
+                }
+            }
+        } else if (!prev_i && now_i && in_window) {
+            close_window(sim.cycle());
+        }
+        prev_i = now_i;
+    }
+    if (in_window) {
+        close_window(sim.cycle());
+    }
+
+    double us = 1e6 / sim.frequency();
+    printf("memirq: %" PRIu64 " cycles (%.3f s), %" PRIu64 " interrupts-off windows%s\n",
+           sim.cycle(), sim.cycle() * us / 1e6, windows,
+           probe_next ? ", APIs probed" : "");
+    printf("%-38s %9s %9s %9s %9s  %s\n", "context", "windows", "max cyc", "max us", "avg cyc",
+           "worst site");
+
+    int over = 0;
+    auto row = [&](const Context& c, bool monitor) {
+        if (!c.windows) {
+            return;
+        }
+        printf("%-38s %9" PRIu64 " %9" PRIu64 " %9.2f %9.1f  %s\n", c.name.c_str(), c.windows,
+               c.max, c.max * us, (double)c.total / c.windows,
+               sim.symbols().describe(c.worst_site).c_str());
+        if (monitor && budget >= 0 && (int64_t)c.max > budget) {
+            over++;
+        }
+    };
+    for (size_t i = 0; i < app_ctx; i++) {
+        row(contexts[i], true);
+    }
+    row(contexts[app_ctx], false);
+    for (const auto& kv : isr_contexts) {
+        row(kv.second, false);
+    }
+    for (size_t i = 0; i < app_ctx; i++) {
+        if (!contexts[i].windows) {
+            printf("%-38s %9s\n", contexts[i].name.c_str(), "-");
+        }
+    }
+
+    if (over) {
+        fprintf(stderr, "memirq: %d monitor API(s) exceed the %" PRId64 "-cycle budget\n", over,
+                budget);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,220 @@
+/**
+ * @file memtruth.cpp
+ * @brief Ground-truth stack and heap peaks from an instruction-level run
+ *
+ * Usage:
+ *   memtruth [-c cycles|-t time] [--until-phase name] [--tolerance bytes]
+ *            [--echo] build/memory_monitor.elf
+ *
+ * Runs the firmware under simavr and samples SP and __brkval after every
+ * instruction, which gives the exact stack peak, heap high-water mark and
+ * smallest heap/stack gap together with the cycle they occurred at. The
+ * firmware's own numbers are collected from the debugger mailbox (each
+ * publish) and the UART diagnostics, and the report lists the error of each
+ * monitoring mode:
+ *
+ *   sentinel   MemoryStats.max_stack_usage (0xAA paint scan)
+ *   sampled    Peak of MemoryStats.current_stack_usage / minimum free_ram
+ *              over all mailbox publishes (SP read at update time)
+ *   uart       Values printed in [MEM DIAGNOSTICS] blocks
+ *
+ * With --tolerance the exit status is 1 if the sentinel stack peak misses
+ * the exact peak by more than the given number of bytes.
+ */
+
+#include "sim_common.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+struct Extreme {
+    int32_t value;
+    uint64_t cycle;
+    bool seen;
+
+    Extreme() : value(0), cycle(0), seen(false) {}
+
+    void max(int32_t v, uint64_t c) {
+        if (!seen || v > value) {
+            value = v;
+            cycle = c;
+            seen = true;
+        }
+    }
+
+    void min(int32_t v, uint64_t c) {
+        if (!seen || v < value) {
+            value = v;
+            cycle = c;
+            seen = true;
+        }
+    }
+};
+
+struct Reported {
+    Extreme stack_peak;       // Largest value reported
+    Extreme free_ram;         // Smallest value reported
+    Extreme heap_used;        // Largest value reported
+};
+
+/**
+ * @brief Pull "Label: <number>" out of a diagnostics line
+ */
+bool field(const std::string& line, const char* label, int32_t* value) {
+    size_t at = line.find(label);
+    if (at == std::string::npos) {
+        return false;
+    }
+    *value = (int32_t)strtol(line.c_str() + at + strlen(label), nullptr, 10);
+    return true;
+}
+
+void print_row(const char* metric, const char* mode, const Extreme& exact,
+               const Extreme& reported, double us_per_cycle) {
+    if (!reported.seen) {
+        printf("%-18s %-9s %7d B @ %10.0f us %9s\n", metric, mode, exact.value,
+               exact.cycle * us_per_cycle, "n/a");
+        return;
+    }
+    int32_t err = reported.value - exact.value;
+    double pct = exact.value ? 100.0 * err / exact.value : 0.0;
+    printf("%-18s %-9s %7d B @ %10.0f us %7d B  %+5d B (%+.1f%%)\n", metric, mode, exact.value,
+           exact.cycle * us_per_cycle, reported.value, err, pct);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string elf;
+    std::string limit_text = "5s";
+    std::string until_phase;
+    int32_t tolerance = -1;
+    bool echo = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-c" || arg == "-t") && i + 1 < argc) {
+            limit_text = argv[++i];
+        } else if (arg == "--until-phase" && i + 1 < argc) {
+            until_phase = argv[++i];
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            tolerance = atoi(argv[++i]);
+        } else if (arg == "--echo") {
+            echo = true;
+        } else if (arg == "-h" || arg == "--help") {
+            fprintf(stderr, "usage: memtruth [-c cycles|-t time] [--until-phase name] "
+                            "[--tolerance bytes] [--echo] firmware.elf\n");
+            return 2;
+        } else {
+            elf = arg;
+        }
+    }
+    if (elf.empty()) {
+        fprintf(stderr, "memtruth: firmware ELF required\n");
+        return 2;
+    }
+
+    memsim::Simulation sim;
+    if (sim.open(elf) != 0) {
+        fprintf(stderr, "memtruth: %s\n", sim.error().c_str());
+        return 1;
+    }
+    uint64_t limit;
+    if (!memsim::parse_cycles(limit_text, sim.frequency(), &limit)) {
+        fprintf(stderr, "memtruth: bad run length '%s'\n", limit_text.c_str());
+        return 2;
+    }
+    sim.set_echo(echo);
+
+    uint16_t heap_start = sim.data_symbol("__heap_start");
+
+    // UART-reported values
+    Reported uart;
+    bool done = false;
+    sim.on_line([&](uint64_t cycle, const std::string& line) {
+        int32_t v;
+        if (field(line, "Stack Peak:", &v)) {
+            uart.stack_peak.max(v, cycle);
+        } else if (field(line, "Free RAM:", &v)) {
+            uart.free_ram.min(v, cycle);
+        } else if (field(line, "Heap Used:", &v)) {
+            uart.heap_used.max(v, cycle);
+        } else if (!until_phase.empty() && line == "[PHASE] " + until_phase) {
+            done = true;
+        }
+    });
+
+    // Exact values, sampled after every instruction
+    Extreme exact_stack;
+    Extreme exact_gap;
+    Extreme exact_heap;
+    Reported sampled;
+    memsim::MailboxSnapshot last;
+    bool have_mailbox = false;
+    uint16_t last_gen = 0;
+    uint64_t publishes = 0;
+
+    while (!done && sim.cycle() < limit) {
+        if (!sim.step()) {
+            break;
+        }
+        uint64_t now = sim.cycle();
+        uint16_t sp = sim.sp();
+        uint16_t heap_end = sim.heap_end();
+
+        exact_stack.max(memsim::kRamEnd - sp, now);
+        exact_gap.min((int32_t)sp - (int32_t)heap_end, now);
+        exact_heap.max(heap_end - heap_start, now);
+
+        uint16_t gen = sim.mailbox_generation();
+        if (gen != last_gen && !(gen & 1) && sim.read_mailbox(&last)) {
+            last_gen = gen;
+            have_mailbox = true;
+            publishes++;
+            sampled.stack_peak.max(last.current_stack_usage, now);
+            sampled.free_ram.min(last.free_ram, now);
+            sampled.heap_used.max(last.heap_used, now);
+        }
+    }
+
+    double us_per_cycle = 1e6 / sim.frequency();
+    printf("memtruth: %" PRIu64 " cycles (%.3f s), %" PRIu64 " mailbox updates%s\n",
+           sim.cycle(), sim.cycle() * us_per_cycle / 1e6, publishes,
+           sim.crashed() ? ", CPU CRASHED" : "");
+    printf("%-18s %-9s %9s %16s %9s  %s\n", "metric", "mode", "exact", "at", "reported",
+           "error");
+
+    Extreme sentinel;
+    if (have_mailbox) {
+        sentinel.max(last.max_stack_usage, sim.cycle());
+    }
+    print_row("stack peak", "sentinel", exact_stack, sentinel, us_per_cycle);
+    print_row("stack peak", "sampled", exact_stack, sampled.stack_peak, us_per_cycle);
+    print_row("stack peak", "uart", exact_stack, uart.stack_peak, us_per_cycle);
+    print_row("min heap/stack gap", "sampled", exact_gap, sampled.free_ram, us_per_cycle);
+    print_row("min heap/stack gap", "uart", exact_gap, uart.free_ram, us_per_cycle);
+    // heap_used counts payload only (chunk bytes in MEM_TRACK_HEADER
+    // builds); the exact value is the break, including chunk headers and
+    // free-list holes, so the difference is overhead
+    print_row("heap high-water", "sampled", exact_heap, sampled.heap_used, us_per_cycle);
+    print_row("heap high-water", "uart", exact_heap, uart.heap_used, us_per_cycle);
+
+    if (tolerance >= 0) {
+        if (!sentinel.seen) {
+            fprintf(stderr, "memtruth: no mailbox data to check\n");
+            return 1;
+        }
+        int32_t err = sentinel.value - exact_stack.value;
+        if (err < -tolerance || err > tolerance) {
+            fprintf(stderr, "memtruth: sentinel stack peak off by %d B (tolerance %d B)\n", err,
+                    tolerance);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,281 @@
+/**
+ * @file sim_common.cpp
+ * @brief simavr setup, memory access and UART capture
+ */
+
+#include "sim_common.h"
+
+#include <simavr/avr_uart.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/sim_irq.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace memsim {
+
+// AVR GDB/ELF address spaces: SRAM symbols live at 0x800000 + address
+static const uint64_t kDataOffset = 0x800000;
+
+static const uint32_t kDefaultFrequency = 16000000;
+
+// Mailbox layout offsets (MemoryMailbox in memory_monitor.h, version 1)
+static const uint16_t kMailboxMagic = 0x4D4D;
+static const uint8_t kMailboxVersion = 1;
+static const uint16_t kMailboxDefaultAddr = 0x0100;
+
+Simulation::Simulation()
+    : avr_(nullptr), brkval_(0), heap_start_(0), mailbox_(0), echo_(false),
+      call_active_(false), call_sp_(0), call_pc_(0), call_result_(0) {}
+
+Simulation::~Simulation() {
+    if (avr_) {
+        avr_terminate(avr_);
+    }
+}
+
+int Simulation::open(const std::string& elf_path, const char* mcu) {
+    if (symbols_.load(elf_path) != 0) {
+        error_ = symbols_.error();
+        return -1;
+    }
+
+    elf_firmware_t fw;
+    memset(&fw, 0, sizeof(fw));
+    if (elf_read_firmware(elf_path.c_str(), &fw) != 0) {
+        error_ = "simavr cannot load " + elf_path;
+        return -1;
+    }
+    avr_ = avr_make_mcu_by_name(fw.mmcu[0] ? fw.mmcu : mcu);
+    if (!avr_) {
+        error_ = std::string("simavr has no model for ") + mcu;
+        return -1;
+    }
+    avr_init(avr_);
+    avr_load_firmware(avr_, &fw);
+    if (!avr_->frequency) {
+        avr_->frequency = fw.frequency ? fw.frequency : kDefaultFrequency;
+    }
+
+    // Take UART0 output ourselves instead of simavr's console dump
+    uint32_t flags = 0;
+    avr_ioctl(avr_, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+    flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(avr_, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+    avr_irq_t* tx = avr_io_getirq(avr_, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT);
+    if (tx) {
+        avr_irq_register_notify(tx, uart_notify, this);
+    }
+
+    brkval_ = data_symbol("__brkval");
+    heap_start_ = data_symbol("__heap_start");
+    mailbox_ = data_symbol("mem_mailbox");
+    if (!mailbox_) {
+        mailbox_ = kMailboxDefaultAddr;
+    }
+    if (!brkval_ || !heap_start_) {
+        error_ = elf_path + ": __brkval/__heap_start not found (heap not linked?)";
+        return -1;
+    }
+    return 0;
+}
+
+void Simulation::uart_notify(avr_irq_t* irq, uint32_t value, void* param) {
+    (void)irq;
+    Simulation* sim = (Simulation*)param;
+    char c = (char)value;
+    if (sim->echo_) {
+        fputc(c, stdout);
+    }
+    if (c == '\n') {
+        if (!sim->line_.empty() && sim->line_.back() == '\r') {
+            sim->line_.pop_back();
+        }
+        if (sim->line_handler_) {
+            sim->line_handler_(sim->cycle(), sim->line_);
+        }
+        sim->line_.clear();
+    } else {
+        sim->line_ += c;
+    }
+}
+
+bool Simulation::step() {
+    int state = avr_run(avr_);
+    if (call_active_ && avr_->pc == call_pc_ && sp() == call_sp_) {
+        end_call();
+    }
+    return state != cpu_Done && state != cpu_Crashed;
+}
+
+// ============================================================================
+// FORCED CALLS
+// ============================================================================
+
+bool Simulation::begin_call(uint32_t func, uint16_t arg, bool keep_interrupts) {
+    if (call_active_) {
+        return false;
+    }
+    memcpy(call_regs_, avr_->data, sizeof(call_regs_));
+    memcpy(call_sreg_, avr_->sreg, sizeof(call_sreg_));
+    call_sp_ = sp();
+    call_pc_ = avr_->pc;
+    call_active_ = true;
+
+    // CALL pushes the word address of the next instruction, low byte first
+    uint16_t ret = (uint16_t)(call_pc_ >> 1);
+    uint16_t s = call_sp_;
+    write8(s--, (uint8_t)ret);
+    write8(s--, (uint8_t)(ret >> 8));
+    set_sp(s);
+
+    avr_->data[24] = (uint8_t)arg;
+    avr_->data[25] = (uint8_t)(arg >> 8);
+    avr_->data[1] = 0;             // avr-gcc ABI: r1 is always zero on entry
+    if (!keep_interrupts) {
+        avr_->sreg[S_I] = 0;
+    }
+    avr_->pc = func;
+    return true;
+}
+
+void Simulation::end_call() {
+    call_result_ = (uint16_t)(avr_->data[24] | (avr_->data[25] << 8));
+    memcpy(avr_->data, call_regs_, sizeof(call_regs_));
+    memcpy(avr_->sreg, call_sreg_, sizeof(call_sreg_));
+    call_active_ = false;
+}
+
+uint64_t Simulation::cycle() const {
+    return avr_->cycle;
+}
+
+uint32_t Simulation::pc() const {
+    return avr_->pc;
+}
+
+uint32_t Simulation::frequency() const {
+    return avr_->frequency;
+}
+
+bool Simulation::crashed() const {
+    return avr_->state == cpu_Crashed;
+}
+
+uint16_t Simulation::sp() const {
+    return (uint16_t)(avr_->data[R_SPL] | (avr_->data[R_SPH] << 8));
+}
+
+void Simulation::set_sp(uint16_t value) {
+    avr_->data[R_SPL] = (uint8_t)value;
+    avr_->data[R_SPH] = (uint8_t)(value >> 8);
+}
+
+uint8_t Simulation::interrupts_enabled() const {
+    return avr_->sreg[S_I];
+}
+
+uint8_t Simulation::read8(uint16_t addr) const {
+    return addr <= avr_->ramend ? avr_->data[addr] : 0;
+}
+
+uint16_t Simulation::read16(uint16_t addr) const {
+    return (uint16_t)(read8(addr) | (read8(addr + 1) << 8));
+}
+
+void Simulation::write8(uint16_t addr, uint8_t value) {
+    if (addr <= avr_->ramend) {
+        avr_->data[addr] = value;
+    }
+}
+
+void Simulation::write16(uint16_t addr, uint16_t value) {
+    write8(addr, (uint8_t)value);
+    write8(addr + 1, (uint8_t)(value >> 8));
+}
+
+uint16_t Simulation::data_symbol(const char* name) const {
+    memsym::SymbolInfo info;
+    if (!symbols_.lookup(name, &info) || info.addr < kDataOffset) {
+        return 0;
+    }
+    return (uint16_t)(info.addr - kDataOffset);
+}
+
+uint32_t Simulation::code_symbol(const char* name) const {
+    memsym::SymbolInfo info;
+    if (!symbols_.lookup(name, &info) || info.addr >= kDataOffset) {
+        return 0;
+    }
+    return (uint32_t)info.addr;
+}
+
+uint16_t Simulation::heap_end() const {
+    uint16_t brk = read16(brkval_);
+    return brk ? brk : heap_start_;
+}
+
+uint16_t Simulation::mailbox_generation() const {
+    return read16(mailbox_ + 4);
+}
+
+bool Simulation::read_mailbox(MailboxSnapshot* out) const {
+    if (read16(mailbox_) != kMailboxMagic || read8(mailbox_ + 2) != kMailboxVersion) {
+        return false;
+    }
+    // The simulation is stopped between instructions; only a torn update
+    // (odd generation) has to be rejected
+    uint16_t gen = mailbox_generation();
+    if (gen & 1) {
+        return false;
+    }
+
+    uint16_t p = mailbox_ + 6;
+    out->generation = gen;
+    out->total_sram = read16(p + 0);
+    out->static_data = read16(p + 2);
+    out->static_bss = read16(p + 4);
+    out->heap_used = read16(p + 6);
+    out->heap_total_allocated = read16(p + 8);
+    out->heap_total_freed = read16(p + 10);
+    out->alloc_count = read16(p + 12);
+    out->free_count = read16(p + 14);
+    out->current_stack_usage = read16(p + 16);
+    out->max_stack_usage = read16(p + 18);
+    out->free_ram = read16(p + 20);
+    uint32_t frag = (uint32_t)read16(p + 22) | ((uint32_t)read16(p + 24) << 16);
+    memcpy(&out->fragmentation_ratio, &frag, sizeof(frag));
+    out->collision_warning = read8(p + 26);
+    out->alloc_table = read16(p + 27);
+    out->alloc_table_len = read8(p + 29);
+    out->alloc_entry_size = read8(p + 30);
+    return true;
+}
+
+bool parse_cycles(const std::string& text, uint32_t frequency, uint64_t* cycles) {
+    char* end = nullptr;
+    double v = strtod(text.c_str(), &end);
+    if (end == text.c_str() || v < 0) {
+        return false;
+    }
+    std::string unit(end);
+    double scale;
+    if (unit.empty()) {
+        scale = 1.0;
+    } else if (unit == "s") {
+        scale = frequency;
+    } else if (unit == "ms") {
+        scale = frequency / 1e3;
+    } else if (unit == "us") {
+        scale = frequency / 1e6;
+    } else {
+        return false;
+    }
+    *cycles = (uint64_t)(v * scale + 0.5);
+    return true;
+}
+
+} // namespace memsim
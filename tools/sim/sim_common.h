@@ -0,0 +1,175 @@
+/**
+ * @file sim_common.h
+ * @brief Shared simavr harness for the host-side simulation tools
+ *
+ * Loads build/memory_monitor.elf into an ATmega328P model, steps it one
+ * instruction at a time and gives tools direct access to SRAM, SP and the
+ * firmware's symbols (resolved with the native symbolizer). UART output is
+ * collected line by line so tools can react to "[PHASE]" markers and
+ * diagnostics without a serial port.
+ */
+
+#ifndef MEMSIM_SIM_COMMON_H
+#define MEMSIM_SIM_COMMON_H
+
+#include "../symbolizer/symbolizer.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+struct avr_t;
+struct avr_irq_t;
+
+namespace memsim {
+
+// ATmega328P SRAM bounds (data addresses)
+const uint16_t kSramStart = 0x0100;
+const uint16_t kRamEnd = 0x08FF;
+
+/**
+ * @brief Host view of the firmware's MemoryMailbox (see memory_monitor.h)
+ */
+struct MailboxSnapshot {
+    uint16_t generation;
+    uint16_t total_sram;
+    uint16_t static_data;
+    uint16_t static_bss;
+    uint16_t heap_used;
+    uint16_t heap_total_allocated;
+    uint16_t heap_total_freed;
+    uint16_t alloc_count;
+    uint16_t free_count;
+    uint16_t current_stack_usage;
+    uint16_t max_stack_usage;
+    uint16_t free_ram;
+    float fragmentation_ratio;
+    uint8_t collision_warning;
+    uint16_t alloc_table;
+    uint8_t alloc_table_len;
+    uint8_t alloc_entry_size;
+};
+
+class Simulation {
+public:
+    typedef std::function<void(uint64_t cycle, const std::string& line)> LineHandler;
+
+    Simulation();
+    ~Simulation();
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    /**
+     * @brief Load the firmware and reset the MCU model
+     * @return 0 on success
+     */
+    int open(const std::string& elf_path, const char* mcu = "atmega328p");
+
+    /**
+     * @brief Execute one instruction (or one sleep period)
+     * @return false once the core has stopped or crashed
+     */
+    bool step();
+
+    avr_t* avr() { return avr_; }
+    uint64_t cycle() const;
+    uint32_t pc() const;           // Flash byte address
+    uint32_t frequency() const;
+    bool crashed() const;
+
+    uint16_t sp() const;
+    void set_sp(uint16_t sp);
+    uint8_t interrupts_enabled() const;
+    uint8_t read8(uint16_t addr) const;
+    uint16_t read16(uint16_t addr) const;
+    void write8(uint16_t addr, uint8_t value);
+    void write16(uint16_t addr, uint16_t value);
+
+    /**
+     * @brief Call a firmware function at the current instruction boundary
+     * @param func Flash byte address of the function
+     * @param arg First argument (r25:r24)
+     * @param keep_interrupts Leave the I flag as it is instead of clearing it
+     * @return false if another forced call is still running
+     * 
+     * Registers, SREG, SP and PC are saved and a return address pointing at
+     * the interrupted instruction is pushed. Unless keep_interrupts is set,
+     * interrupts stay disabled for the duration of the call. step()
+     * restores the interrupted context as soon as the function has returned.
+     */
+    bool begin_call(uint32_t func, uint16_t arg, bool keep_interrupts = false);
+    bool in_call() const { return call_active_; }
+
+    /**
+     * @brief r25:r24 of the last completed forced call (return value)
+     */
+    uint16_t call_result() const { return call_result_; }
+
+    /**
+     * @brief SRAM (data) address of a firmware symbol
+     * @return 0 if the ELF has no such symbol
+     */
+    uint16_t data_symbol(const char* name) const;
+
+    /**
+     * @brief Flash byte address of a firmware function
+     * @return 0 if the ELF has no such symbol
+     */
+    uint32_t code_symbol(const char* name) const;
+
+    const memsym::Symbolizer& symbols() const { return symbols_; }
+
+    /**
+     * @brief Current heap end (__brkval, or __heap_start before first malloc)
+     */
+    uint16_t heap_end() const;
+
+    /**
+     * @brief Read a consistent mailbox copy
+     * @return false if the mailbox is not initialized or mid-update
+     */
+    bool read_mailbox(MailboxSnapshot* out) const;
+    uint16_t mailbox_generation() const;
+
+    /**
+     * @brief Called for every complete UART line (without line terminator)
+     */
+    void on_line(LineHandler handler) { line_handler_ = handler; }
+
+    /**
+     * @brief Copy UART output to stdout as it arrives
+     */
+    void set_echo(bool echo) { echo_ = echo; }
+
+    const std::string& error() const { return error_; }
+
+private:
+    static void uart_notify(avr_irq_t* irq, uint32_t value, void* param);
+    void end_call();
+
+    avr_t* avr_;
+    memsym::Symbolizer symbols_;
+    uint16_t brkval_;
+    uint16_t heap_start_;
+    uint16_t mailbox_;
+    std::string line_;
+    LineHandler line_handler_;
+    bool echo_;
+    bool call_active_;
+    uint8_t call_regs_[32];
+    uint8_t call_sreg_[8];
+    uint16_t call_sp_;
+    uint32_t call_pc_;
+    uint16_t call_result_;
+    std::string error_;
+};
+
+/**
+ * @brief Parse a cycle count or duration ("80000000", "5s", "250ms")
+ * @return false on malformed input
+ */
+bool parse_cycles(const std::string& text, uint32_t frequency, uint64_t* cycles);
+
+} // namespace memsim
+
+#endif // MEMSIM_SIM_COMMON_H
@@ -0,0 +1,451 @@
+/**
+ * @file dwarf_line.cpp
+ * @brief DWARF line-number program interpreter
+ */
+
+#include "dwarf_line.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace memsym {
+
+// ============================================================================
+// BYTE CURSOR
+// ============================================================================
+
+namespace {
+
+struct Cursor {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok;
+
+    Cursor(const uint8_t* begin, const uint8_t* limit) : p(begin), end(limit), ok(true) {}
+
+    bool need(size_t n) {
+        if (!ok || (size_t)(end - p) < n) {
+            ok = false;
+            p = end;
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t fixed(size_t n) {
+        if (!need(n)) {
+            return 0;
+        }
+        uint64_t v = 0;
+        for (size_t i = 0; i < n; i++) {
+            v |= (uint64_t)p[i] << (8 * i);
+        }
+        p += n;
+        return v;
+    }
+
+    uint8_t u8() { return (uint8_t)fixed(1); }
+    uint16_t u16() { return (uint16_t)fixed(2); }
+    uint32_t u32() { return (uint32_t)fixed(4); }
+    uint64_t u64() { return fixed(8); }
+
+    uint64_t uleb() {
+        uint64_t v = 0;
+        unsigned shift = 0;
+        while (need(1)) {
+            uint8_t b = *p++;
+            if (shift < 64) {
+                v |= (uint64_t)(b & 0x7F) << shift;
+            }
+            shift += 7;
+            if (!(b & 0x80)) {
+                break;
+            }
+        }
+        return v;
+    }
+
+    int64_t sleb() {
+        int64_t v = 0;
+        unsigned shift = 0;
+        uint8_t b = 0;
+        while (need(1)) {
+            b = *p++;
+            if (shift < 64) {
+                v |= (int64_t)(b & 0x7F) << shift;
+            }
+            shift += 7;
+            if (!(b & 0x80)) {
+                break;
+            }
+        }
+        if (shift < 64 && (b & 0x40)) {
+            v |= -((int64_t)1 << shift);
+        }
+        return v;
+    }
+
+    const char* cstr() {
+        const uint8_t* nul = (const uint8_t*)memchr(p, 0, (size_t)(end - p));
+        if (!ok || !nul) {
+            ok = false;
+            p = end;
+            return "";
+        }
+        const char* s = (const char*)p;
+        p = nul + 1;
+        return s;
+    }
+
+    void skip(uint64_t n) {
+        if (need((size_t)n)) {
+            p += n;
+        }
+    }
+};
+
+struct StringSection {
+    const char* data = nullptr;
+    uint64_t size = 0;
+
+    const char* at(uint64_t off) const {
+        return (data && off < size) ? data + off : "";
+    }
+};
+
+// DW_FORM_* values that appear in v5 directory/file entry formats
+enum {
+    kFormBlock2 = 0x03, kFormBlock4 = 0x04, kFormData2 = 0x05, kFormData4 = 0x06,
+    kFormData8 = 0x07, kFormString = 0x08, kFormBlock = 0x09, kFormBlock1 = 0x0a,
+    kFormData1 = 0x0b, kFormSdata = 0x0d, kFormStrp = 0x0e, kFormUdata = 0x0f,
+    kFormData16 = 0x1e, kFormLineStrp = 0x1f,
+};
+
+// DW_LNCT_* content types
+enum { kLnctPath = 1, kLnctDirectoryIndex = 2 };
+
+/**
+ * @brief Read one attribute value of a v5 entry format
+ * @return false for forms this decoder does not understand
+ */
+bool read_form(Cursor& c, uint64_t form, bool dwarf64, const StringSection& str,
+               const StringSection& line_str, std::string* text, uint64_t* number) {
+    switch (form) {
+    case kFormString:
+        *text = c.cstr();
+        return true;
+    case kFormStrp:
+        *text = str.at(dwarf64 ? c.u64() : c.u32());
+        return true;
+    case kFormLineStrp:
+        *text = line_str.at(dwarf64 ? c.u64() : c.u32());
+        return true;
+    case kFormData1:
+        *number = c.u8();
+        return true;
+    case kFormData2:
+        *number = c.u16();
+        return true;
+    case kFormData4:
+        *number = c.u32();
+        return true;
+    case kFormData8:
+        *number = c.u64();
+        return true;
+    case kFormData16:
+        c.skip(16);
+        return true;
+    case kFormUdata:
+        *number = c.uleb();
+        return true;
+    case kFormSdata:
+        *number = (uint64_t)c.sleb();
+        return true;
+    case kFormBlock:
+        c.skip(c.uleb());
+        return true;
+    case kFormBlock1:
+        c.skip(c.u8());
+        return true;
+    case kFormBlock2:
+        c.skip(c.u16());
+        return true;
+    case kFormBlock4:
+        c.skip(c.u32());
+        return true;
+    default:
+        return false;
+    }
+}
+
+struct EntryFormat {
+    uint64_t content;
+    uint64_t form;
+};
+
+/**
+ * @brief Read a v5 directory or file name table
+ * @return false on unknown forms or truncated data
+ */
+bool read_entry_table(Cursor& c, bool dwarf64, const StringSection& str,
+                      const StringSection& line_str,
+                      std::vector<std::pair<std::string, uint64_t>>* entries) {
+    uint8_t format_count = c.u8();
+    std::vector<EntryFormat> formats;
+    for (uint8_t i = 0; i < format_count; i++) {
+        EntryFormat f;
+        f.content = c.uleb();
+        f.form = c.uleb();
+        formats.push_back(f);
+    }
+
+    uint64_t count = c.uleb();
+    for (uint64_t i = 0; i < count && c.ok; i++) {
+        std::string path;
+        uint64_t dir = 0;
+        for (const EntryFormat& f : formats) {
+            std::string text;
+            uint64_t number = 0;
+            if (!read_form(c, f.form, dwarf64, str, line_str, &text, &number)) {
+                return false;
+            }
+            if (f.content == kLnctPath) {
+                path = text;
+            } else if (f.content == kLnctDirectoryIndex) {
+                dir = number;
+            }
+        }
+        entries->push_back(std::make_pair(path, dir));
+    }
+    return c.ok;
+}
+
+std::string join_path(const std::string& dir, const std::string& name) {
+    if (dir.empty() || name.empty() || name[0] == '/') {
+        return name;
+    }
+    return dir + "/" + name;
+}
+
+} // namespace
+
+// ============================================================================
+// LINE PROGRAM
+// ============================================================================
+
+int read_line_table(const ElfFile& elf, LineTable* out, std::string* error) {
+    out->rows.clear();
+    out->files.clear();
+
+    const ElfSection* line_sec = elf.section(".debug_line");
+    if (!line_sec) {
+        return 0;
+    }
+    const uint8_t* line_data = elf.data(*line_sec);
+    if (!line_data) {
+        *error = ".debug_line is not readable";
+        return -1;
+    }
+
+    StringSection str;
+    StringSection line_str;
+    if (const ElfSection* s = elf.section(".debug_str")) {
+        str.data = (const char*)elf.data(*s);
+        str.size = s->size;
+    }
+    if (const ElfSection* s = elf.section(".debug_line_str")) {
+        line_str.data = (const char*)elf.data(*s);
+        line_str.size = s->size;
+    }
+
+    std::unordered_map<std::string, uint32_t> file_ids;
+    auto intern = [&](const std::string& path) -> uint32_t {
+        auto it = file_ids.find(path);
+        if (it != file_ids.end()) {
+            return it->second;
+        }
+        uint32_t id = (uint32_t)out->files.size();
+        out->files.push_back(path);
+        file_ids[path] = id;
+        return id;
+    };
+
+    Cursor units(line_data, line_data + line_sec->size);
+    while (units.p < units.end && units.ok) {
+        // Unit header
+        uint64_t unit_length = units.u32();
+        bool dwarf64 = false;
+        if (unit_length == 0xFFFFFFFFu) {
+            unit_length = units.u64();
+            dwarf64 = true;
+        }
+        if (!units.need((size_t)unit_length)) {
+            break;
+        }
+        const uint8_t* unit_end = units.p + unit_length;
+        Cursor c(units.p, unit_end);
+        units.p = unit_end;
+
+        uint16_t version = c.u16();
+        if (version < 2 || version > 5) {
+            continue;
+        }
+        if (version >= 5) {
+            c.u8(); // address_size
+            c.u8(); // segment_selector_size
+        }
+        uint64_t header_length = dwarf64 ? c.u64() : c.u32();
+        if (!c.need((size_t)header_length)) {
+            continue;
+        }
+        const uint8_t* program = c.p + header_length;
+
+        uint8_t min_inst = c.u8();
+        if (version >= 4) {
+            c.u8(); // maximum_operations_per_instruction (VLIW only)
+        }
+        uint8_t default_is_stmt = c.u8();
+        int8_t line_base = (int8_t)c.u8();
+        uint8_t line_range = c.u8();
+        uint8_t opcode_base = c.u8();
+        std::vector<uint8_t> std_lengths(opcode_base > 0 ? opcode_base : 1, 0);
+        for (uint8_t i = 1; i < opcode_base; i++) {
+            std_lengths[i] = c.u8();
+        }
+        (void)default_is_stmt;
+        if (line_range == 0) {
+            continue;
+        }
+
+        // File table: global ids for this unit's file indices
+        std::vector<uint32_t> unit_files;
+        if (version >= 5) {
+            std::vector<std::pair<std::string, uint64_t>> dirs;
+            std::vector<std::pair<std::string, uint64_t>> files;
+            if (!read_entry_table(c, dwarf64, str, line_str, &dirs) ||
+                !read_entry_table(c, dwarf64, str, line_str, &files)) {
+                continue;
+            }
+            for (const auto& f : files) {
+                std::string dir = f.second < dirs.size() ? dirs[f.second].first : "";
+                unit_files.push_back(intern(join_path(dir, f.first)));
+            }
+        } else {
+            std::vector<std::string> dirs(1); // Index 0 = compilation directory
+            for (;;) {
+                const char* d = c.cstr();
+                if (!c.ok || *d == '\0') {
+                    break;
+                }
+                dirs.push_back(d);
+            }
+            unit_files.push_back(intern("")); // File indices start at 1
+            for (;;) {
+                const char* name = c.cstr();
+                if (!c.ok || *name == '\0') {
+                    break;
+                }
+                uint64_t dir = c.uleb();
+                c.uleb(); // mtime
+                c.uleb(); // length
+                std::string d = (dir > 0 && dir < dirs.size()) ? dirs[dir] : "";
+                unit_files.push_back(intern(join_path(d, name)));
+            }
+        }
+        if (!c.ok) {
+            continue;
+        }
+
+        // State machine
+        c.p = program;
+        uint64_t address = 0;
+        uint64_t file = 1;
+        uint64_t line = 1;
+        std::vector<LineRow> sequence;
+
+        auto emit = [&](bool end_sequence) {
+            LineRow row;
+            row.addr = address;
+            row.line = (uint32_t)line;
+            row.file = end_sequence ? UINT32_MAX
+                       : (file < unit_files.size() ? unit_files[file] : intern(""));
+            sequence.push_back(row);
+            if (end_sequence) {
+                // Sections dropped by --gc-sections keep address 0; skip them
+                if (!sequence.empty() && sequence.front().addr != 0) {
+                    out->rows.insert(out->rows.end(), sequence.begin(), sequence.end());
+                }
+                sequence.clear();
+                address = 0;
+                file = 1;
+                line = 1;
+            }
+        };
+
+        while (c.p < c.end && c.ok) {
+            uint8_t op = c.u8();
+            if (op >= opcode_base) {
+                // Special opcode: advance address and line, append a row
+                uint8_t adj = op - opcode_base;
+                address += (uint64_t)(adj / line_range) * min_inst;
+                line += (int64_t)line_base + (adj % line_range);
+                emit(false);
+                continue;
+            }
+
+            switch (op) {
+            case 0: { // Extended opcode
+                uint64_t len = c.uleb();
+                if (len == 0 || !c.need((size_t)len)) {
+                    break;
+                }
+                const uint8_t* next = c.p + len;
+                uint8_t sub = c.u8();
+                if (sub == 1) {        // DW_LNE_end_sequence
+                    emit(true);
+                } else if (sub == 2) { // DW_LNE_set_address
+                    address = c.fixed((size_t)(len - 1 > 8 ? 8 : len - 1));
+                }
+                c.p = next;            // define_file, set_discriminator, vendor ops
+                break;
+            }
+            case 1: // DW_LNS_copy
+                emit(false);
+                break;
+            case 2: // DW_LNS_advance_pc
+                address += c.uleb() * min_inst;
+                break;
+            case 3: // DW_LNS_advance_line
+                line += c.sleb();
+                break;
+            case 4: // DW_LNS_set_file
+                file = c.uleb();
+                break;
+            case 8: // DW_LNS_const_add_pc
+                address += (uint64_t)((255 - opcode_base) / line_range) * min_inst;
+                break;
+            case 9: // DW_LNS_fixed_advance_pc
+                address += c.u16();
+                break;
+            default:
+                // Column, stmt, basic block, prologue/epilogue, ISA, unknown
+                for (uint8_t i = 0; i < std_lengths[op]; i++) {
+                    c.uleb();
+                }
+                break;
+            }
+        }
+    }
+
+    // Terminators sort before rows starting at the same address
+    std::stable_sort(out->rows.begin(), out->rows.end(), [](const LineRow& a, const LineRow& b) {
+        if (a.addr != b.addr) {
+            return a.addr < b.addr;
+        }
+        return a.file == UINT32_MAX && b.file != UINT32_MAX;
+    });
+    return 0;
+}
+
+} // namespace memsym
@@ -0,0 +1,41 @@
+/**
+ * @file dwarf_line.h
+ * @brief DWARF .debug_line decoder (versions 2 - 5)
+ *
+ * Runs every line-number program in the ELF and flattens the result into
+ * address-sorted rows. Only what address-to-line lookup needs is kept:
+ * address, line and file; sequence ends are kept as terminator rows so gaps
+ * between functions do not resolve to the previous line.
+ */
+
+#ifndef MEMSYM_DWARF_LINE_H
+#define MEMSYM_DWARF_LINE_H
+
+#include "elf_file.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace memsym {
+
+struct LineRow {
+    uint64_t addr;
+    uint32_t line;
+    uint32_t file;         // Index into LineTable::files; UINT32_MAX = end of sequence
+};
+
+struct LineTable {
+    std::vector<LineRow> rows;          // Sorted by address
+    std::vector<std::string> files;     // De-duplicated path names
+};
+
+/**
+ * @brief Decode .debug_line of an ELF file
+ * @return 0 on success (an ELF without debug info yields an empty table)
+ */
+int read_line_table(const ElfFile& elf, LineTable* out, std::string* error);
+
+} // namespace memsym
+
+#endif // MEMSYM_DWARF_LINE_H
@@ -0,0 +1,216 @@
+/**
+ * @file elf_file.cpp
+ * @brief ELF section, symbol and build ID decoding
+ */
+
+#include "elf_file.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace memsym {
+
+template <typename T>
+static T load(const uint8_t* p) {
+    T v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+ElfFile::ElfFile() : base_(nullptr), size_(0), is64_(false), machine_(0) {}
+
+ElfFile::~ElfFile() {
+    close();
+}
+
+void ElfFile::close() {
+    if (base_) {
+        munmap((void*)base_, size_);
+    }
+    base_ = nullptr;
+    size_ = 0;
+    sections_.clear();
+}
+
+int ElfFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = "cannot open " + path;
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 16) {
+        ::close(fd);
+        error_ = path + ": not an ELF file";
+        return -1;
+    }
+    void* map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        error_ = "cannot map " + path;
+        return -1;
+    }
+    base_ = (const uint8_t*)map;
+    size_ = (size_t)st.st_size;
+
+    // e_ident: magic, class (1 = 32-bit, 2 = 64-bit), data (1 = little-endian)
+    if (memcmp(base_, "\x7f" "ELF", 4) != 0 || base_[5] != 1 ||
+        (base_[4] != 1 && base_[4] != 2)) {
+        error_ = path + ": not a little-endian ELF file";
+        close();
+        return -1;
+    }
+    is64_ = base_[4] == 2;
+    if (size_ < (is64_ ? 64u : 52u)) {
+        error_ = path + ": truncated ELF header";
+        close();
+        return -1;
+    }
+    machine_ = load<uint16_t>(base_ + 18);
+
+    uint64_t shoff = is64_ ? load<uint64_t>(base_ + 40) : load<uint32_t>(base_ + 32);
+    uint16_t shentsize = load<uint16_t>(base_ + (is64_ ? 58 : 46));
+    uint16_t shnum = load<uint16_t>(base_ + (is64_ ? 60 : 48));
+    uint16_t shstrndx = load<uint16_t>(base_ + (is64_ ? 62 : 50));
+    if (shentsize < (is64_ ? 64 : 40) || shoff > size_ ||
+        (uint64_t)shnum * shentsize > size_ - shoff || shstrndx >= shnum) {
+        error_ = path + ": corrupt section header table";
+        close();
+        return -1;
+    }
+
+    std::vector<uint32_t> name_offs;
+    for (uint16_t i = 0; i < shnum; i++) {
+        const uint8_t* sh = base_ + shoff + (uint64_t)i * shentsize;
+        ElfSection sec;
+        uint32_t name_off = load<uint32_t>(sh);
+        sec.type = load<uint32_t>(sh + 4);
+        if (is64_) {
+            sec.flags = load<uint64_t>(sh + 8);
+            sec.addr = load<uint64_t>(sh + 16);
+            sec.offset = load<uint64_t>(sh + 24);
+            sec.size = load<uint64_t>(sh + 32);
+            sec.link = load<uint32_t>(sh + 40);
+            sec.entsize = load<uint64_t>(sh + 56);
+        } else {
+            sec.flags = load<uint32_t>(sh + 8);
+            sec.addr = load<uint32_t>(sh + 12);
+            sec.offset = load<uint32_t>(sh + 16);
+            sec.size = load<uint32_t>(sh + 20);
+            sec.link = load<uint32_t>(sh + 24);
+            sec.entsize = load<uint32_t>(sh + 36);
+        }
+        name_offs.push_back(name_off);
+        sections_.push_back(sec);
+    }
+
+    const ElfSection& shstr = sections_[shstrndx];
+    for (size_t i = 0; i < sections_.size(); i++) {
+        uint64_t off = shstr.offset + name_offs[i];
+        if (off < size_) {
+            const char* name = (const char*)base_ + off;
+            sections_[i].name.assign(name, strnlen(name, size_ - off));
+        }
+    }
+    return 0;
+}
+
+const ElfSection* ElfFile::section(const char* name) const {
+    for (const ElfSection& sec : sections_) {
+        if (sec.name == name) {
+            return &sec;
+        }
+    }
+    return nullptr;
+}
+
+const uint8_t* ElfFile::data(const ElfSection& sec) const {
+    if (sec.type == kShtNobits || sec.offset > size_ || sec.size > size_ - sec.offset) {
+        return nullptr;
+    }
+    return base_ + sec.offset;
+}
+
+std::vector<ElfSymbol> ElfFile::symbols() const {
+    std::vector<ElfSymbol> out;
+    for (const ElfSection& sec : sections_) {
+        if (sec.type != kShtSymtab || sec.link >= sections_.size()) {
+            continue;
+        }
+        const uint8_t* syms = data(sec);
+        const ElfSection& strsec = sections_[sec.link];
+        const char* strtab = (const char*)data(strsec);
+        if (!syms || !strtab) {
+            continue;
+        }
+
+        size_t entsize = sec.entsize ? (size_t)sec.entsize : (is64_ ? 24 : 16);
+        for (size_t off = entsize; off + entsize <= sec.size; off += entsize) {
+            const uint8_t* s = syms + off;
+            ElfSymbol sym;
+            uint32_t name_off = load<uint32_t>(s);
+            uint8_t info;
+            if (is64_) {
+                info = s[4];
+                sym.shndx = load<uint16_t>(s + 6);
+                sym.addr = load<uint64_t>(s + 8);
+                sym.size = load<uint64_t>(s + 16);
+            } else {
+                sym.addr = load<uint32_t>(s + 4);
+                sym.size = load<uint32_t>(s + 8);
+                info = s[12];
+                sym.shndx = load<uint16_t>(s + 14);
+            }
+            if (sym.shndx == 0 || name_off >= strsec.size) {
+                continue;
+            }
+            sym.type = info & 0x0F;
+            sym.bind = info >> 4;
+            // The last name of a corrupt table may lack its terminator
+            const char* name = strtab + name_off;
+            sym.name.assign(name, strnlen(name, strsec.size - name_off));
+            out.push_back(sym);
+        }
+    }
+    return out;
+}
+
+std::string ElfFile::build_id() const {
+    const ElfSection* sec = section(".note.gnu.build-id");
+    const uint8_t* p = sec ? data(*sec) : nullptr;
+    if (!p || sec->size < 16) {
+        return std::string();
+    }
+
+    // Note header: namesz, descsz, type (3 = NT_GNU_BUILD_ID), "GNU\0", desc
+    uint32_t namesz = load<uint32_t>(p);
+    uint32_t descsz = load<uint32_t>(p + 4);
+    uint64_t desc_off = 12 + ((namesz + 3u) & ~3u);
+    if (desc_off + descsz > sec->size) {
+        return std::string();
+    }
+
+    static const char hex[] = "0123456789abcdef";
+    std::string id;
+    for (uint32_t i = 0; i < descsz; i++) {
+        id += hex[p[desc_off + i] >> 4];
+        id += hex[p[desc_off + i] & 0x0F];
+    }
+    return id;
+}
+
+uint64_t ElfFile::content_hash() const {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < size_; i++) {
+        h ^= base_[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+} // namespace memsym
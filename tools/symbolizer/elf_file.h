@@ -0,0 +1,104 @@
+/**
+ * @file elf_file.h
+ * @brief Minimal read-only ELF parser (ELF32/ELF64, little-endian)
+ *
+ * Covers what the host tools need from build/memory_monitor.elf: section
+ * headers, the symbol table and the GNU build ID. The file is memory-mapped
+ * and section contents are returned as pointers into the mapping.
+ */
+
+#ifndef MEMSYM_ELF_FILE_H
+#define MEMSYM_ELF_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace memsym {
+
+// Section types and symbol types used by the tools
+enum {
+    kShtSymtab = 2,
+    kShtNobits = 8,
+    kSttObject = 1,
+    kSttFunc = 2,
+    kEmAvr = 83,
+};
+
+struct ElfSection {
+    std::string name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t addr;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint64_t entsize;
+};
+
+struct ElfSymbol {
+    std::string name;
+    uint64_t addr;
+    uint64_t size;
+    uint8_t type;          // STT_*
+    uint8_t bind;          // STB_*
+    uint16_t shndx;        // Section index (0 = undefined)
+};
+
+class ElfFile {
+public:
+    ElfFile();
+    ~ElfFile();
+    ElfFile(const ElfFile&) = delete;
+    ElfFile& operator=(const ElfFile&) = delete;
+
+    int open(const std::string& path);
+    void close();
+
+    bool is64() const { return is64_; }
+    uint16_t machine() const { return machine_; }
+    size_t size() const { return size_; }
+
+    const std::vector<ElfSection>& sections() const { return sections_; }
+
+    /**
+     * @brief Find a section by name
+     * @return nullptr if the ELF has no such section
+     */
+    const ElfSection* section(const char* name) const;
+
+    /**
+     * @brief Contents of a section (nullptr for NOBITS or out-of-range)
+     */
+    const uint8_t* data(const ElfSection& sec) const;
+
+    /**
+     * @brief Decode .symtab (all symbol types, undefined ones skipped)
+     */
+    std::vector<ElfSymbol> symbols() const;
+
+    /**
+     * @brief Hex string of .note.gnu.build-id, or "" if the ELF has none
+     */
+    std::string build_id() const;
+
+    /**
+     * @brief 64-bit FNV-1a hash of the whole file (build ID fallback)
+     */
+    uint64_t content_hash() const;
+
+    const std::string& error() const { return error_; }
+
+private:
+    const uint8_t* base_;
+    size_t size_;
+    bool is64_;
+    uint16_t machine_;
+    std::vector<ElfSection> sections_;
+    std::string error_;
+};
+
+} // namespace memsym
+
+#endif // MEMSYM_ELF_FILE_H
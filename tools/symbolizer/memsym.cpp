@@ -0,0 +1,201 @@
+/**
+ * @file memsym.cpp
+ * @brief Command-line front end for the symbolizer
+ *
+ * Usage:
+ *   memsym -e elf [-r] [--no-cache] [addr ...]     Resolve addresses (or stdin)
+ *   memsym -e elf -s name [name ...]               Print symbol address and size
+ *   memsym -e elf --filter [log|-]                 Annotate a UART log
+ *
+ * -r treats the addresses as return addresses and resolves the CALL
+ * instruction in front of them.
+ *
+ * Filter mode copies the log to stdout and appends source locations to:
+ *   "[HEAP] A ptr size ret..."   call chains from call-site attribution
+ *   "pc=0x...."                  exact code addresses (fault records)
+ *   "ret=0x...."                 return addresses
+ */
+
+#include "symbolizer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static uint64_t parse_addr(const std::string& text, bool* ok) {
+    char* end = nullptr;
+    uint64_t v = strtoull(text.c_str(), &end, 16);
+    *ok = !text.empty() && end && *end == '\0';
+    return v;
+}
+
+/**
+ * @brief Append "<location>" after every pc=/ret= token of a line
+ */
+static std::string annotate_tokens(const memsym::Symbolizer& sym, const std::string& line) {
+    std::string out;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        size_t pc = line.find("pc=0x", pos);
+        size_t ret = line.find("ret=0x", pos);
+        size_t at = pc < ret ? pc : ret;
+        if (at == std::string::npos) {
+            break;
+        }
+        size_t value = at + (at == pc ? 3 : 4);
+        size_t end = line.find_first_of(" \t\r", value);
+        if (end == std::string::npos) {
+            end = line.size();
+        }
+        bool ok;
+        uint64_t addr = parse_addr(line.substr(value, end - value), &ok);
+        out += line.substr(pos, end - pos);
+        if (ok) {
+            out += " <" + sym.describe(at == ret && addr ? addr - 1 : addr) + ">";
+        }
+        pos = end;
+    }
+    out += line.substr(pos);
+    return out;
+}
+
+static int run_filter(const memsym::Symbolizer& sym, std::istream& in) {
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t heap = line.find("[HEAP] A ");
+        if (heap != std::string::npos) {
+            std::istringstream ev(line.substr(heap + 9));
+            std::string ptr;
+            std::string size;
+            std::string site;
+            ev >> ptr >> size;
+            std::string chain;
+            while (ev >> site) {
+                bool ok;
+                uint64_t addr = parse_addr(site, &ok);
+                if (!ok) {
+                    break;
+                }
+                chain += chain.empty() ? "  # " : " <- ";
+                chain += sym.describe(addr ? addr - 1 : 0);
+            }
+            printf("%s%s\n", line.c_str(), chain.c_str());
+        } else {
+            printf("%s\n", annotate_tokens(sym, line).c_str());
+        }
+    }
+    return 0;
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: memsym -e elf [-r] [--no-cache] [addr ...]\n"
+            "       memsym -e elf -s name [name ...]\n"
+            "       memsym -e elf --filter [log|-]\n");
+}
+
+int main(int argc, char** argv) {
+    std::string elf;
+    bool return_addrs = false;
+    bool use_cache = true;
+    bool symbols = false;
+    bool filter = false;
+    std::vector<std::string> args;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-e" && i + 1 < argc) {
+            elf = argv[++i];
+        } else if (arg == "-r") {
+            return_addrs = true;
+        } else if (arg == "-s") {
+            symbols = true;
+        } else if (arg == "--filter") {
+            filter = true;
+        } else if (arg == "--no-cache") {
+            use_cache = false;
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 2;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (elf.empty()) {
+        usage();
+        return 2;
+    }
+
+    memsym::Symbolizer sym;
+    if (sym.load(elf, use_cache) != 0) {
+        fprintf(stderr, "memsym: %s\n", sym.error().c_str());
+        return 1;
+    }
+
+    if (symbols) {
+        int missing = 0;
+        for (const std::string& name : args) {
+            memsym::SymbolInfo info;
+            if (sym.lookup(name, &info)) {
+                printf("%s 0x%llx %llu\n", name.c_str(), (unsigned long long)info.addr,
+                       (unsigned long long)info.size);
+            } else {
+                fprintf(stderr, "memsym: no symbol '%s'\n", name.c_str());
+                missing++;
+            }
+        }
+        return missing ? 1 : 0;
+    }
+
+    if (filter) {
+        if (args.empty() || args[0] == "-") {
+            return run_filter(sym, std::cin);
+        }
+        std::ifstream file(args[0]);
+        if (!file) {
+            fprintf(stderr, "memsym: cannot open %s\n", args[0].c_str());
+            return 1;
+        }
+        return run_filter(sym, file);
+    }
+
+    // Address mode: collect everything, then resolve in one batch
+    std::vector<std::string> tokens = args;
+    if (tokens.empty()) {
+        std::string tok;
+        while (std::cin >> tok) {
+            tokens.push_back(tok);
+        }
+    }
+    std::vector<uint64_t> addrs;
+    for (const std::string& tok : tokens) {
+        bool ok;
+        uint64_t a = parse_addr(tok, &ok);
+        if (!ok) {
+            fprintf(stderr, "memsym: bad address '%s'\n", tok.c_str());
+            return 2;
+        }
+        addrs.push_back(return_addrs && a ? a - 1 : a);
+    }
+
+    std::vector<memsym::Location> locs;
+    sym.resolve_batch(addrs, &locs);
+    for (size_t i = 0; i < addrs.size(); i++) {
+        const memsym::Location& loc = locs[i];
+        printf("%s %s", tokens[i].c_str(), loc.function ? loc.function : "??");
+        if (loc.function && loc.offset) {
+            printf("+0x%llx", (unsigned long long)loc.offset);
+        }
+        if (loc.file) {
+            printf(" %s:%u\n", loc.file, loc.line);
+        } else {
+            printf(" ??:0\n");
+        }
+    }
+    return 0;
+}
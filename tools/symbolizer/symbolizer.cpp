@@ -0,0 +1,395 @@
+/**
+ * @file symbolizer.cpp
+ * @brief Symbol/line table construction, lookup and on-disk cache
+ */
+
+#include "symbolizer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace memsym {
+
+static const char kCacheMagic[8] = {'M', 'E', 'M', 'S', 'Y', 'M', '\0', '\0'};
+static const uint32_t kCacheVersion = 1;
+static const uint64_t kShfExecinstr = 0x4;
+
+// ============================================================================
+// TABLE CONSTRUCTION
+// ============================================================================
+
+void Symbolizer::build(const ElfFile& elf, const LineTable& lines) {
+    names_.clear();
+    funcs_.clear();
+    symbols_.clear();
+
+    struct Candidate {
+        Func func;
+        bool typed;        // STT_FUNC (preferred over assembler labels)
+    };
+    std::vector<Candidate> candidates;
+
+    const std::vector<ElfSection>& sections = elf.sections();
+    for (const ElfSymbol& sym : elf.symbols()) {
+        if (sym.name.empty()) {
+            continue;
+        }
+        uint32_t name = (uint32_t)names_.size();
+        names_.push_back(sym.name);
+
+        Named named;
+        named.name = name;
+        named.info.addr = sym.addr;
+        named.info.size = sym.size;
+        named.info.type = sym.type;
+        symbols_.push_back(named);
+
+        // Functions, plus untyped labels in code (crt vectors, asm routines)
+        bool exec = sym.shndx < sections.size() && (sections[sym.shndx].flags & kShfExecinstr);
+        bool label = sym.type == 0 && exec && sym.name[0] != '.' && sym.name[0] != '$';
+        if (sym.type == kSttFunc || label) {
+            Candidate c;
+            c.func.addr = sym.addr;
+            c.func.size = sym.size;
+            c.func.name = name;
+            c.typed = sym.type == kSttFunc;
+            candidates.push_back(c);
+        }
+    }
+
+    // One entry per address: typed functions first, then the largest extent
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.func.addr != b.func.addr) {
+            return a.func.addr < b.func.addr;
+        }
+        if (a.typed != b.typed) {
+            return a.typed;
+        }
+        return a.func.size > b.func.size;
+    });
+    for (const Candidate& c : candidates) {
+        if (funcs_.empty() || funcs_.back().addr != c.func.addr) {
+            funcs_.push_back(c.func);
+        }
+    }
+
+    rows_ = lines.rows;
+    files_ = lines.files;
+}
+
+void Symbolizer::index_symbols() {
+    by_name_.clear();
+    for (size_t i = 0; i < symbols_.size(); i++) {
+        const std::string& name = names_[symbols_[i].name];
+        auto it = by_name_.find(name);
+        // Prefer sized definitions over same-named labels
+        if (it == by_name_.end() || symbols_[it->second].info.size == 0) {
+            by_name_[name] = i;
+        }
+    }
+}
+
+// ============================================================================
+// LOOKUP
+// ============================================================================
+
+const Symbolizer::Func* Symbolizer::func_at(size_t i, uint64_t addr) const {
+    if (i >= funcs_.size()) {
+        return nullptr;
+    }
+    const Func& f = funcs_[i];
+    // Size-0 labels extend to the next symbol
+    if (f.size != 0 && addr >= f.addr + f.size) {
+        return nullptr;
+    }
+    return &f;
+}
+
+const LineRow* Symbolizer::row_at(size_t i) const {
+    if (i >= rows_.size() || rows_[i].file == UINT32_MAX) {
+        return nullptr;
+    }
+    return &rows_[i];
+}
+
+Location Symbolizer::make_location(uint64_t addr, const Func* func,
+                                   const LineRow* row) const {
+    Location loc;
+    loc.function = func ? names_[func->name].c_str() : nullptr;
+    loc.offset = func ? addr - func->addr : 0;
+    loc.file = row ? files_[row->file].c_str() : nullptr;
+    loc.line = row ? row->line : 0;
+    return loc;
+}
+
+Location Symbolizer::resolve(uint64_t addr) const {
+    auto fit = std::upper_bound(funcs_.begin(), funcs_.end(), addr,
+                                [](uint64_t a, const Func& f) { return a < f.addr; });
+    auto rit = std::upper_bound(rows_.begin(), rows_.end(), addr,
+                                [](uint64_t a, const LineRow& r) { return a < r.addr; });
+    size_t fi = fit == funcs_.begin() ? SIZE_MAX : (size_t)(fit - funcs_.begin()) - 1;
+    size_t ri = rit == rows_.begin() ? SIZE_MAX : (size_t)(rit - rows_.begin()) - 1;
+
+    return make_location(addr, func_at(fi, addr), row_at(ri));
+}
+
+void Symbolizer::resolve_batch(const std::vector<uint64_t>& addrs,
+                               std::vector<Location>* out) const {
+    out->resize(addrs.size());
+    std::vector<uint32_t> order(addrs.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = (uint32_t)i;
+    }
+    std::sort(order.begin(), order.end(),
+              [&](uint32_t a, uint32_t b) { return addrs[a] < addrs[b]; });
+
+    // Merge sweep: both cursors only move forward
+    size_t fn = 0;
+    size_t rn = 0;
+    for (uint32_t idx : order) {
+        uint64_t addr = addrs[idx];
+        while (fn < funcs_.size() && funcs_[fn].addr <= addr) {
+            fn++;
+        }
+        while (rn < rows_.size() && rows_[rn].addr <= addr) {
+            rn++;
+        }
+        size_t fi = fn ? fn - 1 : SIZE_MAX;
+        size_t ri = rn ? rn - 1 : SIZE_MAX;
+        (*out)[idx] = make_location(addr, func_at(fi, addr), row_at(ri));
+    }
+}
+
+bool Symbolizer::lookup(const std::string& name, SymbolInfo* info) const {
+    auto it = by_name_.find(name);
+    if (it == by_name_.end()) {
+        return false;
+    }
+    *info = symbols_[it->second].info;
+    return true;
+}
+
+std::string Symbolizer::describe(uint64_t addr) const {
+    Location loc = resolve(addr);
+    char buf[64];
+    std::string text;
+    if (loc.function) {
+        text = loc.function;
+        if (loc.offset) {
+            snprintf(buf, sizeof(buf), "+0x%llx", (unsigned long long)loc.offset);
+            text += buf;
+        }
+    } else {
+        snprintf(buf, sizeof(buf), "0x%04llx", (unsigned long long)addr);
+        text = buf;
+    }
+    if (loc.file) {
+        snprintf(buf, sizeof(buf), ":%u", loc.line);
+        text += " (" + std::string(loc.file) + buf + ")";
+    }
+    return text;
+}
+
+// ============================================================================
+// CACHE
+// ============================================================================
+
+static std::string cache_dir() {
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) {
+        return std::string(xdg) + "/memsym";
+    }
+    const char* home = getenv("HOME");
+    if (home && *home) {
+        return std::string(home) + "/.cache/memsym";
+    }
+    return std::string();
+}
+
+static void make_dirs(const std::string& path) {
+    for (size_t i = 1; i <= path.size(); i++) {
+        if (i == path.size() || path[i] == '/') {
+            mkdir(path.substr(0, i).c_str(), 0755);
+        }
+    }
+}
+
+namespace {
+
+struct Writer {
+    FILE* f;
+
+    void raw(const void* p, size_t n) { fwrite(p, 1, n, f); }
+    void u32(uint32_t v) { raw(&v, sizeof(v)); }
+    void u64(uint64_t v) { raw(&v, sizeof(v)); }
+
+    void strings(const std::vector<std::string>& v) {
+        u32((uint32_t)v.size());
+        for (const std::string& s : v) {
+            u32((uint32_t)s.size());
+            raw(s.data(), s.size());
+        }
+    }
+
+    template <typename T>
+    void array(const std::vector<T>& v) {
+        u64(v.size());
+        raw(v.data(), v.size() * sizeof(T));
+    }
+};
+
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+
+    bool raw(void* dst, size_t n) {
+        if ((size_t)(end - p) < n) {
+            return false;
+        }
+        memcpy(dst, p, n);
+        p += n;
+        return true;
+    }
+
+    bool strings(std::vector<std::string>* v) {
+        uint32_t count;
+        if (!raw(&count, sizeof(count))) {
+            return false;
+        }
+        v->clear();
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t len;
+            if (!raw(&len, sizeof(len)) || (size_t)(end - p) < len) {
+                return false;
+            }
+            v->emplace_back((const char*)p, len);
+            p += len;
+        }
+        return true;
+    }
+
+    template <typename T>
+    bool array(std::vector<T>* v) {
+        uint64_t count;
+        if (!raw(&count, sizeof(count)) || count > (uint64_t)(end - p) / sizeof(T)) {
+            return false;
+        }
+        v->resize((size_t)count);
+        return raw(v->data(), (size_t)count * sizeof(T));
+    }
+};
+
+} // namespace
+
+bool Symbolizer::read_cache(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    std::vector<uint8_t> buf;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        buf.insert(buf.end(), chunk, chunk + n);
+    }
+    fclose(f);
+
+    Reader r{buf.data(), buf.data() + buf.size()};
+    char magic[8];
+    uint32_t version;
+    if (!r.raw(magic, sizeof(magic)) || memcmp(magic, kCacheMagic, sizeof(magic)) != 0 ||
+        !r.raw(&version, sizeof(version)) || version != kCacheVersion) {
+        return false;
+    }
+    if (!r.strings(&names_) || !r.strings(&files_) || !r.array(&funcs_) ||
+        !r.array(&symbols_) || !r.array(&rows_)) {
+        return false;
+    }
+
+    // Reject entries that index past the string tables
+    for (const Func& fn : funcs_) {
+        if (fn.name >= names_.size()) {
+            return false;
+        }
+    }
+    for (const Named& s : symbols_) {
+        if (s.name >= names_.size()) {
+            return false;
+        }
+    }
+    for (const LineRow& row : rows_) {
+        if (row.file != UINT32_MAX && row.file >= files_.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Symbolizer::write_cache(const std::string& path) const {
+    // Write to a temporary name and rename so readers never see partial files
+    std::string tmp = path + "." + std::to_string(getpid()) + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) {
+        return;
+    }
+    Writer w{f};
+    w.raw(kCacheMagic, sizeof(kCacheMagic));
+    w.u32(kCacheVersion);
+    w.strings(names_);
+    w.strings(files_);
+    w.array(funcs_);
+    w.array(symbols_);
+    w.array(rows_);
+    bool ok = ferror(f) == 0;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+    }
+}
+
+// ============================================================================
+// LOADING
+// ============================================================================
+
+int Symbolizer::load(const std::string& elf_path, bool use_cache) {
+    from_cache_ = false;
+    ElfFile elf;
+    if (elf.open(elf_path) != 0) {
+        error_ = elf.error();
+        return -1;
+    }
+
+    key_ = elf.build_id();
+    if (key_.empty()) {
+        char buf[40];
+        snprintf(buf, sizeof(buf), "nobuildid-%016llx", (unsigned long long)elf.content_hash());
+        key_ = buf;
+    }
+
+    std::string dir = use_cache ? cache_dir() : std::string();
+    std::string cache = dir.empty() ? std::string() : dir + "/" + key_ + ".symcache";
+    if (!cache.empty() && read_cache(cache)) {
+        from_cache_ = true;
+        index_symbols();
+        return 0;
+    }
+
+    LineTable lines;
+    if (read_line_table(elf, &lines, &error_) != 0) {
+        return -1;
+    }
+    build(elf, lines);
+    index_symbols();
+
+    if (!cache.empty()) {
+        make_dirs(dir);
+        write_cache(cache);
+    }
+    return 0;
+}
+
+} // namespace memsym
@@ -0,0 +1,111 @@
+/**
+ * @file symbolizer.h
+ * @brief Batch address-to-source resolution for the firmware ELF
+ *
+ * Loads an ELF once into two sorted tables - functions and DWARF line rows -
+ * and answers lookups by binary search, or for batches by a single merge
+ * sweep over the sorted query addresses. The decoded tables are cached under
+ * $XDG_CACHE_HOME/memsym (default ~/.cache/memsym), keyed by the GNU build ID
+ * (or a content hash for ELFs linked without one), so repeated runs over the
+ * same firmware skip DWARF decoding entirely.
+ *
+ * Addresses are flash byte addresses as printed by the firmware. Return
+ * addresses point behind the CALL; callers subtract 1 before resolving.
+ */
+
+#ifndef MEMSYM_SYMBOLIZER_H
+#define MEMSYM_SYMBOLIZER_H
+
+#include "dwarf_line.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace memsym {
+
+struct Location {
+    const char* function;  // nullptr if no function covers the address
+    uint64_t offset;       // Address - function start
+    const char* file;      // nullptr if there is no line information
+    uint32_t line;
+};
+
+struct SymbolInfo {
+    uint64_t addr;
+    uint64_t size;
+    uint8_t type;          // STT_*
+};
+
+class Symbolizer {
+public:
+    /**
+     * @brief Load symbol and line tables for an ELF
+     * @param use_cache Read/write the on-disk table cache
+     * @return 0 on success
+     */
+    int load(const std::string& elf_path, bool use_cache = true);
+
+    /**
+     * @brief Resolve one address
+     */
+    Location resolve(uint64_t addr) const;
+
+    /**
+     * @brief Resolve many addresses; out[i] corresponds to addrs[i]
+     */
+    void resolve_batch(const std::vector<uint64_t>& addrs, std::vector<Location>* out) const;
+
+    /**
+     * @brief Look up any defined symbol (functions and data) by name
+     * @return false if the ELF has no such symbol
+     */
+    bool lookup(const std::string& name, SymbolInfo* info) const;
+
+    /**
+     * @brief "func+0x12 (file.cpp:34)", or "0x1234" when nothing is known
+     */
+    std::string describe(uint64_t addr) const;
+
+    const std::string& cache_key() const { return key_; }
+    bool from_cache() const { return from_cache_; }
+    size_t function_count() const { return funcs_.size(); }
+    size_t line_count() const { return rows_.size(); }
+    const std::string& error() const { return error_; }
+
+private:
+    struct Func {
+        uint64_t addr;
+        uint64_t size;
+        uint32_t name;     // Index into names_
+    };
+
+    struct Named {
+        uint32_t name;
+        SymbolInfo info;
+    };
+
+    void build(const ElfFile& elf, const LineTable& lines);
+    void index_symbols();
+    bool read_cache(const std::string& path);
+    void write_cache(const std::string& path) const;
+
+    const Func* func_at(size_t i, uint64_t addr) const;
+    const LineRow* row_at(size_t i) const;
+    Location make_location(uint64_t addr, const Func* func, const LineRow* row) const;
+
+    std::vector<std::string> names_;
+    std::vector<Func> funcs_;              // Sorted by address
+    std::vector<Named> symbols_;
+    std::vector<LineRow> rows_;            // Sorted by address
+    std::vector<std::string> files_;
+    std::unordered_map<std::string, size_t> by_name_;
+    std::string key_;
+    bool from_cache_ = false;
+    std::string error_;
+};
+
+} // namespace memsym
+
+#endif // MEMSYM_SYMBOLIZER_H